@@ -0,0 +1,65 @@
+#ifndef JJ_BINARY_ENCODING_H
+#define JJ_BINARY_ENCODING_H
+
+#include "jj/string.h"
+#include <string>
+
+/*! The encoding of numbers and strings shared by the binary log (see jj/logBinary.h) and the binary props
+(see jj/propsBinary.h).
+A varint is an unsigned number stored by 7 bits per byte (least significant first, the highest bit set in all but
+the last byte), a signed varint is zig-zag encoded first. A string is its length (varint) followed by UTF-8 bytes.
+*/
+
+namespace jj
+{
+namespace binary
+{
+/*! Appends the number as varint. */
+inline void putVarint(std::string& out, unsigned long long v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+/*! Appends the number as signed varint. */
+inline void putSignedVarint(std::string& out, long long v) { putVarint(out, (static_cast<unsigned long long>(v) << 1) ^ static_cast<unsigned long long>(v >> 63)); }
+/*! Appends the string (length and the characters). */
+inline void putString(std::string& out, const char* s, size_t len)
+{
+    putVarint(out, len);
+    out.append(s, len);
+}
+/*! Appends the string (length and the characters converted to UTF-8). */
+inline void putString(std::string& out, const wchar_t* s, size_t len)
+{
+    std::string tmp(jj::strcvt::to_string(std::wstring(s, len)));
+    putString(out, tmp.c_str(), tmp.length());
+}
+/*! Appends the 0-terminated string. */
+template<typename CH>
+void putString(std::string& out, const CH* s) { putString(out, s, std::char_traits<CH>::length(s)); }
+
+/*! Reads a varint by bytes returned from byte() into v. Returns false if the number does not fit into 64 bits
+(the caller reports the error as its format requires). */
+template<typename BYTE>
+bool getVarint(BYTE byte, unsigned long long& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        unsigned char b = byte();
+        v |= static_cast<unsigned long long>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+/*! Returns the signed number of a zig-zag encoded varint. */
+inline long long unzigzag(unsigned long long v) { return static_cast<long long>(v >> 1) ^ -static_cast<long long>(v & 1); }
+} // namespace binary
+} // namespace jj
+
+#endif // JJ_BINARY_ENCODING_H
@@ -17,10 +17,20 @@ Define this to one of the log levels to override the default "hard" log level. *
 #ifndef JJ_LOGLIMIT_HARD
 #define JJ_LOGLIMIT_HARD JJ_LOGLEVEL_SCOPE
 #endif
+/*! JJ_LOG_DEFERRED_FORMAT
+Define this to 1 to make the default JJ_LOG_STREAM_PROVIDER only record the streamed values and format them when
+the message is delivered to the log targets. */
+#ifndef JJ_LOG_DEFERRED_FORMAT
+#define JJ_LOG_DEFERRED_FORMAT 0
+#endif
 /*! JJ_LOG_STREAM_PROVIDER
 Define this to an expression providing a "stream" to convert streamed values into a string. */
 #ifndef JJ_LOG_STREAM_PROVIDER
-#define JJ_LOG_STREAM_PROVIDER jj::log::simpleStreamProvider_t()
+#if JJ_LOG_DEFERRED_FORMAT
+#define JJ_LOG_STREAM_PROVIDER jj::log::deferredStreamProvider_t()
+#else
+#define JJ_LOG_STREAM_PROVIDER jj::log::threadStreamProvider_t()
+#endif
 #endif
 
 /*! No GUIs available. */
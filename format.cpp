@@ -0,0 +1,298 @@
+#include "jj/format.h"
+#include <cstring>
+
+namespace jj
+{
+namespace fmt
+{
+const char DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+namespace
+{
+typedef unsigned long long u64_t;
+
+/*! A floating point number as 64 bit mantissa and binary exponent (the value is F * 2^E). */
+struct diyfp_t
+{
+    u64_t F; //!< the mantissa
+    int E; //!< the exponent
+
+    diyfp_t(u64_t f, int e) : F(f), E(e) {}
+};
+
+/*! Returns the product of the two numbers (the upper 64 bits of the mantissa product, rounded). */
+diyfp_t multiply(const diyfp_t& x, const diyfp_t& y)
+{
+    const u64_t M32 = 0xFFFFFFFFULL;
+    u64_t a = x.F >> 32, b = x.F & M32, c = y.F >> 32, d = y.F & M32;
+    u64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    u64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32) + (1ULL << 31);
+    return diyfp_t(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.E + y.E + 64);
+}
+
+/*! Shifts the mantissa so that its highest bit is set. */
+diyfp_t normalize(diyfp_t v)
+{
+    while ((v.F & (1ULL << 63)) == 0)
+    {
+        v.F <<= 1;
+        --v.E;
+    }
+    return v;
+}
+
+/*! The powers of ten 10^-348, 10^-340, ..., 10^340 (normalized mantissas and binary exponents). */
+const u64_t POW10_F[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+    0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+    0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+    0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+    0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+    0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+    0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+    0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+    0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+    0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+    0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+    0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+    0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+    0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+    0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+const short POW10_E[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927, -901, -874, -847,
+    -821, -794, -768, -741, -715, -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183, -157, -130, -103, -77, -50,
+    -24, 3, 30, 56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747,
+    774, 800, 827, 853, 880, 907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+/*! The powers of ten fitting into 64 bits. */
+const u64_t POW10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+    10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/*! Returns the cached power of ten 10^-K which brings a number with the given binary exponent into a range where
+all the digits can be generated in 64 bit arithmetic. */
+diyfp_t cachedPower(int e, int& K)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347; // dk must be positive, so can do ceiling in positive
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0)
+        ++k;
+    unsigned index = static_cast<unsigned>((k >> 3) + 1);
+    K = -(-348 + static_cast<int>(index << 3));
+    return diyfp_t(POW10_F[index], POW10_E[index]);
+}
+
+/*! Moves the last generated digit closer to the exact value while it stays within the boundaries. */
+void round(char* buffer, int len, u64_t delta, u64_t rest, u64_t tenKappa, u64_t wpW)
+{
+    while (rest < wpW && delta - rest >= tenKappa && (rest + tenKappa < wpW || wpW - rest > rest + tenKappa - wpW))
+    {
+        --buffer[len - 1];
+        rest += tenKappa;
+    }
+}
+
+/*! Returns the number of decimal digits of the number. */
+int countDigits(unsigned n)
+{
+    int ret = 1;
+    while (ret < 10 && n >= POW10[ret])
+        ++ret;
+    return ret;
+}
+
+/*! Generates the digits of W (as few as possible to stay within delta below Mp) into the buffer. */
+void generateDigits(const diyfp_t& W, const diyfp_t& Mp, u64_t delta, char* buffer, int& len, int& K)
+{
+    const diyfp_t one(1ULL << -Mp.E, Mp.E);
+    const u64_t wpW = Mp.F - W.F;
+    unsigned p1 = static_cast<unsigned>(Mp.F >> -one.E);
+    u64_t p2 = Mp.F & (one.F - 1);
+    int kappa = countDigits(p1);
+    len = 0;
+    while (kappa > 0)
+    {
+        unsigned d = static_cast<unsigned>(p1 / POW10[kappa - 1]);
+        p1 = static_cast<unsigned>(p1 % POW10[kappa - 1]);
+        if (d != 0 || len != 0)
+            buffer[len++] = static_cast<char>('0' + d);
+        --kappa;
+        u64_t tmp = (static_cast<u64_t>(p1) << -one.E) + p2;
+        if (tmp <= delta)
+        {
+            K += kappa;
+            round(buffer, len, delta, tmp, POW10[kappa] << -one.E, wpW);
+            return;
+        }
+    }
+    while (true)
+    {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.E);
+        if (d != 0 || len != 0)
+            buffer[len++] = static_cast<char>('0' + d);
+        p2 &= one.F - 1;
+        --kappa;
+        if (p2 < delta)
+        {
+            K += kappa;
+            int index = -kappa;
+            round(buffer, len, delta, p2, one.F, wpW * (index < 20 ? POW10[index] : 0));
+            return;
+        }
+    }
+}
+
+/*! Generates the digits of the (positive) number f * 2^e, the value is digits * 10^K. The boundaries are halfway to the
+neighbouring numbers, lowerCloser tells that the lower neighbour is closer (the mantissa is a power of 2). */
+void grisu2(u64_t f, int e, bool lowerCloser, char* buffer, int& len, int& K)
+{
+    diyfp_t plus = normalize(diyfp_t((f << 1) + 1, e - 1));
+    diyfp_t minus = lowerCloser ? diyfp_t((f << 2) - 1, e - 2) : diyfp_t((f << 1) - 1, e - 1);
+    minus.F <<= minus.E - plus.E;
+    minus.E = plus.E;
+
+    const diyfp_t c = cachedPower(plus.E, K);
+    const diyfp_t W = multiply(normalize(diyfp_t(f, e)), c);
+    diyfp_t Wp = multiply(plus, c), Wm = multiply(minus, c);
+    ++Wm.F;
+    --Wp.F;
+    generateDigits(W, Wp, Wp.F - Wm.F, buffer, len, K);
+}
+
+/*! Writes the exponent of the scientific notation (sign and at least 2 digits). */
+char* writeExponent(int e, char* out)
+{
+    *out++ = e < 0 ? '-' : '+';
+    if (e < 0)
+        e = -e;
+    char buf[4];
+    char* b = formatUnsigned(static_cast<u64_t>(e), buf + sizeof(buf));
+    if (buf + sizeof(buf) - b < 2)
+        *out++ = '0';
+    while (b != buf + sizeof(buf))
+        *out++ = *b++;
+    return out;
+}
+
+/*! Writes the digits (the value is digits * 10^K) in the fixed or scientific notation. Returns the end of the text. */
+char* layout(const char* digits, int len, int K, char* out)
+{
+    const int point = len + K; // the position of the decimal point relative to the first digit
+    if (point > 17 || point < -4)
+    {
+        *out++ = digits[0];
+        if (len > 1)
+        {
+            *out++ = '.';
+            memcpy(out, digits + 1, len - 1);
+            out += len - 1;
+        }
+        *out++ = 'e';
+        return writeExponent(point - 1, out);
+    }
+    if (point >= len)
+    {
+        memcpy(out, digits, len);
+        out += len;
+        for (int i = len; i < point; ++i)
+            *out++ = '0';
+    }
+    else if (point > 0)
+    {
+        memcpy(out, digits, point);
+        out += point;
+        *out++ = '.';
+        memcpy(out, digits + point, len - point);
+        out += len - point;
+    }
+    else
+    {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = point; i < 0; ++i)
+            *out++ = '0';
+        memcpy(out, digits, len);
+        out += len;
+    }
+    return out;
+}
+
+/*! Formats the floating point number given by its sign, biased exponent and fraction bits. */
+size_t formatFloating(bool negative, unsigned exponent, u64_t fraction, unsigned maxExponent, int fractionBits, int bias, char* out)
+{
+    char* p = out;
+    if (exponent == maxExponent)
+    {
+        if (fraction != 0)
+        {
+            memcpy(p, "nan", 3);
+            return 3;
+        }
+        if (negative)
+            *p++ = '-';
+        memcpy(p, "inf", 3);
+        return (p - out) + 3;
+    }
+    if (negative)
+        *p++ = '-';
+    if (exponent == 0 && fraction == 0)
+    {
+        *p++ = '0';
+        return p - out;
+    }
+
+    u64_t f = fraction;
+    int e = 1 - bias - fractionBits;
+    if (exponent != 0)
+    {
+        f |= 1ULL << fractionBits;
+        e = static_cast<int>(exponent) - bias - fractionBits;
+    }
+    char digits[20];
+    int len = 0, K = 0;
+    grisu2(f, e, fraction == 0 && exponent > 1, digits, len, K);
+    return layout(digits, len, K, p) - out;
+}
+} // namespace <anonymous>
+
+size_t formatDouble(double v, char* out)
+{
+    u64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return formatFloating((bits >> 63) != 0, static_cast<unsigned>(bits >> 52) & 0x7FF, bits & ((1ULL << 52) - 1), 0x7FF, 52, 1023, out);
+}
+
+size_t formatFloat(float v, char* out)
+{
+    unsigned bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return formatFloating((bits >> 31) != 0, (bits >> 23) & 0xFF, bits & ((1U << 23) - 1), 0xFF, 23, 127, out);
+}
+
+} // namespace fmt
+} // namespace jj
@@ -0,0 +1,267 @@
+#ifndef JJ_FORMAT_H
+#define JJ_FORMAT_H
+
+#include "jj/string.h"
+#include <string>
+#include <ostream>
+#include <streambuf>
+#include <memory>
+
+/*! Fast number to text conversion
+Converts numbers to text without the locale and stream machinery - integers using a table of digit pairs, floating point
+numbers as the (nearly always) shortest text which reads back to the same value (Grisu2). basicBuilder_t puts it behind the usual <<
+chaining syntax, everything it does not format itself (and everything after a manipulator changed the format) goes
+through a regular stream, so it can replace a string stream.
+Note that the floating point numbers are not rounded to 6 significant digits as the streams do by default. */
+
+namespace jj
+{
+namespace fmt
+{
+/*! The space big enough for any number formatted by the functions below. */
+const size_t MAX_NUMBER = 32;
+
+/*! The two digit representations of 0 to 99 ("00010203...99"). */
+extern const char DIGIT_PAIRS[201];
+
+/*! Writes the decimal digits of the number so that the last one is just before end. Returns the first written character. */
+template<typename CH>
+CH* formatUnsigned(unsigned long long v, CH* end)
+{
+    while (v >= 100)
+    {
+        const char* d = DIGIT_PAIRS + (v % 100) * 2;
+        v /= 100;
+        *--end = static_cast<CH>(d[1]);
+        *--end = static_cast<CH>(d[0]);
+    }
+    if (v >= 10)
+    {
+        const char* d = DIGIT_PAIRS + v * 2;
+        *--end = static_cast<CH>(d[1]);
+        *--end = static_cast<CH>(d[0]);
+    }
+    else
+    {
+        *--end = static_cast<CH>('0' + v);
+    }
+    return end;
+}
+
+/*! Writes the number (with a minus sign if negative) so that the last character is just before end. Returns the first
+written character. */
+template<typename CH>
+CH* formatSigned(long long v, CH* end)
+{
+    if (v >= 0)
+        return formatUnsigned(static_cast<unsigned long long>(v), end);
+    end = formatUnsigned(0ULL - static_cast<unsigned long long>(v), end);
+    *--end = static_cast<CH>('-');
+    return end;
+}
+
+/*! Writes a text which reads back as the same double (at most MAX_NUMBER characters, not 0-terminated). The text is
+the shortest possible one in nearly all cases (the Grisu2 algorithm can give a digit more in rare cases). Uses the fixed notation for the decimal exponents from -5 to 16, the scientific notation (like 1.5e+20) otherwise.
+Returns the number of written characters. */
+size_t formatDouble(double v, char* out);
+/*! Same as formatDouble(), just the text reads back as the same float. */
+size_t formatFloat(float v, char* out);
+
+namespace aux
+{
+/*! A stream buffer appending everything written into it to a string. */
+template<typename CH>
+class appendStreambuf_t : public std::basic_streambuf<CH>
+{
+    typedef std::basic_streambuf<CH> parent_t;
+    std::basic_string<CH>* buf_; //!< where to append
+public:
+    appendStreambuf_t() : buf_(nullptr) {}
+    /*! Sets the string to append to. */
+    void set(std::basic_string<CH>* buf) { buf_ = buf; }
+protected:
+    virtual typename parent_t::int_type overflow(typename parent_t::int_type ch) override
+    {
+        if (!parent_t::traits_type::eq_int_type(ch, parent_t::traits_type::eof()))
+            buf_->push_back(parent_t::traits_type::to_char_type(ch));
+        return parent_t::traits_type::not_eof(ch);
+    }
+    virtual std::streamsize xsputn(const CH* s, std::streamsize n) override
+    {
+        buf_->append(s, static_cast<size_t>(n));
+        return n;
+    }
+};
+} // namespace aux
+
+/*! Builds a string from the values given by <<, a faster replacement of a string stream. Integers, floating point
+numbers, booleans, characters and strings are formatted directly, other values (and all values while a manipulator
+changed the format flags, width or precision) go through a stream writing into the same string - created on first need. */
+template<typename CH>
+class basicBuilder_t
+{
+public:
+    typedef std::basic_string<CH> string_t;
+
+private:
+    /*! The stream used for the values not formatted directly. */
+    struct fallback_t
+    {
+        aux::appendStreambuf_t<CH> Buf; //!< appends to the text of the builder
+        std::basic_ostream<CH> Out; //!< the stream
+        const std::ios_base::fmtflags Flags; //!< the initial format flags
+        const CH Fill; //!< the initial fill character
+
+        fallback_t(string_t& text) : Out(&Buf), Flags(Out.flags()), Fill(Out.fill()) { Buf.set(&text); }
+    };
+
+    string_t text_; //!< the built text
+    std::unique_ptr<fallback_t> fb_; //!< the stream (nullptr until needed)
+
+    /*! Returns true if the values can be formatted directly (no format flags changed by manipulators). */
+    bool plain() const { return !fb_ || (fb_->Out.flags() == fb_->Flags && fb_->Out.width() == 0 && fb_->Out.precision() == 6); }
+    /*! Appends the unsigned number. */
+    template<typename T>
+    basicBuilder_t& putUnsigned(T v)
+    {
+        if (!plain())
+        {
+            fb_->Out << v;
+            return *this;
+        }
+        CH buf[MAX_NUMBER];
+        CH* b = formatUnsigned(static_cast<unsigned long long>(v), buf + MAX_NUMBER);
+        text_.append(b, static_cast<size_t>(buf + MAX_NUMBER - b));
+        return *this;
+    }
+    /*! Appends the signed number. */
+    template<typename T>
+    basicBuilder_t& putSigned(T v)
+    {
+        if (!plain())
+        {
+            fb_->Out << v;
+            return *this;
+        }
+        CH buf[MAX_NUMBER];
+        CH* b = formatSigned(static_cast<long long>(v), buf + MAX_NUMBER);
+        text_.append(b, static_cast<size_t>(buf + MAX_NUMBER - b));
+        return *this;
+    }
+    /*! Appends the floating point number formatted into the given buffer. */
+    template<typename T>
+    basicBuilder_t& putFloating(T v, size_t (*format)(T, char*))
+    {
+        if (!plain())
+        {
+            fb_->Out << v;
+            return *this;
+        }
+        char buf[MAX_NUMBER];
+        size_t len = format(v, buf);
+        text_.append(buf, buf + len);
+        return *this;
+    }
+
+public:
+    /*! Returns the stream writing into the text (use it to apply formatting explicitly). */
+    std::basic_ostream<CH>& stream()
+    {
+        if (!fb_)
+            fb_.reset(new fallback_t(text_));
+        return fb_->Out;
+    }
+
+    basicBuilder_t& operator<<(short v) { return putSigned(v); }
+    basicBuilder_t& operator<<(unsigned short v) { return putUnsigned(v); }
+    basicBuilder_t& operator<<(int v) { return putSigned(v); }
+    basicBuilder_t& operator<<(unsigned int v) { return putUnsigned(v); }
+    basicBuilder_t& operator<<(long v) { return putSigned(v); }
+    basicBuilder_t& operator<<(unsigned long v) { return putUnsigned(v); }
+    basicBuilder_t& operator<<(long long v) { return putSigned(v); }
+    basicBuilder_t& operator<<(unsigned long long v) { return putUnsigned(v); }
+    basicBuilder_t& operator<<(double v) { return putFloating(v, &formatDouble); }
+    basicBuilder_t& operator<<(float v) { return putFloating(v, &formatFloat); }
+    basicBuilder_t& operator<<(bool v)
+    {
+        if (!plain())
+            fb_->Out << v;
+        else
+            text_.push_back(static_cast<CH>(v ? '1' : '0'));
+        return *this;
+    }
+    basicBuilder_t& operator<<(CH v)
+    {
+        if (!plain())
+            fb_->Out << v;
+        else
+            text_.push_back(v);
+        return *this;
+    }
+    basicBuilder_t& operator<<(const CH* v) { return append(v, std::char_traits<CH>::length(v)); }
+    basicBuilder_t& operator<<(CH* v) { return append(v, std::char_traits<CH>::length(v)); }
+    basicBuilder_t& operator<<(const string_t& v) { return append(v.c_str(), v.length()); }
+    basicBuilder_t& operator<<(std::basic_ostream<CH>& (*m)(std::basic_ostream<CH>&))
+    {
+        stream() << m;
+        return *this;
+    }
+    basicBuilder_t& operator<<(std::basic_ios<CH>& (*m)(std::basic_ios<CH>&))
+    {
+        stream() << m;
+        return *this;
+    }
+    basicBuilder_t& operator<<(std::ios_base& (*m)(std::ios_base&))
+    {
+        stream() << m;
+        return *this;
+    }
+    /*! Any other value is written into the stream. */
+    template<typename V>
+    basicBuilder_t& operator<<(const V& v)
+    {
+        stream() << v;
+        return *this;
+    }
+
+    /*! Appends len characters of the given string (same as << of a string). */
+    basicBuilder_t& append(const CH* s, size_t len)
+    {
+        if (!plain())
+            fb_->Out << string_t(s, len);
+        else
+            text_.append(s, len);
+        return *this;
+    }
+
+    /*! Returns the text built so far. */
+    const string_t& text() const { return text_; }
+    /*! Moves the built text out of the builder (which becomes empty). */
+    string_t str()
+    {
+        string_t ret(std::move(text_));
+        text_.clear();
+        return ret;
+    }
+    /*! Empties the text and resets the format of the stream (if used), so the builder can be reused. */
+    void clear()
+    {
+        text_.clear();
+        if (fb_)
+        {
+            fb_->Out.clear();
+            fb_->Out.flags(fb_->Flags);
+            fb_->Out.width(0);
+            fb_->Out.precision(6);
+            fb_->Out.fill(fb_->Fill);
+        }
+    }
+};
+
+/*! The builder of the system native strings. */
+typedef basicBuilder_t<jj::char_t> builder_t;
+
+} // namespace fmt
+} // namespace jj
+
+#endif // JJ_FORMAT_H
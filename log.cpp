@@ -1,7 +1,25 @@
 #include "jj/log.h"
 #include "jj/stream.h"
 #include "jj/time.h"
+#include "jj/mpscQueue.h"
 #include <iostream>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#if defined(JJ_OS_WINDOWS)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#endif
 
 JJ_DECLARE_LOG_COMPONENT2(jjMainLog, "<main>");
 jj::log::component_t& jjTheLogComponent = jjMainLogComponent_t::instance();
@@ -14,7 +32,9 @@ namespace log
 template<typename S>
 void logToStream(S& s, const message_t& log)
 {
-    s << jj::time::stamp_t(log.Time) << jjT(' ') << jjT('[') << log.LevelName << jjT(']') << jjT(' ') << log.Message << jjT('\n');
+    jj::char_t stamp[jj::time::stampFormatter_t<jj::char_t>::MAX_LENGTH];
+    s.write(stamp, jj::time::threadStampFormatter<jj::char_t>().format(log.Time, stamp));
+    s << jjT(' ') << jjT('[') << log.LevelName << jjT(']') << jjT(' ') << log.Message << jjT('\n');
 }
 
 void stdoutTarget_t::log(const message_t& log)
@@ -27,6 +47,977 @@ void stderrTarget_t::log(const message_t& log)
     logToStream(jj::cerr, log);
 }
 
+namespace aux
+{
+std::atomic<level_t> detailLevel(JJ_LOGLEVEL_OFF);
+thread_local armedSite_t armedSite;
+
+/*! The rate limiting state of one log level of a component. The settings are atomic too, so they can be
+changed while other threads log (a message might see a mix of the previous and the new settings). */
+struct levelLimit_t
+{
+    std::atomic<bool> Used; //!< set once the slot is assigned to a level
+    std::atomic<level_t> Level; //!< the limited log level
+    std::atomic<unsigned> Sample; //!< every Sample-th message passes (0 or 1 = all)
+    std::atomic<long long> Interval; //!< the time (ns) to generate one token (0 = no rate limiting)
+    std::atomic<long long> Tolerance; //!< how far ahead of now (ns) Tat may get = (Burst - 1) * Interval
+    std::atomic<long long> ReportInterval; //!< the minimal time (ns) between two summaries
+    std::atomic<long long> Tat; //!< the time (ns) at which the token bucket gets "empty" (GCRA theoretical arrival time)
+    std::atomic<unsigned long long> Seen; //!< the number of messages seen (for sampling)
+    std::atomic<unsigned long long> Pending; //!< the number of messages suppressed since the last summary
+    std::atomic<unsigned long long> Total; //!< the number of messages suppressed overall
+    std::atomic<long long> LastReport; //!< the time (ns) of the last summary
+};
+
+/*! The rate limits of a component. The slots are assigned in order and never released. */
+struct rateLimits_t
+{
+    static const size_t MAX_LEVELS = 8; //!< the maximum number of limited levels per component
+    levelLimit_t Levels[MAX_LEVELS]; //!< the slots
+
+    /*! Returns the slot of the given level or nullptr if the level is not limited. */
+    levelLimit_t* find(level_t level)
+    {
+        for (size_t i = 0; i < MAX_LEVELS && Levels[i].Used.load(std::memory_order_acquire); ++i)
+            if (Levels[i].Level.load(std::memory_order_relaxed) == level)
+                return &Levels[i];
+        return nullptr;
+    }
+};
+} // namespace aux
+
+namespace
+{
+/*! Returns the current time in ns for the purpose of the rate limits. */
+long long limitNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // namespace <anonymous>
+
+namespace
+{
+std::atomic<site_t*> siteHead(nullptr); //!< the most recently registered site
+} // namespace <anonymous>
+
+site_t::site_t(level_t level, levelName_t levelName, const char* func, const char* file, int line, component_t& component)
+    : file_(file), function_(func), line_(line), level_(level), levelName_(levelName), component_(component), mode_(DEFAULT), next_(siteHead.load())
+{
+    while (!siteHead.compare_exchange_weak(next_, this))
+        ;
+}
+
+site_t* site_t::first()
+{
+    return siteHead.load();
+}
+
+size_t site_t::setMode(const char* file, int line, mode_t mode)
+{
+    size_t flen = strlen(file), ret = 0;
+    for (site_t* s = first(); s != nullptr; s = s->next())
+    {
+        if (line != 0 && s->line() != line)
+            continue;
+        size_t len = strlen(s->file());
+        if (len < flen || strcmp(s->file() + len - flen, file) != 0)
+            continue;
+        s->setMode(mode);
+        ++ret;
+    }
+    return ret;
+}
+
+namespace
+{
+std::atomic<component_t*> componentHead(nullptr); //!< the most recently registered component
+std::mutex componentLock; //!< serializes the changes of the list of components
+
+/*! Returns the string with lowercase ASCII letters converted to uppercase. */
+jj::string_t upper(jj::string_t s)
+{
+    for (jj::char_t& ch : s)
+        if (ch >= jjT('a') && ch <= jjT('z'))
+            ch = ch - jjT('a') + jjT('A');
+    return s;
+}
+
+/*! Returns the string without the leading and trailing whitespace. */
+jj::string_t trim(const jj::string_t& s)
+{
+    size_t b = s.find_first_not_of(jjT(" \t")), e = s.find_last_not_of(jjT(" \t"));
+    return b == jj::string_t::npos ? jj::string_t() : s.substr(b, e - b + 1);
+}
+
+/*! Converts the level name (or number) into the level. */
+level_t parseLevel(const jj::string_t& s)
+{
+    static const struct { const jj::char_t* Name; level_t Level; } names[] = {
+        { jjT("FATAL"), JJ_LOGLEVEL_FATAL }, { jjT("ERROR"), JJ_LOGLEVEL_ERROR }, { jjT("ALERT"), JJ_LOGLEVEL_ALERT },
+        { jjT("WARN"), JJ_LOGLEVEL_WARNING }, { jjT("WARNING"), JJ_LOGLEVEL_WARNING }, { jjT("INFO"), JJ_LOGLEVEL_INFO },
+        { jjT("VERB"), JJ_LOGLEVEL_VERBOSE }, { jjT("VERBOSE"), JJ_LOGLEVEL_VERBOSE }, { jjT("SCOPE"), JJ_LOGLEVEL_SCOPE },
+        { jjT("DEBUG"), JJ_LOGLEVEL_DEBUG }, { jjT("OFF"), JJ_LOGLEVEL_OFF } };
+    jj::string_t u(upper(s));
+    for (auto& n : names)
+        if (u == n.Name)
+            return n.Level;
+    if (!u.empty() && u.find_first_not_of(jjT("0123456789")) == jj::string_t::npos)
+    {
+        unsigned long long v = std::stoull(u);
+        if (v <= std::numeric_limits<level_t>::max())
+            return static_cast<level_t>(v);
+    }
+    throw std::runtime_error(jj::strcvt::to_string(jjS(jjT("Invalid log level '") << s << jjT("'."))));
+}
+} // namespace <anonymous>
+
+component_t::component_t(const jj::char_t* id, const jj::char_t* displayName)
+    : id_(id), name_(displayName), level_(0), detail_(JJ_LOGLEVEL_OFF), limits_(nullptr), next_(nullptr)
+{
+    setLevel(JJ_LOGLEVEL_INFO);
+    std::lock_guard<std::mutex> guard(componentLock);
+    // under the lock, so either this or logger_t::swapTargets() sets the level for the current targets
+    detail_.store(aux::detailLevel.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    next_.store(componentHead.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    componentHead.store(this, std::memory_order_release);
+}
+
+component_t::~component_t()
+{
+    {
+        std::lock_guard<std::mutex> guard(componentLock);
+        std::atomic<component_t*>* prev = &componentHead;
+        for (component_t* c = prev->load(); c != nullptr; prev = &c->next_, c = prev->load())
+        {
+            if (c == this)
+            {
+                prev->store(next_.load(), std::memory_order_release);
+                break;
+            }
+        }
+    }
+    delete limits_.load();
+}
+
+component_t* component_t::first()
+{
+    return componentHead.load(std::memory_order_acquire);
+}
+
+component_t* component_t::find(const jj::char_t* id)
+{
+    for (component_t* c = first(); c != nullptr; c = c->next())
+        if (std::char_traits<jj::char_t>::length(id) == std::char_traits<jj::char_t>::length(c->id())
+            && std::char_traits<jj::char_t>::compare(id, c->id(), std::char_traits<jj::char_t>::length(id)) == 0)
+            return c;
+    return nullptr;
+}
+
+size_t component_t::configure(const jj::string_t& settings)
+{
+    std::vector<std::pair<component_t*, level_t>> changes;
+    size_t pos = 0;
+    while (pos <= settings.length())
+    {
+        size_t end = settings.find(jjT(','), pos);
+        if (end == jj::string_t::npos)
+            end = settings.length();
+        jj::string_t item(trim(settings.substr(pos, end - pos)));
+        pos = end + 1;
+        if (item.empty())
+            continue;
+        size_t eq = item.find(jjT('='));
+        if (eq == jj::string_t::npos)
+            throw std::runtime_error(jj::strcvt::to_string(jjS(jjT("Missing '=' in log level setting '") << item << jjT("'."))));
+        jj::string_t id(trim(item.substr(0, eq)));
+        level_t level = parseLevel(trim(item.substr(eq + 1)));
+        if (id == jjT("*"))
+        {
+            for (component_t* c = first(); c != nullptr; c = c->next())
+                changes.push_back(std::make_pair(c, level));
+            continue;
+        }
+        component_t* c = find(id.c_str());
+        if (c == nullptr)
+            throw std::runtime_error(jj::strcvt::to_string(jjS(jjT("Unknown log component '") << id << jjT("'."))));
+        changes.push_back(std::make_pair(c, level));
+    }
+    for (auto& ch : changes)
+        ch.first->setLevel(ch.second);
+    return changes.size();
+}
+
+bool component_t::admitLimited(aux::rateLimits_t& limits, level_t level, levelName_t levelName, const char* func, const char* file, int line)
+{
+    aux::levelLimit_t* l = limits.find(level);
+    if (l == nullptr)
+        return true;
+
+    unsigned sample = l->Sample.load(std::memory_order_relaxed);
+    bool pass = (sample <= 1 || l->Seen.fetch_add(1, std::memory_order_relaxed) % sample == 0);
+    long long now = limitNow();
+    long long interval = l->Interval.load(std::memory_order_relaxed);
+    if (pass && interval > 0)
+    {
+        // token bucket as GCRA - a single CAS on the time the bucket gets empty
+        long long tolerance = l->Tolerance.load(std::memory_order_relaxed);
+        long long tat = l->Tat.load(std::memory_order_relaxed);
+        while (true)
+        {
+            long long start = (tat < now ? now : tat);
+            if (start - now > tolerance)
+            {
+                pass = false;
+                break;
+            }
+            if (l->Tat.compare_exchange_weak(tat, start + interval, std::memory_order_relaxed))
+                break;
+        }
+    }
+    if (!pass)
+    {
+        l->Pending.fetch_add(1, std::memory_order_relaxed);
+        l->Total.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (l->Pending.load(std::memory_order_relaxed) != 0)
+    {
+        long long last = l->LastReport.load(std::memory_order_relaxed);
+        if (now - last >= l->ReportInterval.load(std::memory_order_relaxed) && l->LastReport.compare_exchange_strong(last, now, std::memory_order_relaxed))
+        {
+            unsigned long long cnt = l->Pending.exchange(0, std::memory_order_relaxed);
+            if (cnt != 0)
+                logger_t::instance().log(message_t(clock_t::now(), level, levelName,
+                    jjT("suppressed ") + jj::strcvt::to_string_t(std::to_string(cnt)) + jjT(" messages"), func, file, line, *this));
+        }
+    }
+    return true;
+}
+
+void component_t::setRateLimit(level_t level, const rateLimit_t& limit)
+{
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    aux::rateLimits_t* limits = limits_.load(std::memory_order_acquire);
+    if (limits == nullptr)
+    {
+        limits = new aux::rateLimits_t();
+        limits_.store(limits, std::memory_order_release);
+    }
+    aux::levelLimit_t* l = limits->find(level);
+    bool added = false;
+    if (l == nullptr)
+    {
+        for (size_t i = 0; i < aux::rateLimits_t::MAX_LEVELS && l == nullptr; ++i)
+            if (!limits->Levels[i].Used.load(std::memory_order_relaxed))
+                l = &limits->Levels[i];
+        if (l == nullptr)
+            throw std::runtime_error("Too many rate limited levels in a log component.");
+        added = true;
+    }
+
+    long long interval = 0;
+    if (limit.Rate > 0)
+    {
+        interval = static_cast<long long>(1e9 / limit.Rate);
+        if (interval == 0)
+            interval = 1;
+    }
+    l->Sample.store(limit.Sample, std::memory_order_relaxed);
+    l->Interval.store(interval, std::memory_order_relaxed);
+    l->Tolerance.store((limit.Burst == 0 ? 0 : limit.Burst - 1) * interval, std::memory_order_relaxed);
+    l->ReportInterval.store(std::chrono::duration_cast<std::chrono::nanoseconds>(limit.ReportInterval).count(), std::memory_order_relaxed);
+    l->Tat.store(0, std::memory_order_relaxed);
+    if (added)
+    {
+        l->Level.store(level, std::memory_order_relaxed);
+        l->Used.store(true, std::memory_order_release);
+    }
+}
+
+unsigned long long component_t::suppressed(level_t level) const
+{
+    aux::rateLimits_t* limits = limits_.load(std::memory_order_acquire);
+    aux::levelLimit_t* l = (limits == nullptr ? nullptr : limits->find(level));
+    return l == nullptr ? 0 : l->Total.load(std::memory_order_relaxed);
+}
+
+namespace aux
+{
+/*! The builder reused by threadStreamProvider_t. */
+struct threadStream_t
+{
+    jj::fmt::builder_t Builder; //!< formats the text
+    bool InUse; //!< set while used by a provider
+    bool Owned; //!< set if this is not the builder of a thread (but one created for the nested use)
+
+    threadStream_t(bool owned) : InUse(false), Owned(owned) {}
+};
+
+namespace
+{
+thread_local threadStream_t threadStream(false);
+} // namespace <anonymous>
+
+threadStream_t* acquireThreadStream()
+{
+    threadStream_t* s = &threadStream;
+    if (s->InUse)
+        s = new threadStream_t(true);
+    s->InUse = true;
+    s->Builder.clear();
+    return s;
+}
+
+void releaseThreadStream(threadStream_t* s)
+{
+    if (s->Owned)
+    {
+        delete s;
+        return;
+    }
+    s->InUse = false;
+    if (s->Builder.text().capacity() > 65536)
+        s->Builder.str(); // do not keep the memory after an exceptionally long message (the text is moved out and dropped)
+}
+
+jj::fmt::builder_t& threadStreamOut(threadStream_t* s)
+{
+    return s->Builder;
+}
+
+text_t threadStreamText(threadStream_t* s)
+{
+    return text_t(s->Builder.text().c_str(), s->Builder.text().length());
+}
+} // namespace aux
+
+textEncoder_t::textEncoder_t()
+    : sbuf_(new jj::fmt::aux::appendStreambuf_t<jj::char_t>()), stream_(new jj::ostream_t(sbuf_.get()))
+{
+}
+
+textEncoder_t::~textEncoder_t()
+{
+}
+
+void textEncoder_t::encode(const message_t& msg, std::string& out)
+{
+#if defined(JJ_USE_WSTRING)
+    line_.clear();
+    sbuf_->set(&line_);
+    logToStream(*stream_, msg);
+    out += jj::strcvt::to_string(line_);
+#else
+    sbuf_->set(&out);
+    logToStream(*stream_, msg);
+#endif
+}
+
+namespace aux
+{
+/*! The implementation of the fileTarget_t. The logging threads only append to the active buffer, the writer thread
+swaps the buffers and does all the I/O (writing, rotation). */
+class fileWriter_t
+{
+    typedef std::string buffer_t; //!< holds the encoded lines not written yet
+
+    const jj::string_t path_; //!< the file name
+    const fileTarget_t::options_t opts_; //!< the settings
+
+    std::mutex bufLock_; //!< guards the members up to done_ and the encoder
+    buffer_t bufs_[2]; //!< the two buffers
+    buffer_t* active_; //!< the buffer collecting the new lines
+    std::shared_ptr<fileEncoder_base_t> encoder_; //!< converts the messages into bytes
+    bool full_; //!< set when the active buffer filled up and the writer was woken up
+    bool stop_; //!< set when the writer thread shall finish
+    unsigned long long requested_; //!< the number of flush() calls so far
+    unsigned long long written_; //!< the value of requested_ the last written batch was taken at
+    std::condition_variable wake_; //!< wakes up the writer thread
+    std::condition_variable done_; //!< wakes up the threads waiting in flush()
+
+    // used only by the writer thread (and by the ctor before it starts)
+    buffer_t* spare_; //!< the buffer being written (empty otherwise)
+    int fd_; //!< the open file
+    unsigned long long size_; //!< the current size of the file
+    unsigned long long opened_; //!< the size of the file once opened (with the header)
+    std::chrono::system_clock::time_point rotateAt_; //!< when to rotate by time
+    std::atomic<size_t> rotations_; //!< the number of rotations done
+    std::thread thread_; //!< the writer thread
+
+    /*! Returns the name of the index-th backup of the file. */
+    jj::string_t backupName(unsigned index) const { return path_ + jjT('.') + jj::strcvt::to_string_t(std::to_string(index)); }
+
+    /*! Opens the file for appending, throws on failure. */
+    void open()
+    {
+#if defined(JJ_OS_WINDOWS)
+        fd_ = _wopen(path_.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        if (fd_ < 0)
+            throw std::runtime_error(strcvt::to_string(jjS(jjT("Cannot open log file '") << path_ << jjT("'."))));
+#if defined(JJ_OS_WINDOWS)
+        long long sz = _lseeki64(fd_, 0, SEEK_END);
+#else
+        off_t sz = lseek(fd_, 0, SEEK_END);
+#endif
+        size_ = sz < 0 ? 0 : static_cast<unsigned long long>(sz);
+        if (opts_.Interval.count() > 0)
+            rotateAt_ = std::chrono::system_clock::now() + opts_.Interval;
+        if (size_ == 0)
+        {
+            std::string hdr;
+            encoder_->header(hdr);
+            writeBytes(hdr.c_str(), hdr.length(), false);
+        }
+        opened_ = size_;
+    }
+    /*! Closes the file (if open). */
+    void close()
+    {
+        if (fd_ < 0)
+            return;
+#if defined(JJ_OS_WINDOWS)
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+        fd_ = -1;
+    }
+    /*! Renames/removes a file, ignores errors. */
+    static void move(const jj::string_t& from, const jj::string_t* to)
+    {
+#if defined(JJ_OS_WINDOWS)
+        if (to == nullptr)
+            _wremove(from.c_str());
+        else
+        {
+            _wremove(to->c_str());
+            _wrename(from.c_str(), to->c_str());
+        }
+#else
+        if (to == nullptr)
+            std::remove(from.c_str());
+        else
+            std::rename(from.c_str(), to->c_str());
+#endif
+    }
+    /*! Closes the file, shifts the backups and opens a new file. */
+    void rotate()
+    {
+        close();
+        if (opts_.Backups == 0)
+        {
+            move(path_, nullptr);
+        }
+        else
+        {
+            move(backupName(opts_.Backups), nullptr);
+            for (unsigned i = opts_.Backups - 1; i > 0; --i)
+            {
+                jj::string_t to(backupName(i + 1));
+                move(backupName(i), &to);
+            }
+            jj::string_t to(backupName(1));
+            move(path_, &to);
+        }
+        ++rotations_;
+        try
+        {
+            std::lock_guard<std::mutex> l(bufLock_); // for the header
+            open();
+        }
+        catch (...)
+        {
+            fd_ = -1; // nowhere to report it, the lines get lost until next rotation
+        }
+    }
+    /*! Writes the given bytes into the file (rotating it first if needed and allowed). */
+    void writeBytes(const char* data, size_t len, bool canRotate = true)
+    {
+        if (len == 0)
+            return;
+        if (canRotate && ((opts_.MaxSize != 0 && size_ != 0 && size_ + len > opts_.MaxSize)
+            || (opts_.Interval.count() > 0 && std::chrono::system_clock::now() >= rotateAt_)))
+            rotate();
+        if (fd_ < 0)
+            return;
+        while (len > 0)
+        {
+#if defined(JJ_OS_WINDOWS)
+            int w = _write(fd_, data, static_cast<unsigned>(len > INT_MAX ? INT_MAX : len));
+#else
+            ssize_t w = ::write(fd_, data, len);
+            if (w < 0 && errno == EINTR)
+                continue;
+#endif
+            if (w <= 0)
+                return;
+            data += w;
+            len -= static_cast<size_t>(w);
+            size_ += static_cast<unsigned long long>(w);
+        }
+    }
+    /*! Returns how long the writer thread may sleep - until the idle flush or the rotation by time. */
+    std::chrono::system_clock::duration sleepTime() const
+    {
+        std::chrono::system_clock::duration ret = opts_.FlushInterval.count() > 0 ? std::chrono::system_clock::duration(opts_.FlushInterval) : std::chrono::system_clock::duration(std::chrono::hours(24));
+        if (opts_.Interval.count() > 0 && fd_ >= 0)
+        {
+            std::chrono::system_clock::duration rot = rotateAt_ - std::chrono::system_clock::now();
+            if (rot < ret)
+                ret = rot < std::chrono::system_clock::duration::zero() ? std::chrono::system_clock::duration::zero() : rot;
+        }
+        return ret;
+    }
+    /*! The body of the writer thread - writes out the active buffer whenever it fills up, flush() is called or the
+    flush interval passes, rotates the file by time even if nothing is logged. */
+    void run()
+    {
+        std::unique_lock<std::mutex> l(bufLock_);
+        while (true)
+        {
+            if (!stop_ && !full_ && requested_ == written_)
+                wake_.wait_for(l, sleepTime(), [this]() { return stop_ || full_ || requested_ != written_; });
+            bool stop = stop_;
+            unsigned long long request = requested_;
+            full_ = false;
+            std::swap(active_, spare_);
+            l.unlock();
+            std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+            if (opts_.Interval.count() > 0 && fd_ >= 0 && now >= rotateAt_)
+            {
+                if (size_ > opened_)
+                    rotate();
+                else
+                    rotateAt_ = now + opts_.Interval; // nothing written in this period, no need for an empty backup
+            }
+            writeBytes(spare_->c_str(), spare_->length());
+            spare_->clear();
+            l.lock();
+            written_ = request;
+            done_.notify_all();
+            if (stop)
+                break;
+        }
+    }
+
+public:
+    /*! Ctor - opens the file. */
+    fileWriter_t(const jj::string_t& path, const fileTarget_t::options_t& options, std::shared_ptr<fileEncoder_base_t> encoder)
+        : path_(path), opts_(options), active_(&bufs_[0]), encoder_(encoder ? encoder : std::make_shared<textEncoder_t>()), full_(false), stop_(false),
+        requested_(0), written_(0), spare_(&bufs_[1]), fd_(-1), size_(0), opened_(0), rotations_(0)
+    {
+        bufs_[0].reserve(opts_.BufferSize + opts_.BufferSize / 4);
+        bufs_[1].reserve(opts_.BufferSize + opts_.BufferSize / 4);
+        open();
+        thread_ = std::thread([this]() { run(); });
+    }
+    /*! Dtor - writes out what is buffered, stops the writer thread and closes the file. */
+    ~fileWriter_t()
+    {
+        {
+            std::lock_guard<std::mutex> l(bufLock_);
+            stop_ = true;
+            wake_.notify_one();
+        }
+        thread_.join();
+        close();
+    }
+
+    /*! Formats the message into the buffer, hands the buffer over to the writer thread if full. */
+    void log(const message_t& msg)
+    {
+        std::lock_guard<std::mutex> l(bufLock_);
+        encoder_->encode(msg, *active_);
+        if (!full_ && active_->length() >= opts_.BufferSize)
+        {
+            full_ = true;
+            wake_.notify_one();
+        }
+    }
+    /*! Waits until everything buffered so far is written. */
+    void flush()
+    {
+        std::unique_lock<std::mutex> l(bufLock_);
+        unsigned long long request = ++requested_;
+        wake_.notify_one();
+        done_.wait(l, [this, request]() { return written_ >= request; });
+    }
+    /*! Returns the number of rotations done so far. */
+    size_t rotations() const { return rotations_.load(); }
+};
+} // namespace aux
+
+fileTarget_t::fileTarget_t(const jj::string_t& path, const options_t& options, std::shared_ptr<fileEncoder_base_t> encoder)
+    : writer_(new aux::fileWriter_t(path, options, encoder))
+{
+}
+
+fileTarget_t::~fileTarget_t()
+{
+}
+
+void fileTarget_t::log(const message_t& log)
+{
+    writer_->log(log);
+}
+
+void fileTarget_t::flush()
+{
+    writer_->flush();
+}
+
+size_t fileTarget_t::rotations() const
+{
+    return writer_->rotations();
+}
+
+namespace aux
+{
+namespace
+{
+const size_t TEXT_CHUNK_LENGTH = 16384; //!< the size (in characters) of the arena blocks
+const size_t TEXT_MAX_SHARED = TEXT_CHUNK_LENGTH / 4; //!< longer texts get a block of their own
+
+/*! Returns the first character of the given arena block. */
+jj::char_t* chunkText(textChunk_t* chunk)
+{
+    return reinterpret_cast<jj::char_t*>(reinterpret_cast<char*>(chunk) + sizeof(textChunk_t));
+}
+
+/*! Allocates a new arena block for the given number of characters (referenced once). */
+textChunk_t* newTextChunk(size_t length)
+{
+    char* mem = new char[sizeof(textChunk_t) + length * sizeof(jj::char_t)];
+    textChunk_t* ret = reinterpret_cast<textChunk_t*>(mem);
+    new (&ret->Refs) std::atomic<size_t>(1);
+    ret->Size = length;
+    ret->Used = 0;
+    return ret;
+}
+
+/*! The arena of a thread - the block the texts are currently allocated from. */
+struct textArena_t
+{
+    textChunk_t* Current; //!< the current block (referenced by the arena)
+
+    textArena_t() : Current(nullptr) {}
+    ~textArena_t() { if (Current != nullptr) releaseText(Current); }
+};
+
+thread_local textArena_t textArena;
+} // namespace <anonymous>
+
+textChunk_t* allocateText(size_t len, jj::char_t*& dest)
+{
+    size_t need = len + 1; // the terminating 0
+    if (need > TEXT_MAX_SHARED)
+    {
+        textChunk_t* ret = newTextChunk(need);
+        ret->Used = need;
+        dest = chunkText(ret);
+        return ret;
+    }
+    textArena_t& arena = textArena;
+    if (arena.Current == nullptr || arena.Current->Size - arena.Current->Used < need)
+    {
+        if (arena.Current != nullptr)
+            releaseText(arena.Current);
+        arena.Current = newTextChunk(TEXT_CHUNK_LENGTH);
+    }
+    dest = chunkText(arena.Current) + arena.Current->Used;
+    arena.Current->Used += need;
+    arena.Current->Refs.fetch_add(1, std::memory_order_relaxed);
+    return arena.Current;
+}
+
+/*! Owns the queue and the consumer thread of the asynchronous mode. The consumed messages are passed
+to the sink given in ctor. */
+class asyncDispatcher_t
+{
+public:
+    typedef std::function<void(const message_t&)> sink_t; //!< receives the messages on the consumer thread
+    typedef std::function<void()> idle_t; //!< invoked on the consumer thread whenever the queue gets empty
+
+private:
+    mpscQueue_t<message_t> queue_; //!< the messages waiting for the consumer
+    const logger_t::overflow_t overflow_; //!< what to do if the queue is full
+    sink_t sink_; //!< where the consumed messages go
+    idle_t idle_; //!< what to do once everything is consumed
+    std::atomic<bool> stop_; //!< set when the consumer shall finish
+    std::atomic<bool> sleeping_; //!< set while the consumer waits for new messages
+    std::atomic<size_t> waiting_; //!< the number of threads waiting in flush()
+    std::atomic<size_t> flushed_; //!< the number of messages consumed before the last idle_ call
+    std::atomic<size_t> dropped_; //!< dropped messages not yet reported
+    std::atomic<size_t> droppedTotal_; //!< all dropped messages
+    std::mutex lock_; //!< guards the waiting on the condition variables below
+    std::condition_variable wake_; //!< wakes up the consumer
+    std::condition_variable drained_; //!< wakes up the threads waiting in flush()
+    std::thread thread_; //!< the consumer thread
+
+    /*! Logs a message telling how many messages were dropped since the last report. */
+    void reportDropped()
+    {
+        size_t cnt = dropped_.exchange(0);
+        if (cnt == 0)
+            return;
+        sink_(message_t(clock_t::now(), JJ_LOGLEVEL_WARNING, logger_t::NAME_WARNING,
+            jjS(cnt << jjT(" log message(s) dropped, the asynchronous queue was full.")),
+            JJ_FUNC, __FILE__, __LINE__, ::jjTheLogComponent));
+    }
+
+    /*! The body of the consumer thread. */
+    void run()
+    {
+        while (true)
+        {
+            bool any = false;
+            while (queue_.consume([this](message_t& msg) { sink_(msg); }))
+                any = true;
+            reportDropped();
+            if (any && waiting_.load() == 0)
+                continue; // more might have arrived meanwhile, keep the targets batching
+            size_t consumed = queue_.consumed();
+            if (consumed != flushed_.load() || waiting_.load() != 0)
+                idle_();
+            std::unique_lock<std::mutex> l(lock_);
+            flushed_.store(consumed);
+            drained_.notify_all();
+            if (any)
+                continue;
+            if (stop_.load())
+                break;
+            sleeping_.store(true);
+            if (queue_.empty() && !stop_.load())
+                wake_.wait_for(l, std::chrono::milliseconds(10));
+            sleeping_.store(false);
+        }
+    }
+
+    /*! Wakes up the consumer (if it sleeps). */
+    void wake()
+    {
+        if (sleeping_.load())
+            wake_.notify_one();
+    }
+
+public:
+    /*! Ctor - starts the consumer thread. */
+    asyncDispatcher_t(size_t capacity, logger_t::overflow_t overflow, sink_t sink, idle_t idle)
+        : queue_(capacity), overflow_(overflow), sink_(sink), idle_(idle), stop_(false), sleeping_(false), waiting_(0), flushed_(0), dropped_(0), droppedTotal_(0)
+    {
+        thread_ = std::thread([this]() { run(); });
+    }
+    /*! Dtor - delivers whatever is in the queue and stops the consumer thread. */
+    ~asyncDispatcher_t()
+    {
+        {
+            std::lock_guard<std::mutex> l(lock_);
+            stop_.store(true);
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    /*! Returns true if called from the consumer thread. */
+    bool isConsumer() const { return std::this_thread::get_id() == thread_.get_id(); }
+
+    /*! Puts the message into the queue (and handles a full queue as requested in ctor). */
+    void push(message_t&& msg)
+    {
+        while (!queue_.tryPush(std::move(msg)))
+        {
+            if (overflow_ != logger_t::BLOCK)
+            {
+                droppedTotal_.fetch_add(1, std::memory_order_relaxed);
+                if (overflow_ == logger_t::DROP_AND_COUNT)
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wake_.notify_one();
+            std::this_thread::yield();
+        }
+        wake();
+    }
+
+    /*! Waits until everything pushed so far is consumed and the idle callback was invoked afterwards. */
+    void flush()
+    {
+        size_t target = queue_.pushed();
+        ++waiting_;
+        std::unique_lock<std::mutex> l(lock_);
+        wake_.notify_one();
+        drained_.wait(l, [&]() { return flushed_.load() >= target; });
+        --waiting_;
+    }
+
+    /*! Returns the number of all dropped messages. */
+    size_t dropped() const { return droppedTotal_.load(std::memory_order_relaxed); }
+};
+} // namespace aux
+
+logger_t::logger_t()
+    : tgts_(new logTargets_t()), epoch_(0)
+{
+    readers_[0] = 0;
+    readers_[1] = 0;
+    initialize(*this);
+}
+
+logger_t::~logger_t()
+{
+    stopAsync();
+    delete tgts_.load();
+}
+
+void logger_t::swapTargets(const logTargets_t* tgts)
+{
+    level_t detail = JJ_LOGLEVEL_OFF;
+    for (auto& t : *tgts)
+        if (t && t->detailLevel() < detail)
+            detail = t->detailLevel();
+    {
+        std::lock_guard<std::mutex> guard(componentLock);
+        aux::detailLevel.store(detail, std::memory_order_relaxed);
+        for (component_t* c = componentHead.load(std::memory_order_relaxed); c != nullptr; c = c->next())
+        {
+            level_t cdetail = JJ_LOGLEVEL_OFF;
+            for (auto& t : *tgts)
+                if (t && t->componentDetailLevel(*c) < cdetail)
+                    cdetail = t->componentDetailLevel(*c);
+            c->setDetailLevel(cdetail);
+        }
+    }
+    const logTargets_t* old = tgts_.exchange(tgts);
+    // the readers starting from now on get the new list and announce themselves in the other epoch, so waiting
+    // for the ones of the previous epoch to finish is enough (and is not delayed by a steady flow of new readers)
+    unsigned epoch = epoch_.fetch_add(1);
+    while (readers_[epoch & 1].load() != 0)
+        std::this_thread::yield();
+    delete old;
+}
+
+void logger_t::registerTarget(logTarget_t tgt)
+{
+    std::lock_guard<std::mutex> lock(update_);
+    std::unique_ptr<logTargets_t> tgts(new logTargets_t(*tgts_.load()));
+    tgts->push_back(tgt);
+    swapTargets(tgts.release());
+}
+
+void logger_t::unregisterTarget(const logTarget_t& tgt)
+{
+    std::lock_guard<std::mutex> lock(update_);
+    std::unique_ptr<logTargets_t> tgts(new logTargets_t(*tgts_.load()));
+    tgts->erase(std::remove(tgts->begin(), tgts->end(), tgt), tgts->end());
+    swapTargets(tgts.release());
+}
+
+logger_t::logTarget_t logger_t::replaceTargets(logTarget_t tgt)
+{
+    logTargets_t old = setTargets(logTargets_t(1, tgt));
+    return old.empty() ? nullptr : old.front();
+}
+
+logger_t::logTargets_t logger_t::setTargets(logTargets_t tgts)
+{
+    std::lock_guard<std::mutex> lock(update_);
+    logTargets_t ret(*tgts_.load());
+    swapTargets(new logTargets_t(std::move(tgts)));
+    return ret;
+}
+
+void logger_t::logAsync(message_t&& msg)
+{
+    if (async_->isConsumer())
+    {
+        // logging from within a target, waiting for the queue would deadlock
+        deliver(msg);
+        return;
+    }
+    level_t level = msg.Level;
+    async_->push(std::move(msg));
+    if (level >= JJ_LOGLEVEL_FATAL)
+        async_->flush();
+}
+
+void logger_t::startAsync(size_t capacity, overflow_t overflow)
+{
+    if (async_)
+        return;
+    async_.reset(new aux::asyncDispatcher_t(capacity, overflow, [this](const message_t& msg) { deliver(msg); }, [this]() { flushTargets(); }));
+}
+
+void logger_t::stopAsync()
+{
+    async_.reset();
+}
+
+void logger_t::flush()
+{
+    if (async_ && !async_->isConsumer())
+        async_->flush();
+    else
+        flushTargets();
+}
+
+size_t logger_t::dropped() const
+{
+    return async_ ? async_->dropped() : 0;
+}
+
+void filterTarget_t::log(const message_t& log)
+{
+    if (log.Level < level_)
+        return;
+    if (!passes(log.Component))
+        return;
+    target_->log(log);
+}
+
+bool filterTarget_t::passes(const component_t& component) const
+{
+    return components_.empty() || std::find(components_.begin(), components_.end(), &component) != components_.end();
+}
+
+queuedTarget_t::queuedTarget_t(logger_t::logTarget_t target, size_t capacity, logger_t::overflow_t overflow)
+    : target_(target)
+{
+    async_.reset(new aux::asyncDispatcher_t(capacity, overflow, [this](const message_t& msg) { target_->log(msg); }, [this]() { target_->flush(); }));
+}
+
+queuedTarget_t::~queuedTarget_t()
+{
+}
+
+void queuedTarget_t::log(const message_t& log)
+{
+    if (async_->isConsumer())
+    {
+        // the target itself logs, waiting for the queue would deadlock
+        target_->log(log);
+        return;
+    }
+    async_->push(message_t(log));
+    if (log.Level >= JJ_LOGLEVEL_FATAL)
+        async_->flush();
+}
+
+void queuedTarget_t::flush()
+{
+    if (!async_->isConsumer())
+        async_->flush();
+}
+
+size_t queuedTarget_t::dropped() const
+{
+    return async_->dropped();
+}
+
 const levelName_t logger_t::NAME_FATAL = jjT("FATAL");
 const levelName_t logger_t::NAME_ERROR = jjT("ERROR");
 const levelName_t logger_t::NAME_ALERT = jjT("ALERT");
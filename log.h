@@ -6,9 +6,13 @@
 #include "jj/stream.h"
 #include "jj/singleton.h"
 #include "jj/macros.h"
+#include "jj/logDeferred.h"
+#include "jj/logText.h"
 #include <sstream>
 #include <climits>
-#include <list>
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include <chrono>
 #include <memory>
 
@@ -24,9 +28,11 @@ the JJ_LOGGER_INITIALIZER macro.
 Few additional macros can be used to tweak the behavior of the logger:
 JJ_LOG_STREAM_PROVIDER - to convert the message parameter of the logging statement macros to a string the logger
     has to use a jj::osstream_t type of class. A way how the obtain such a stream is defined by the macro.
-    The default behaviour provides a new stream for every log message.
+    The default behaviour reuses a stream (and its buffer) per thread, see threadStreamProvider_t.
     To adjust redefine the macro - it has to be any expression that evaluates to an object taking << operator
     and having a str() method.
+JJ_LOG_DEFERRED_FORMAT - if set to 1 the default JJ_LOG_STREAM_PROVIDER only records the streamed values
+    and the message text is formatted only when it is delivered to the targets, see logDeferred.h.
 
 The logging levels
 The logging level is simply a number in the whole range of the unsigned int type - the higher
@@ -78,9 +84,18 @@ Logger and multi-threading
 The logger defined in this header is not designed for usage in multi-threaded environment. However,
 if you want to use it in such an environment make sure:
 1) you initialize it (call the instance() method) while still single-threaded
-2) do not modify the list of registered log targets after logger is initialized
-3) use alternative log targets that are thread-safe
+2) use alternative log targets that are thread-safe
 If all are satisfied then the logger works fine even in multi-threaded.
+The list of registered log targets can be changed at any time from any thread (but not from within
+a log target). The logging threads never wait for that - they keep using the previous list until done
+with the current message, see jj::log::logger_t::setTargets().
+
+The asynchronous mode
+By default the targets are invoked directly by the thread performing the log statement. Use
+jj::log::logger_t::startAsync() (ideally in the initializer) to only queue the messages and let a dedicated
+thread invoke the targets. Then the targets are only ever called from that single thread.
+See jj::log::logger_t::overflow_t for the options what to do if the messages are produced faster than
+the targets can process them.
 */
 
 /*! \def JJ_LOGLEVEL_DEBUG
@@ -140,18 +155,60 @@ typedef const jj::char_t* levelName_t; //!< the type used for log level name
 typedef std::chrono::system_clock clock_t; //!< the clock type used for "now"
 typedef typename clock_t::time_point timestamp_t; //!< a "now" type
 
+/*! Limits the amount of messages of a log level, see component_t::setRateLimit().
+The messages are first sampled (only every Sample-th one passes), the passing ones are then subject to a token
+bucket - it holds up to Burst tokens, each message takes one and Rate tokens are added per second. */
+struct rateLimit_t
+{
+    double Rate; //!< the number of messages per second allowed in the long run (0 = no rate limiting)
+    unsigned Burst; //!< the number of messages allowed at once (the size of the token bucket)
+    unsigned Sample; //!< only every Sample-th message is logged (0 or 1 = no sampling)
+    std::chrono::milliseconds ReportInterval; //!< how often (at most) a summary about the suppressed messages is logged
+
+    /*! Ctor - the defaults mean no limits. */
+    rateLimit_t(double rate = 0, unsigned burst = 1, unsigned sample = 0, std::chrono::milliseconds reportInterval = std::chrono::milliseconds(1000))
+        : Rate(rate), Burst(burst), Sample(sample), ReportInterval(reportInterval)
+    {
+    }
+};
+
+namespace aux
+{
+struct rateLimits_t;
+/*! The lowest of the logTarget_base_t::detailLevel() of the registered targets (JJ_LOGLEVEL_OFF if no target wants
+the details) - the initial detail level of the components registered later. Maintained by logger_t. */
+extern std::atomic<level_t> detailLevel;
+} // namespace aux
+
 /*! Provides a way how to group logs within a binary.
 Also allows to set "soft" log level limit per component.
 If components are not used the logger contains a default
-central component and its limit is used. */
+central component and its limit is used.
+Additionally the amount of messages per log level can be limited by rate and/or sampling, see setRateLimit().
+All components register themselves in a global list on creation, so their levels can be changed by id at runtime
+(see find() and configure()). The components are singletons created on first use (JJ_DEFINE_LOG_COMPONENT and
+JJ_REFERENCE_LOG_COMPONENT do that during the static initialization).
+The level (and the rate limits) can be changed any time from any thread. */
 class component_t
 {
     const jj::char_t* id_; //!< the "id" of the component
     const jj::char_t* name_; //!< the "user friendly name" of the component
-    level_t level_; //!< log level for the particular component
+    std::atomic<level_t> level_; //!< log level for the particular component
+    std::atomic<level_t> detail_; //!< the lowest logTarget_base_t::componentDetailLevel() of the registered targets for this component
+    std::atomic<aux::rateLimits_t*> limits_; //!< the rate limits (created by first setRateLimit(), nullptr if none)
+    std::atomic<component_t*> next_; //!< the next registered component
+
+    /*! Decides whether a message of the given level passes the limits. Logs a summary about the suppressed
+    messages if it is time to. */
+    bool admitLimited(aux::rateLimits_t& limits, level_t level, levelName_t levelName, const char* func, const char* file, int line);
+
 public:
-    /*! Ctor */
-    component_t(const jj::char_t* id, const jj::char_t* displayName) : id_(id), name_(displayName), level_(0) { setLevel(JJ_LOGLEVEL_INFO); }
+    /*! Ctor - registers the component. */
+    component_t(const jj::char_t* id, const jj::char_t* displayName);
+    /*! Dtor - unregisters the component. */
+    ~component_t();
+    component_t(const component_t&) = delete;
+    component_t& operator=(const component_t&) = delete;
 
     /*! Returns the id of the component. */
     const jj::char_t* id() const { return id_; }
@@ -159,18 +216,117 @@ public:
     const jj::char_t* name() const { return name_; }
 
     /*! Returns whether a given log level is currently enabled (above the "soft" limit). */
-    bool enabled(level_t level) const { return level >= level_; }
+    bool enabled(level_t level) const { return level >= level_.load(std::memory_order_relaxed); }
     /*! Returns the currently set "soft" level limit for log messages in this component. */
-    level_t limit() const { return level_; }
+    level_t limit() const { return level_.load(std::memory_order_relaxed); }
     /*! Changes the currently set "soft" log level limit.
     Note that it will be adjusted if it would go below the "hard" limit. */
-    void setLevel(level_t level)
+    void setLevel(level_t level) { level_.store(level < JJ_LOGLIMIT_HARD ? JJ_LOGLIMIT_HARD : level, std::memory_order_relaxed); }
+    /*! Returns the lowest level of the messages some target wants even if not enabled (see
+    logTarget_base_t::componentDetailLevel()), maintained by logger_t. */
+    level_t detailLevel() const { return detail_.load(std::memory_order_relaxed); }
+    /*! Sets the level returned by detailLevel(), called by logger_t whenever the targets change. */
+    void setDetailLevel(level_t level) { detail_.store(level, std::memory_order_relaxed); }
+
+    /*! Returns the most recently registered component (the components form a list, see next()) or nullptr if none. */
+    static component_t* first();
+    /*! Returns the next (registered earlier) component or nullptr if this is the last one. */
+    component_t* next() const { return next_.load(std::memory_order_acquire); }
+    /*! Returns the registered component with the given id or nullptr if there is none.
+    Does not allocate nor lock, so it is usable even from a signal handler. */
+    static component_t* find(const jj::char_t* id);
+    /*! Applies the level settings in the form "id=level,id=level,...", where id is a component id (or "*" for all
+    components) and level is a level name (FATAL, ERROR, ALERT, WARN, INFO, VERB, SCOPE, DEBUG, OFF; case insensitive)
+    or a number. The settings are applied in the given order. Returns the number of changed components.
+    Throws std::runtime_error on invalid settings (no change is done then). */
+    static size_t configure(const jj::string_t& settings);
+
+    /*! Returns whether a message of given level (already known to be enabled()) shall be logged with respect
+    to the rate limits. The site of the message is used for the summary about the suppressed messages.
+    Does nothing but a single atomic load unless setRateLimit() was ever called. */
+    bool admit(level_t level, levelName_t levelName, const char* func, const char* file, int line)
     {
-        if (level < JJ_LOGLIMIT_HARD)
-            level_ = JJ_LOGLIMIT_HARD;
-        else
-            level_ = level;
+        aux::rateLimits_t* limits = limits_.load(std::memory_order_acquire);
+        return limits == nullptr || admitLimited(*limits, level, levelName, func, file, line);
     }
+    /*! Sets the rate limit and sampling of messages of exactly the given log level (pass a default rateLimit_t
+    to remove the limits). Can be called any time from any thread.
+    The suppressed messages are counted and a summary ("suppressed N messages") is logged before the next message
+    which passes the limits once the report interval elapsed.
+    Throws std::runtime_error if too many levels are limited already. */
+    void setRateLimit(level_t level, const rateLimit_t& limit);
+    /*! Returns the total number of messages of the given level suppressed so far by the rate limits. */
+    unsigned long long suppressed(level_t level) const;
+};
+
+/*! A static descriptor of a single log statement (call site). The log statement macros create one (as a function
+local static) when the statement executes for the first time, it is then registered in a global list (see first()).
+Allows switching individual log statements on or off at runtime, see setMode(). */
+class site_t
+{
+public:
+    /*! Decides whether the log statement is enabled. */
+    enum mode_t
+    {
+        DEFAULT, //!< enabled if the log level is enabled in the component
+        ON, //!< always enabled (still subject to the rate limits of the component)
+        OFF //!< always disabled
+    };
+
+private:
+    const char* file_; //!< the source file of the log statement
+    const char* function_; //!< the function containing the log statement
+    int line_; //!< the source line of the log statement
+    level_t level_; //!< the log level of the statement
+    levelName_t levelName_; //!< the name of the log level
+    component_t& component_; //!< the component of the log statement
+    std::atomic<unsigned char> mode_; //!< the current mode_t
+    site_t* next_; //!< the next registered site
+
+public:
+    /*! Ctor - registers the site. The site must live forever (it is never unregistered). */
+    site_t(level_t level, levelName_t levelName, const char* func, const char* file, int line, component_t& component);
+    site_t(const site_t&) = delete;
+    site_t& operator=(const site_t&) = delete;
+
+    /*! Returns the source file of the log statement. */
+    const char* file() const { return file_; }
+    /*! Returns the function containing the log statement. */
+    const char* function() const { return function_; }
+    /*! Returns the source line of the log statement. */
+    int line() const { return line_; }
+    /*! Returns the log level of the statement. */
+    level_t level() const { return level_; }
+    /*! Returns the name of the log level of the statement. */
+    levelName_t levelName() const { return levelName_; }
+    /*! Returns the component of the log statement. */
+    component_t& component() const { return component_; }
+
+    /*! Returns whether the log statement is enabled (before the rate limits are applied). */
+    bool enabled() const
+    {
+        unsigned char mode = mode_.load(std::memory_order_relaxed);
+        return mode == DEFAULT ? component_.enabled(level_) : mode == ON;
+    }
+    /*! Returns whether the (not enabled) log statement shall still produce its message for the targets which want
+    the details, see logTarget_base_t::detailLevel(). Never true for statements (or components) switched OFF explicitly. */
+    bool detailed() const
+    {
+        return level_ >= component_.detailLevel() && mode_.load(std::memory_order_relaxed) == DEFAULT && component_.limit() != JJ_LOGLEVEL_OFF;
+    }
+    /*! Returns the current mode. */
+    mode_t mode() const { return static_cast<mode_t>(mode_.load(std::memory_order_relaxed)); }
+    /*! Changes the mode, can be called any time from any thread. */
+    void setMode(mode_t mode) { mode_.store(static_cast<unsigned char>(mode), std::memory_order_relaxed); }
+
+    /*! Returns the most recently registered site (the sites form a list, see next()) or nullptr if none. */
+    static site_t* first();
+    /*! Returns the next (registered earlier) site or nullptr if this is the last one. */
+    site_t* next() const { return next_; }
+    /*! Changes the mode of all registered sites whose file ends with the given one and which are on the given
+    line (or any line if 0). Returns the number of changed sites.
+    Note that only the log statements executed at least once are registered. */
+    static size_t setMode(const char* file, int line, mode_t mode);
 };
 } // namespace log
 } // namespace jj
@@ -219,30 +375,139 @@ namespace log
 Usually this will set the log targets and enabled log level. */
 extern void initialize(logger_t&);
 
+namespace aux
+{
+/*! A log statement which passed its checks and produces its message now, see armSite(). */
+struct armedSite_t
+{
+    site_t* Site; //!< the descriptor of the log statement
+    bool Detail; //!< set if the message is only for the targets wanting the details
+};
+/*! The log statement armed last by the calling thread. */
+extern thread_local armedSite_t armedSite;
+
+/*! Returns whether the log statement produces its message, if so it is remembered until takeArmed().
+A statement which is not enabled (or is suppressed by the rate limits) still produces the message if a target wants
+the details, such a message does not count into the rate limits. */
+inline bool armSite(site_t& site)
+{
+    if (site.enabled() && site.component().admit(site.level(), site.levelName(), site.function(), site.file(), site.line()))
+        armedSite.Detail = false;
+    else if (site.detailed())
+        armedSite.Detail = true;
+    else
+        return false;
+    armedSite.Site = &site;
+    return true;
+}
+/*! Returns the log statement armed by armSite(). Must be called before the message is streamed, the streaming
+might execute other log statements. */
+inline armedSite_t takeArmed() { return armedSite; }
+} // namespace aux
+
 /*! Any log statement creates an object of this type. */
 struct message_t
 {
     timestamp_t Time; //!< the time at which the log occured (auto-set)
     level_t Level; //!< the log level (based on the log statement used)
     levelName_t LevelName; //!< the name of the log level (based on the log statement used)
-    jj::string_t Message; //!< the actual log message
+    mutable text_t Message; //!< the actual log message (valid once render() was called)
     const char* Function; //!< the function in which the log occurred
     const char* File; //!< the file name of the source file in which the log occurred
     int Line; //!< the source file line on which the log occurred
     component_t& Component;
+    mutable deferred_t Args; //!< the values not formatted into Message yet (see deferredStreamProvider_t)
+    const site_t* Site; //!< the descriptor of the log statement (nullptr if the message does not come from a log statement macro)
+    bool Detail; //!< set if the log statement is not enabled and the message is only passed to the targets wanting details (see logTarget_base_t::detailLevel())
 
     /*! Ctor */
-    message_t(timestamp_t time, level_t level, levelName_t levelName, jj::string_t msg, const char* func, const char* file, int line, component_t& component)
-        : Time(time), Level(level), LevelName(levelName), Message(msg), Function(func), File(file), Line(line), Component(component)
+    message_t(timestamp_t time, level_t level, levelName_t levelName, const jj::string_t& msg, const char* func, const char* file, int line, component_t& component, const site_t* site = nullptr, bool detail = false)
+        : Time(time), Level(level), LevelName(levelName), Message(msg), Function(func), File(file), Line(line), Component(component), Site(site), Detail(detail)
+    {
+    }
+    /*! Ctor */
+    message_t(timestamp_t time, level_t level, levelName_t levelName, const jj::char_t* msg, const char* func, const char* file, int line, component_t& component, const site_t* site = nullptr, bool detail = false)
+        : Time(time), Level(level), LevelName(levelName), Message(msg), Function(func), File(file), Line(line), Component(component), Site(site), Detail(detail)
     {
     }
+    /*! Ctor - the text is moved into the message. */
+    message_t(timestamp_t time, level_t level, levelName_t levelName, text_t&& msg, const char* func, const char* file, int line, component_t& component, const site_t* site = nullptr, bool detail = false)
+        : Time(time), Level(level), LevelName(levelName), Message(std::move(msg)), Function(func), File(file), Line(line), Component(component), Site(site), Detail(detail)
+    {
+    }
+    /*! Ctor - the message of a log statement armed by aux::armSite(), the text is any of the above. */
+    template<typename TEXT>
+    message_t(aux::armedSite_t armed, TEXT&& msg)
+        : message_t(clock_t::now(), armed.Site->level(), armed.Site->levelName(), std::forward<TEXT>(msg), armed.Site->function(),
+            armed.Site->file(), armed.Site->line(), armed.Site->component(), armed.Site, armed.Detail)
+    {
+    }
+    /*! Ctor - the message text is formatted from args later, see render(). */
+    message_t(timestamp_t time, level_t level, levelName_t levelName, deferred_t&& args, const char* func, const char* file, int line, component_t& component, const site_t* site = nullptr, bool detail = false)
+        : Time(time), Level(level), LevelName(levelName), Function(func), File(file), Line(line), Component(component), Args(std::move(args)), Site(site), Detail(detail)
+    {
+    }
+
+    /*! Formats the deferred values (if any) and appends them to Message. The logger calls this before
+    the message is passed to the targets. */
+    void render() const
+    {
+        if (Args.empty())
+            return;
+        Message += Args.str();
+        Args.clear();
+    }
 };
 
-/*! The default class converting log messages into a single string value. */
+/*! A simple class converting log messages into a single string value, constructs a new stream for every message. */
 struct simpleStreamProvider_t : public AUX::SStreamWrap<jj::osstream_t>
 {
 };
 
+namespace aux
+{
+struct threadStream_t;
+/*! Returns the stream of the calling thread prepared for a new message (or a new stream if the one of the thread
+is already in use, e.g. by a log statement within operator<< of a logged value). Defined in log.cpp. */
+threadStream_t* acquireThreadStream();
+/*! Gives back the stream returned by acquireThreadStream(). */
+void releaseThreadStream(threadStream_t* s);
+/*! Returns the builder to format into. */
+jj::fmt::builder_t& threadStreamOut(threadStream_t* s);
+/*! Returns the text formatted so far. */
+text_t threadStreamText(threadStream_t* s);
+} // namespace aux
+
+/*! The default class converting log messages into a single string value. Unlike simpleStreamProvider_t it does
+not construct a stream per message, it reuses a jj::fmt::builder_t (and its buffer) kept per thread - only the format
+flags, width, precision and fill are reset before each message. Numbers and strings are formatted by the builder
+directly (see jj/format.h), other values go through the stream of the builder. The result is handed over as text_t
+(so a short message needs no allocation at all). Note that the stream of a thread keeps the global locale valid when
+it was created. */
+class threadStreamProvider_t
+{
+    aux::threadStream_t* s_; //!< the stream in use
+    jj::fmt::builder_t& out_; //!< the builder of s_
+
+public:
+    /*! Ctor - takes the stream of the thread. */
+    threadStreamProvider_t() : s_(aux::acquireThreadStream()), out_(aux::threadStreamOut(s_)) {}
+    /*! Dtor - gives back the stream. */
+    ~threadStreamProvider_t() { aux::releaseThreadStream(s_); }
+    threadStreamProvider_t(const threadStreamProvider_t&) = delete;
+    threadStreamProvider_t& operator=(const threadStreamProvider_t&) = delete;
+
+    /*! Formats the value. */
+    template<typename V>
+    threadStreamProvider_t& operator<<(const V& v)
+    {
+        out_ << v;
+        return *this;
+    }
+    /*! Returns the formatted text. */
+    text_t str() const { return aux::threadStreamText(s_); }
+};
+
 /*! The base class for all log targets. 
 See jj::log::logger_t::registerTarget() or jj::log::logger_t::replaceTargets(). */
 class logTarget_base_t
@@ -252,6 +517,18 @@ public:
     virtual ~logTarget_base_t() {}
     /*! Invoked whenever a new message arrives. */
     virtual void log(const message_t& log) = 0;
+    /*! Invoked when the messages logged so far shall be written out (for targets buffering the output).
+    See jj::log::logger_t::flush(). */
+    virtual void flush() {}
+    /*! Returns the lowest log level of the messages the target wants to receive even if the level is not enabled
+    in the component (or for the log statement) - such messages have message_t::Detail set and are passed only to the
+    targets wanting them. The default means none. Queried whenever the targets of the logger change, so the value
+    shall be constant. */
+    virtual level_t detailLevel() const { return JJ_LOGLEVEL_OFF; }
+    /*! Same as detailLevel(), just for the messages of the given component - a target wanting the details of only
+    some of the components returns JJ_LOGLEVEL_OFF from detailLevel() and the level for those components here, so
+    the other components do not produce the detail messages at all. */
+    virtual level_t componentDetailLevel(const component_t&) const { return detailLevel(); }
 };
 
 /*! A simple log target that logs to standard output. */
@@ -268,14 +545,145 @@ public:
     virtual void log(const message_t& log) override;
 };
 
+namespace aux
+{
+// forward declaration
+class asyncDispatcher_t;
+class fileWriter_t;
+} // namespace aux
+
+/*! The base class of the classes converting messages into the bytes written by fileTarget_t.
+The methods are never called concurrently. */
+class fileEncoder_base_t
+{
+public:
+    /*! Dtor */
+    virtual ~fileEncoder_base_t() {}
+    /*! Appends whatever shall be at the beginning of a file. Invoked for an empty file when opened
+    (also after each rotation). */
+    virtual void header(std::string&) {}
+    /*! Appends the encoded message. Note that out is empty at the beginning of each batch of messages
+    written at once. */
+    virtual void encode(const message_t& msg, std::string& out) = 0;
+};
+
+/*! Encodes the messages as lines of text in the same layout as stdoutTarget_t uses (in UTF-8 if
+jj::char_t is wide). The default encoder of fileTarget_t. */
+class textEncoder_t : public fileEncoder_base_t
+{
+    std::unique_ptr<jj::fmt::aux::appendStreambuf_t<jj::char_t>> sbuf_; //!< appends the formatted line
+    std::unique_ptr<jj::ostream_t> stream_; //!< formats the line
+    std::basic_string<jj::char_t> line_; //!< the line before conversion (if wide)
+public:
+    /*! Ctor */
+    textEncoder_t();
+    /*! Dtor */
+    ~textEncoder_t();
+    virtual void encode(const message_t& msg, std::string& out) override;
+};
+
+/*! A log target that writes into a file. The messages are encoded (see fileEncoder_base_t), collected in
+a memory buffer and written by a single system call once the buffer fills up, on flush() or after the flush interval.
+The writing (and rotation) is done by a dedicated writer thread - while it writes one buffer the messages are
+collected in the other one, so the logging threads do not wait for the disk (the buffer grows if the disk falls behind).
+The file can be rotated by size and/or by time - then the file is renamed to path.1 (the older ones shifted
+to path.2, path.3, ...) and a new file is started. The rotation by size is decided for each written batch of
+messages, so a file can exceed MaxSize by the last batch if the batches are bigger than MaxSize.
+It is safe to use from multiple threads. */
+class fileTarget_t : public logTarget_base_t
+{
+public:
+    /*! Settings of the file target. */
+    struct options_t
+    {
+        size_t BufferSize; //!< the buffer is written to the file once it contains this many characters
+        unsigned long long MaxSize; //!< the file is rotated before it would grow above this many bytes (0 = no limit)
+        std::chrono::seconds Interval; //!< the file is rotated after being written for this long (0 = no limit)
+        unsigned Backups; //!< the number of rotated files to keep (0 = the old content is discarded)
+        std::chrono::milliseconds FlushInterval; //!< the buffer is written at latest this long after a message was logged (0 = only when full or flushed)
+
+        /*! Ctor - sets the defaults: 64k buffer, no rotation, 5 backups, 1 second flush interval. */
+        options_t() : BufferSize(65536), MaxSize(0), Interval(0), Backups(5), FlushInterval(1000) {}
+    };
+
+    /*! Ctor - opens (or creates) the given file for appending. Throws std::runtime_error if it cannot be opened.
+    The encoder determines the format of the file (textEncoder_t if not given). */
+    fileTarget_t(const jj::string_t& path, const options_t& options = options_t(), std::shared_ptr<fileEncoder_base_t> encoder = std::shared_ptr<fileEncoder_base_t>());
+    /*! Dtor - writes out the buffered lines. */
+    ~fileTarget_t();
+
+    virtual void log(const message_t& log) override;
+    /*! Waits until all the buffered lines are written into the file. */
+    virtual void flush() override;
+    /*! Returns the number of rotations done so far. */
+    size_t rotations() const;
+
+private:
+    std::unique_ptr<aux::fileWriter_t> writer_; //!< the implementation
+};
+
 /*! The main logging class. */
 class logger_t
 {
+public:
     typedef std::shared_ptr<logTarget_base_t> logTarget_t;
-    typedef std::list<logTarget_t> logTargets_t;
-    logTargets_t tgts_;
+    typedef std::vector<logTarget_t> logTargets_t;
+
+private:
+    std::atomic<const logTargets_t*> tgts_; //!< the current targets, never changed but replaced as a whole (see setTargets())
+    std::atomic<unsigned> readers_[2]; //!< the number of threads currently using tgts_, per epoch
+    std::atomic<unsigned> epoch_; //!< selects the slot of readers_ used by the new readers
+    std::mutex update_; //!< serializes the changes of tgts_
+    std::unique_ptr<aux::asyncDispatcher_t> async_; //!< set only while the asynchronous mode is on, see startAsync()
+
+    /*! Keeps the current list of targets alive while in scope. Does not block, only announces the reader
+    so that a concurrent setTargets() waits with the release of the list. */
+    class targetsGuard_t
+    {
+        std::atomic<unsigned>* readers_; //!< the counter of the epoch in which the guard was created
+        const logTargets_t* tgts_; //!< the guarded targets
+    public:
+        /*! Ctor */
+        targetsGuard_t(const logger_t& logger)
+        {
+            logger_t& l = const_cast<logger_t&>(logger);
+            for (;;)
+            {
+                unsigned epoch = l.epoch_.load();
+                readers_ = &l.readers_[epoch & 1];
+                readers_->fetch_add(1);
+                // announced in time only if the epoch did not change meanwhile, otherwise setTargets() might
+                // not wait for this reader (it already waits for the other slot)
+                if (l.epoch_.load() == epoch)
+                    break;
+                readers_->fetch_sub(1);
+            }
+            tgts_ = l.tgts_.load();
+        }
+        /*! Dtor */
+        ~targetsGuard_t() { readers_->fetch_sub(1); }
+        targetsGuard_t(const targetsGuard_t&) = delete;
+        targetsGuard_t& operator=(const targetsGuard_t&) = delete;
+
+        /*! Returns the guarded targets. */
+        const logTargets_t& operator*() const { return *tgts_; }
+        /*! Returns the guarded targets. */
+        const logTargets_t* operator->() const { return tgts_; }
+    };
+
+    /*! Installs the given targets as the current ones and releases the previous ones after all threads
+    which might still use them are done. */
+    void swapTargets(const logTargets_t* tgts);
 
 public:
+    /*! Defines what happens with a message logged in the asynchronous mode while the queue is full. */
+    enum overflow_t
+    {
+        BLOCK, //!< the logging thread waits until there is a free slot in the queue
+        DROP_NEWEST, //!< the message is silently discarded
+        DROP_AND_COUNT //!< the message is discarded but counted, the count is then reported by a log message of its own
+    };
+
     /*! Returns the instance of the singleton.
     Be warned that creation of the instance is not thread-safe, if you intend to use the logger in a multi-thread
     environment, force the creation by calling instance while still single-threaded. */
@@ -298,13 +706,53 @@ public:
 
 private:
     /*! Ctor - invokes the initializer method, see JJ_LOGGER_INITIALIZER. */
-    logger_t() { initialize(*this); }
+    logger_t();
+
+    /*! Distributes the message to all the registered targets on the calling thread (the detail messages only to
+    the targets wanting them). The deferred message text is formatted only if there is a target to receive it.
+    After a message of JJ_LOGLEVEL_FATAL (or higher) level the targets are flushed. */
+    void deliver(const message_t& msg)
+    {
+        {
+            targetsGuard_t tgts(*this);
+            for (auto& t : *tgts) { if (t && (!msg.Detail || msg.Level >= t->componentDetailLevel(msg.Component))) { msg.render(); t->log(msg); } }
+        }
+        if (msg.Level >= JJ_LOGLEVEL_FATAL)
+            flushTargets();
+    }
+    /*! Calls flush() of all the registered targets on the calling thread. */
+    void flushTargets() { targetsGuard_t tgts(*this); for (auto& t : *tgts) { if (t) t->flush(); } }
+    /*! Hands the message over to the consumer thread of the asynchronous mode. */
+    void logAsync(message_t&& msg);
 
 public:
+    /*! Dtor - stops the asynchronous mode (if on) making sure all queued messages are delivered. */
+    ~logger_t();
+
     /*! Performs a log ignoring the log level checks. Do not use this directly, use the log statement
     macros instead. You might use this directly in a special case, like printing the program version,
     or environment info that might be required at the beginning of the log regardless of soft limit. */
-    void log(const message_t& msg) { for (auto& t : tgts_) { if (t) t->log(msg); } }
+    void log(const message_t& msg) { if (async_) logAsync(message_t(msg)); else deliver(msg); }
+    /*! Performs a log ignoring the log level checks, see above. */
+    void log(message_t&& msg) { if (async_) logAsync(std::move(msg)); else deliver(msg); }
+
+    /*! Switches the logger into the asynchronous mode. The log statements then only put the messages
+    into a bounded lock-free queue of (at least) the given capacity and a dedicated consumer thread
+    distributes them to the registered targets. The overflow determines what happens when the queue is full.
+    Messages of JJ_LOGLEVEL_FATAL (or higher) level are always waited for until delivered.
+    Does nothing if the asynchronous mode is already on. Call while still single-threaded. */
+    void startAsync(size_t capacity = 8192, overflow_t overflow = BLOCK);
+    /*! Delivers all queued messages, stops the consumer thread and switches back to the synchronous mode.
+    Call while still single-threaded (or at least while no other thread logs). */
+    void stopAsync();
+    /*! Returns whether the asynchronous mode is on. */
+    bool isAsync() const { return async_ != nullptr; }
+    /*! Waits until all messages logged so far are delivered to the targets and the targets flushed their buffers
+    (see logTarget_base_t::flush()). In the asynchronous mode the targets are flushed whenever the queue is drained. */
+    void flush();
+    /*! Returns the number of messages discarded because the queue was full since the asynchronous mode was started
+    (always 0 in the synchronous mode). */
+    size_t dropped() const;
 
     /*! Returns whether a given log level is currently enabled (above the "soft" limit) in the main component. */
     bool enabled(level_t level) const { return ::jjTheLogComponent.enabled(level); }
@@ -316,26 +764,106 @@ public:
 
     /*! Adds an addtional log target to the current ones.
     Note that the targets will be called in the order as they have been registered. */
-    void registerTarget(logTarget_t tgt) { tgts_.push_back(tgt); }
+    void registerTarget(logTarget_t tgt);
+    /*! Removes the given target (if registered). */
+    void unregisterTarget(const logTarget_t& tgt);
     /*! Removes any existing log targets and instead registers the given one.
     Returns the first of the previously registered targets (if there was any) or none. */
-    logTarget_t replaceTargets(logTarget_t tgt)
+    logTarget_t replaceTargets(logTarget_t tgt);
+    /*! Replaces all the registered targets by the given ones and returns the previous ones.
+    The change is safe while other threads log - the list of targets is never modified, a new one is
+    installed instead, so the logging threads never wait. The method however waits until no thread uses
+    the previous list any more, so the previous targets are no longer called once it returns.
+    Must not be called from within a log target. */
+    logTargets_t setTargets(logTargets_t tgts);
+    /*! Returns a copy of the currently registered targets. */
+    logTargets_t targets() const { targetsGuard_t tgts(*this); return *tgts; }
+};
+
+/*! A log target passing only some of the messages to another target - the ones of at least the given level and
+(optionally) only from the given components. By default it only narrows the messages which passed the "soft" limits
+of the components, so e.g. a slow target can be limited to errors while a fast one gets everything. If created with
+belowLimits, the level works regardless of the soft limits - the messages of the levels disabled in the passing
+components are produced for the target too (see logTarget_base_t::detailLevel()), except in the components
+switched OFF. */
+class filterTarget_t : public logTarget_base_t
+{
+    logger_t::logTarget_t target_; //!< where the passing messages go
+    const level_t level_; //!< the lowest passing level
+    const std::vector<const component_t*> components_; //!< the passing components (all if empty)
+    const bool belowLimits_; //!< whether the messages below the soft limits are wanted too
+
+public:
+    /*! Ctor - the target receives the messages of level or higher of the given components (of all if none given),
+    below the soft limits only if belowLimits is set. */
+    filterTarget_t(logger_t::logTarget_t target, level_t level, const std::vector<const component_t*>& components = std::vector<const component_t*>(), bool belowLimits = false)
+        : target_(target), level_(level), components_(components), belowLimits_(belowLimits)
     {
-        logTarget_t fst(tgts_.size() == 0 ? nullptr : tgts_.front());
-        tgts_.clear(); 
-        registerTarget(tgt);
-        return fst;
     }
+
+    virtual void log(const message_t& log) override;
+    virtual void flush() override { target_->flush(); }
+    virtual level_t detailLevel() const override { return belowLimits_ && components_.empty() ? level_ : JJ_LOGLEVEL_OFF; }
+    virtual level_t componentDetailLevel(const component_t& component) const override { return belowLimits_ && passes(component) ? level_ : JJ_LOGLEVEL_OFF; }
+
+    /*! Returns the wrapped target. */
+    const logger_t::logTarget_t& target() const { return target_; }
+    /*! Returns whether the messages of the component pass. */
+    bool passes(const component_t& component) const;
+    /*! Returns the lowest passing level. */
+    level_t level() const { return level_; }
+    /*! Returns whether the messages below the soft limits are produced for the target. */
+    bool belowLimits() const { return belowLimits_; }
+};
+
+/*! A log target passing the messages to another target on a dedicated thread - the logging threads (and the other
+targets) then do not wait for a slow target. The messages are queued in a bounded lock-free queue, see
+logger_t::startAsync() for the meaning of the capacity and overflow. Messages of JJ_LOGLEVEL_FATAL (or higher) level are
+always waited for until delivered. */
+class queuedTarget_t : public logTarget_base_t
+{
+    logger_t::logTarget_t target_; //!< the target called on the worker thread
+    std::unique_ptr<aux::asyncDispatcher_t> async_; //!< the queue and the worker thread
+
+public:
+    /*! Ctor - starts the worker thread. */
+    queuedTarget_t(logger_t::logTarget_t target, size_t capacity = 8192, logger_t::overflow_t overflow = logger_t::BLOCK);
+    /*! Dtor - delivers all queued messages and stops the worker thread. */
+    ~queuedTarget_t();
+
+    virtual void log(const message_t& log) override;
+    /*! Waits until all the messages received so far are delivered and the target flushed. */
+    virtual void flush() override;
+    virtual level_t detailLevel() const override { return target_->detailLevel(); }
+    virtual level_t componentDetailLevel(const component_t& component) const override { return target_->componentDetailLevel(component); }
+
+    /*! Returns the wrapped target. */
+    const logger_t::logTarget_t& target() const { return target_; }
+    /*! Returns the number of messages discarded because the queue was full. */
+    size_t dropped() const;
 };
+
+namespace aux
+{
+/*! Logs the message of a log statement armed by armSite(). Returns false for a message only for the targets
+wanting the details. */
+inline bool logArmed(message_t&& msg)
+{
+    bool ret = !msg.Detail;
+    logger_t::instance().log(std::move(msg));
+    return ret;
+}
+} // namespace aux
 } // namespace log
 } // namespace jj
 
 /*! A helper macro to define the internals of the individual log statement macros. It does the "soft" limit
 check, converts from streamed values to a string and constructs a message_t of it, finally calls the logger.
 Use this one should you want to define custom log levels and their statement macros.
-Evaluates to true or false based on whether the log level was enabled or not. */
+Evaluates to true or false based on whether the message was logged (the log level was enabled and the message
+was not suppressed by the rate limits of the component). */
 #define JJ__LOGGER2(level,levelname,func,file,line,comp,msg) \
-    (comp.enabled(level) ? \
+    (comp.enabled(level) && comp.admit(level, levelname, func, file, line) ? \
         jj::log::logger_t::instance().log(jj::log::message_t( \
             jj::log::clock_t::now(), \
             level, levelname, \
@@ -345,9 +873,20 @@ Evaluates to true or false based on whether the log level was enabled or not. */
             comp \
         )), true : \
         false)
-/*! A helper macro to define the internals of the individual log statement macros. It injects the "local" values into the log. 
-The actual pipeline is done in JJ__LOGGER2. */
-#define JJ__LOGGER(level,levelname,msg) JJ__LOGGER2(level,levelname,JJ_FUNC,__FILE__, __LINE__,JJ_LOG_COMPONENT,((JJ_LOG_STREAM_PROVIDER << msg).str()))
+/*! A helper macro to define the internals of the individual log statement macros. It injects the "local" values into the log
+and creates the static descriptor of the log statement (jj::log::site_t) on first use, its enabled() check replaces the
+check of the component (so the per-statement switch costs a single relaxed load). A statement which is not enabled still
+produces the message if a target wants the details (see logTarget_base_t::detailLevel()), but evaluates to false then as
+the message was not logged to the other targets. The level and levelname must be constants. Otherwise the same as
+JJ__LOGGER2 (usable anywhere an expression is, the message is streamed in the context of
+the statement; the braced initialization makes sure the armed site is taken before). */
+#define JJ__LOGGER(level,levelname,msg) \
+    (jj::log::aux::armSite([](const char* jj__func) -> jj::log::site_t& { \
+            static jj::log::site_t jj__site(level, levelname, jj__func, __FILE__, __LINE__, JJ_LOG_COMPONENT); \
+            return jj__site; \
+        }(JJ_FUNC)) ? \
+        jj::log::aux::logArmed(jj::log::message_t{ jj::log::aux::takeArmed(), ((JJ_LOG_STREAM_PROVIDER << msg).str()) }) : \
+        false)
 
 /*! A helper macro that allows defining the logger initializer method that has to be defined in every program
 that uses this logger.
@@ -380,6 +919,67 @@ inline const jj::string_t exception2msg(const std::wstring& s) { return jj::strc
 inline const jj::string_t exception2msg(const char* s) { return jj::strcvt::to_string_t(s); }
 inline const jj::string_t exception2msg(const wchar_t* s) { return jj::strcvt::to_string_t(s); }
 
+namespace aux
+{
+/*! Set while the scope tracing is on, see startTrace(). */
+extern std::atomic<bool> tracing;
+/*! Returns the current time for the scope tracing (ns of the steady clock). */
+inline long long traceNow() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+/*! Stores a finished scope into the trace buffer of the calling thread. */
+void traceScope(const site_t& site, long long start, long long end);
+/*! Set while the scope statistics are collected, see startScopeStats(). */
+extern std::atomic<bool> scopeStats;
+/*! Adds the duration of a finished scope into the histogram of the site kept by the calling thread. */
+void recordScope(const site_t& site, long long duration);
+/*! Called by scopeLogger_t when a scope entered at start (see traceNow()) is left, passes the scope to the tracing
+and/or statistics (whichever is on). */
+void scopeFinished(const site_t& site, long long start);
+} // namespace aux
+
+/*! Switches the scope tracing on. While on, every jjLscope records the time it was entered and left (together
+with its site, see site_t) into a per-thread ring buffer holding the last capacity scopes - regardless of the log
+level, so the scope annotations also work as a profiler without the cost of the ENTER/LEAVE text logs.
+The capacity only affects the buffers of the threads which did not trace yet. Use exportTrace() to get the result. */
+void startTrace(size_t capacity = 16384);
+/*! Switches the scope tracing off (the recorded data are kept). */
+void stopTrace();
+/*! Returns whether the scope tracing is on. */
+inline bool isTracing() { return aux::tracing.load(std::memory_order_relaxed); }
+/*! Removes the recorded data (of all threads). Call while not tracing. */
+void clearTrace();
+/*! Writes the recorded scopes in the Chrome trace event format (JSON, loadable by chrome://tracing or Perfetto).
+Call while not tracing, otherwise the scopes being recorded at the moment might be garbled. Returns the number of written scopes. */
+size_t exportTrace(std::ostream& out);
+
+/*! The latency statistics of a scope, see scopeStats(). The durations are in ns, the percentiles are approximate
+(the histograms have a relative precision of about 3%). */
+struct scopeStats_t
+{
+    const char* Function; //!< the function containing the scope
+    const char* File; //!< the source file
+    unsigned long long Count; //!< the number of times the scope was left
+    long long Total; //!< the sum of all durations
+    long long P50; //!< the median
+    long long P99; //!< the 99th percentile
+    long long P999; //!< the 99.9th percentile
+    long long Max; //!< the longest duration
+};
+
+/*! Switches the collection of the scope statistics on. While on, the duration of every jjLscope is added to a histogram
+kept per thread and site (no locking, no log lines, regardless of the log level). */
+void startScopeStats();
+/*! Switches the collection of the scope statistics off (the collected data are kept). */
+void stopScopeStats();
+/*! Returns whether the scope statistics are collected. */
+inline bool isCollectingScopeStats() { return aux::scopeStats.load(std::memory_order_relaxed); }
+/*! Empties the histograms (of all threads). */
+void resetScopeStats();
+/*! Returns the statistics of all scopes left at least once since the last reset, merged from all threads and per function
+and file, sorted by function. Can be called any time (a scope being recorded at the moment might be missing). */
+std::vector<scopeStats_t> scopeStats();
+/*! Prints the statistics returned by scopeStats() as a table (the durations in us). */
+void dumpScopeStats(std::ostream& out);
+
 } // namespace log
 } // namespace jj
 
@@ -398,23 +998,37 @@ class scopeLogger_t
     const char* func_; //!< function in which the log occurred
     const char* file_; //!< file name of the source file in which the log occurred
     component_t& comp_; //!< component in which the log occurred
+    const site_t* site_; //!< the descriptor of the scope (nullptr if not known)
+    long long traceStart_; //!< the time the scope was entered if tracing or collecting statistics (see startTrace(), startScopeStats()), negative otherwise
 
     bool left_; //!< determines whether the LEAVE log was already logged
 
+    /*! Returns whether the LEAVE log on the given line shall be logged - checked like the ENTER log (by the site if known,
+    so a scope switched off by site_t::setMode() does not log LEAVE without ENTER either) and by the rate limits. */
+    bool leaveEnabled(int line) const
+    {
+        return (site_ != nullptr ? site_->enabled() : comp_.enabled(JJ_LOGLEVEL_SCOPE))
+            && comp_.admit(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_LEAVE, func_, file_, line);
+    }
+    /*! Logs LEAVE with values from ctor, the given line and message (no checks done). */
+    template<typename TEXT>
+    void logLeave(int line, TEXT&& msg)
+    {
+        jj::log::logger_t::instance().log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_LEAVE, std::forward<TEXT>(msg), func_, file_, line, comp_));
+    }
+
     /*! Helper to perform the LEAVE log in various situations. Logs with values from ctor, line given here and the message is created
     from the value v only if logValue is true otherwise message is empty. */
     template<typename T>
     void internalLeaveLog(int line, bool logValue, const T& v)
     {
         left_ = true;
+        if (!leaveEnabled(line))
+            return;
         if (logValue)
-        {
-            JJ__LOGGER2(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_LEAVE, func_, file_, line, comp_, ((JJ_LOG_STREAM_PROVIDER << v).str()));
-        }
+            logLeave(line, ((JJ_LOG_STREAM_PROVIDER << v).str()));
         else
-        {
-            JJ__LOGGER2(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_LEAVE, func_, file_, line, comp_, jjT(""));
-        }
+            logLeave(line, jjT(""));
     }
 
     /*! Helper to perform the LEAVE log in various situations. Logs with values from ctor, line given here and the message is created
@@ -423,29 +1037,36 @@ class scopeLogger_t
     void internalLeaveLog(int line, bool logValue, const jj::char_t* msg, const T& v)
     {
         left_ = true;
+        if (!leaveEnabled(line))
+            return;
         if (logValue)
-        {
-            JJ__LOGGER2(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_LEAVE, func_, file_, line, comp_, ((JJ_LOG_STREAM_PROVIDER << msg << jjT("; ") << v).str()));
-        }
+            logLeave(line, ((JJ_LOG_STREAM_PROVIDER << msg << jjT("; ") << v).str()));
         else
-        {
-            JJ__LOGGER2(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_LEAVE, func_, file_, line, comp_, msg);
-        }
+            logLeave(line, msg);
     }
 
 public:
     /*! Ctor - Logs ENTER (if above the set "soft" log limit) and stores the values soa that they can be used in the the LEAVE log. */
     scopeLogger_t(const char* function, const char* file, int line, component_t& component, const jj::string_t& message)
-        : func_(function), file_(file), comp_(component), left_(false)
+        : func_(function), file_(file), comp_(component), site_(nullptr), traceStart_(-1), left_(false)
     {
         JJ__LOGGER2(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_ENTER, func_, file_, line, comp_, message);
     }
+    /*! Ctor - same as above, takes the values from the site (the descriptor of the jjLscope statement). Additionally records
+    the scope if tracing or collecting statistics (see startTrace(), startScopeStats()). */
+    scopeLogger_t(const site_t& site, const jj::string_t& message)
+        : func_(site.function()), file_(site.file()), comp_(site.component()), site_(&site), traceStart_(isTracing() || isCollectingScopeStats() ? aux::traceNow() : -1), left_(false)
+    {
+        if (site.enabled() && comp_.admit(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_ENTER, func_, file_, site.line()))
+            jj::log::logger_t::instance().log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_ENTER, message, func_, file_, site.line(), comp_, site_));
+    }
     /*! Dtor - Logs LEAVE (if above the set "soft" log limit) unless it has already been logged by the methods of the class. */
     ~scopeLogger_t()
     {
-        if (left_)
-            return;
-        JJ__LOGGER2(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_LEAVE, func_, file_, -1, comp_, jjT("<end-of-scope>"));
+        if (traceStart_ >= 0)
+            aux::scopeFinished(*site_, traceStart_);
+        if (!left_ && leaveEnabled(-1))
+            logLeave(-1, jjT("<end-of-scope>"));
     }
 
     /*! Used to log LEAVE with values from ctor, the given line and message as value v if logValue is true, empty otherwise. */
@@ -538,9 +1159,14 @@ public:
 
 /*! Defines the name that is used for the scope logger's instance local variable. */
 #define JJ_LOG_SCOPE theLogScope
-
-/*! Defines the instance of the scope logger in the current block - should be the first statement in a function if that uses scope logging. */
-#define jjLscope(msg) jj::log::scopeLogger_t JJ_LOG_SCOPE(JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT, ((JJ_LOG_STREAM_PROVIDER << msg).str()))
+/*! Defines the name that is used for the static descriptor of the scope logger. */
+#define JJ_LOG_SCOPE_SITE theLogScopeSite
+
+/*! Defines the instance of the scope logger in the current block - should be the first statement in a function if that uses scope logging.
+The message is only formatted if the ENTER log is enabled. */
+#define jjLscope(msg) \
+    static jj::log::site_t JJ_LOG_SCOPE_SITE(JJ_LOGLEVEL_SCOPE, jj::log::logger_t::NAME_ENTER, JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT); \
+    jj::log::scopeLogger_t JJ_LOG_SCOPE(JJ_LOG_SCOPE_SITE, JJ_LOG_SCOPE_SITE.enabled() ? jj::string_t((JJ_LOG_STREAM_PROVIDER << msg).str()) : jj::string_t())
 
 /*! Helper used in jjLL - this one takes only a value that will be returned as parameter. */
 #define JJ__LL1(v) JJ_LOG_SCOPE.leaveLog(__LINE__, false, v)
@@ -0,0 +1,247 @@
+#include "jj/logBinary.h"
+#include "jj/time.h"
+#include <stdexcept>
+#include <ostream>
+
+namespace jj
+{
+namespace log
+{
+namespace binary
+{
+const char MAGIC[4] = { 'J', 'J', 'L', 'B' };
+} // namespace binary
+
+namespace
+{
+/*! Returns the number of ns since epoch of the given time. */
+long long toNs(timestamp_t t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+/*! Converts the (possibly wide) string into UTF-8 and appends it as string. */
+void putText(std::string& out, std::string& scratch, const jj::char_t* s, size_t len)
+{
+#if defined(JJ_USE_WSTRING)
+    scratch = jj::strcvt::to_string(std::wstring(s, len));
+    binary::putString(out, scratch.c_str(), scratch.length());
+#else
+    (void)scratch;
+    binary::putString(out, s, len);
+#endif
+}
+} // namespace <anonymous>
+
+binaryEncoder_t::binaryEncoder_t()
+    : last_(0)
+{
+}
+
+void binaryEncoder_t::defineComponent(std::string& out, const component_t& c, unsigned long long id)
+{
+    out.push_back(binary::REC_COMPONENT);
+    binary::putVarint(out, id);
+    const jj::char_t* name = c.name() == nullptr ? jjT("") : c.name();
+    putText(out, scratch_, name, std::char_traits<jj::char_t>::length(name));
+}
+
+void binaryEncoder_t::defineSite(std::string& out, const char* file, const char* func, unsigned long long id)
+{
+    out.push_back(binary::REC_SITE);
+    binary::putVarint(out, id);
+    if (file == nullptr)
+        file = "";
+    if (func == nullptr)
+        func = "";
+    binary::putString(out, file, strlen(file));
+    binary::putString(out, func, strlen(func));
+}
+
+void binaryEncoder_t::defineLevel(std::string& out, level_t level, levelName_t name, unsigned char id)
+{
+    out.push_back(binary::REC_LEVEL);
+    out.push_back(static_cast<char>(id));
+    binary::putVarint(out, level);
+    if (name == nullptr)
+        name = jjT("");
+    putText(out, scratch_, name, std::char_traits<jj::char_t>::length(name));
+}
+
+void binaryEncoder_t::header(std::string& out)
+{
+    out.append(binary::MAGIC, sizeof(binary::MAGIC));
+    out.push_back(static_cast<char>(binary::VERSION));
+    for (auto& c : components_)
+        defineComponent(out, *c.first, c.second);
+    for (auto& s : sites_)
+        defineSite(out, s.first.first, s.first.second, s.second);
+    for (auto& l : levels_)
+        defineLevel(out, l.first.first, l.first.second, l.second);
+}
+
+void binaryEncoder_t::encode(const message_t& msg, std::string& out)
+{
+    long long now = toNs(msg.Time);
+    if (out.empty())
+    {
+        // each batch starts with the absolute time so that it does not depend on the batches before
+        out.push_back(binary::REC_TIME);
+        binary::putVarint(out, static_cast<unsigned long long>(now));
+        last_ = now;
+    }
+
+    auto cit = components_.find(&msg.Component);
+    if (cit == components_.end())
+    {
+        cit = components_.insert(std::make_pair(&msg.Component, components_.size())).first;
+        defineComponent(out, msg.Component, cit->second);
+    }
+    auto sit = sites_.find(std::make_pair(msg.File, msg.Function));
+    if (sit == sites_.end())
+    {
+        sit = sites_.insert(std::make_pair(std::make_pair(msg.File, msg.Function), sites_.size())).first;
+        defineSite(out, msg.File, msg.Function, sit->second);
+    }
+    unsigned char lid;
+    auto lit = levels_.find(std::make_pair(msg.Level, msg.LevelName));
+    if (lit != levels_.end())
+    {
+        lid = lit->second;
+    }
+    else if (levels_.size() < 255)
+    {
+        lid = static_cast<unsigned char>(levels_.size());
+        levels_.insert(std::make_pair(std::make_pair(msg.Level, msg.LevelName), lid));
+        defineLevel(out, msg.Level, msg.LevelName, lid);
+    }
+    else
+    {
+        lid = 255; // out of ids - the last one is redefined whenever used
+        defineLevel(out, msg.Level, msg.LevelName, lid);
+    }
+
+    out.push_back(binary::REC_MESSAGE);
+    binary::putSignedVarint(out, now - last_);
+    last_ = now;
+    out.push_back(static_cast<char>(lid));
+    binary::putVarint(out, cit->second);
+    binary::putVarint(out, sit->second);
+    binary::putSignedVarint(out, msg.Line);
+    putText(out, scratch_, msg.Message.c_str(), msg.Message.length());
+}
+
+binaryDecoder_t::binaryDecoder_t(std::istream& in)
+    : in_(in), started_(false), last_(0)
+{
+}
+
+unsigned char binaryDecoder_t::byte()
+{
+    int ch = in_.get();
+    if (ch == std::char_traits<char>::eof())
+        throw std::runtime_error("Unexpected end of binary log.");
+    return static_cast<unsigned char>(ch);
+}
+
+unsigned long long binaryDecoder_t::varint()
+{
+    unsigned long long ret;
+    if (!jj::binary::getVarint([this]() { return byte(); }, ret))
+        throw std::runtime_error("Invalid number in binary log.");
+    return ret;
+}
+
+long long binaryDecoder_t::signedVarint()
+{
+    return jj::binary::unzigzag(varint());
+}
+
+std::string binaryDecoder_t::string()
+{
+    unsigned long long len = varint();
+    std::string ret;
+    ret.resize(static_cast<size_t>(len));
+    if (len != 0 && !in_.read(&ret[0], static_cast<std::streamsize>(len)))
+        throw std::runtime_error("Unexpected end of binary log.");
+    return ret;
+}
+
+bool binaryDecoder_t::next(decodedMessage_t& msg)
+{
+    while (true)
+    {
+        int ch = in_.get();
+        if (ch == std::char_traits<char>::eof())
+            return false;
+        if (!started_ && ch != binary::MAGIC[0])
+            throw std::runtime_error("Not a binary log.");
+        switch (ch)
+        {
+        case 'J': // the magic; might be repeated in concatenated files
+        {
+            char m[sizeof(binary::MAGIC) + 1];
+            m[0] = static_cast<char>(ch);
+            if (!in_.read(m + 1, sizeof(m) - 1) || std::string(m, sizeof(binary::MAGIC)) != std::string(binary::MAGIC, sizeof(binary::MAGIC)))
+                throw std::runtime_error("Not a binary log.");
+            if (static_cast<unsigned char>(m[sizeof(binary::MAGIC)]) > binary::VERSION)
+                throw std::runtime_error("Unsupported version of binary log.");
+            started_ = true;
+            break;
+        }
+        case binary::REC_TIME:
+            last_ = static_cast<long long>(varint());
+            break;
+        case binary::REC_COMPONENT:
+        {
+            unsigned long long id = varint();
+            components_[id] = string();
+            break;
+        }
+        case binary::REC_SITE:
+        {
+            unsigned long long id = varint();
+            std::string file = string();
+            sites_[id] = std::make_pair(file, string());
+            break;
+        }
+        case binary::REC_LEVEL:
+        {
+            unsigned char id = byte();
+            level_t level = static_cast<level_t>(varint());
+            levels_[id] = std::make_pair(level, string());
+            break;
+        }
+        case binary::REC_MESSAGE:
+        {
+            last_ += signedVarint();
+            msg.Time = timestamp_t(std::chrono::duration_cast<clock_t::duration>(std::chrono::nanoseconds(last_)));
+            auto lit = levels_.find(byte());
+            auto cit = components_.find(varint());
+            auto sit = sites_.find(varint());
+            if (lit == levels_.end() || cit == components_.end() || sit == sites_.end())
+                throw std::runtime_error("Reference to an undefined item in binary log.");
+            msg.Level = lit->second.first;
+            msg.LevelName = lit->second.second;
+            msg.Component = cit->second;
+            msg.File = sit->second.first;
+            msg.Function = sit->second.second;
+            msg.Line = static_cast<int>(signedVarint());
+            msg.Message = string();
+            return true;
+        }
+        default:
+            throw std::runtime_error("Unknown record in binary log.");
+        }
+    }
+}
+
+void binaryDecoder_t::render(std::ostream& out, const decodedMessage_t& msg)
+{
+    char stamp[jj::time::stampFormatter_t<char>::MAX_LENGTH];
+    out.write(stamp, jj::time::threadStampFormatter<char>().format(msg.Time, stamp));
+    out << ' ' << '[' << msg.LevelName << ']' << ' ' << msg.Message << '\n';
+}
+
+} // namespace log
+} // namespace jj
@@ -0,0 +1,133 @@
+#ifndef JJ_LOG_BINARY_H
+#define JJ_LOG_BINARY_H
+
+#include "jj/log.h"
+#include "jj/binaryEncoding.h"
+#include <istream>
+#include <string>
+#include <map>
+#include <vector>
+
+/*! Binary log format
+A compact alternative to the text lines written by fileTarget_t. Use binaryEncoder_t as the encoder
+of the file target and convert the file back to text by binaryDecoder_t (or the jjlogdecode program).
+
+The file starts with the 4 byte magic "JJLB" followed by a format version byte. Then there is a sequence
+of records, each starting with a one byte type:
+'T' ... time sync; the absolute time (varint, ns since epoch)
+'C' ... component definition; id (varint), name (string)
+'S' ... site definition; id (varint), file (string), function (string)
+'L' ... level definition; id (byte), level (varint), name (string)
+'M' ... message; time delta (signed varint, ns since the previous message or time sync), level id (byte),
+        component id (varint), site id (varint), line (signed varint), text (string)
+The varint, signed varint and string are described in jj/binaryEncoding.h.
+The ids refer to the last definition with the same id seen before in the file (definitions might be repeated).
+*/
+
+namespace jj
+{
+namespace log
+{
+namespace binary
+{
+/*! The magic at the beginning of the binary log file. */
+extern const char MAGIC[4];
+/*! The version of the format. */
+const unsigned char VERSION = 1;
+
+/*! The types of the records. */
+enum record_t
+{
+    REC_TIME = 'T', //!< time sync
+    REC_COMPONENT = 'C', //!< component definition
+    REC_SITE = 'S', //!< site (file + function) definition
+    REC_LEVEL = 'L', //!< level definition
+    REC_MESSAGE = 'M' //!< message
+};
+
+using jj::binary::putVarint;
+using jj::binary::putSignedVarint;
+using jj::binary::putString;
+} // namespace binary
+
+/*! Encodes the messages into the binary log format. Components, sites (file and function) and level names
+are only written once (when first used) and referenced by an id later on. */
+class binaryEncoder_t : public fileEncoder_base_t
+{
+    typedef std::map<const component_t*, unsigned long long> components_t;
+    typedef std::map<std::pair<const char*, const char*>, unsigned long long> sites_t;
+    typedef std::map<std::pair<level_t, levelName_t>, unsigned char> levels_t;
+
+    components_t components_; //!< the known components
+    sites_t sites_; //!< the known sites
+    levels_t levels_; //!< the known levels
+    long long last_; //!< the time of the last message (ns since epoch)
+    std::string scratch_; //!< used for conversions
+
+    /*! Appends the definition of the component. */
+    void defineComponent(std::string& out, const component_t& c, unsigned long long id);
+    /*! Appends the definition of the site. */
+    void defineSite(std::string& out, const char* file, const char* func, unsigned long long id);
+    /*! Appends the definition of the level. */
+    void defineLevel(std::string& out, level_t level, levelName_t name, unsigned char id);
+
+public:
+    /*! Ctor */
+    binaryEncoder_t();
+
+    /*! Appends the magic, the version and the definitions of everything known so far. */
+    virtual void header(std::string& out) override;
+    virtual void encode(const message_t& msg, std::string& out) override;
+};
+
+/*! A message read from the binary log. */
+struct decodedMessage_t
+{
+    timestamp_t Time; //!< the time at which the log occurred
+    level_t Level; //!< the log level
+    std::string LevelName; //!< the name of the log level
+    std::string Component; //!< the display name of the component
+    std::string File; //!< the source file name
+    std::string Function; //!< the function
+    int Line; //!< the source file line
+    std::string Message; //!< the message text (UTF-8)
+
+    /*! Ctor */
+    decodedMessage_t() : Level(0), Line(0) {}
+};
+
+/*! Reads the binary log format from a stream. */
+class binaryDecoder_t
+{
+    std::istream& in_; //!< the source
+    bool started_; //!< set once the magic was read
+    long long last_; //!< the time of the last message (ns since epoch)
+    std::map<unsigned long long, std::string> components_; //!< the component definitions
+    std::map<unsigned long long, std::pair<std::string, std::string>> sites_; //!< the site definitions
+    std::map<unsigned char, std::pair<level_t, std::string>> levels_; //!< the level definitions
+
+    /*! Reads one byte, throws if there is none. */
+    unsigned char byte();
+    /*! Reads a varint. */
+    unsigned long long varint();
+    /*! Reads a signed varint. */
+    long long signedVarint();
+    /*! Reads a string. */
+    std::string string();
+
+public:
+    /*! Ctor */
+    binaryDecoder_t(std::istream& in);
+
+    /*! Reads the next message. Returns false at the end of the stream.
+    Throws std::runtime_error if the data are not in the expected format. */
+    bool next(decodedMessage_t& msg);
+
+    /*! Prints the message in the same layout as stdoutTarget_t does. */
+    static void render(std::ostream& out, const decodedMessage_t& msg);
+};
+
+} // namespace log
+} // namespace jj
+
+#endif // JJ_LOG_BINARY_H
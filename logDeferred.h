@@ -0,0 +1,382 @@
+#ifndef JJ_LOG_DEFERRED_H
+#define JJ_LOG_DEFERRED_H
+
+#include "jj/string.h"
+#include "jj/stream.h"
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <climits>
+#include <type_traits>
+#include <utility>
+
+/*! Deferred formatting of log messages
+Instead of converting the streamed values of a log statement into text right away (which means a stream
+allocation and the locale aware formatting on the logging thread) the deferredStreamProvider_t only stores
+the values into a compact binary record (jj::log::deferred_t) and the record is converted into text only
+once a log target actually needs the message (see jj::log::message_t::render()).
+To enable it define JJ_LOG_DEFERRED_FORMAT to 1 (or JJ_LOG_STREAM_PROVIDER to jj::log::deferredStreamProvider_t()).
+
+The values are captured as follows:
+- arithmetic types, bool and characters are stored in binary
+- strings (pointers to jj::char_t and jj::string_t) are copied, unless wrapped in jj::log::literal() in which case
+  only the pointer is stored (use it for strings with static lifetime only)
+- the other arithmetic types, enums, void pointers, the stream manipulators and the types marked by deferByCopy
+  are copied bitwise and printed later via their operator<<
+- any other values are formatted into text right away (note that a stream manipulator preceding such a value
+  does not apply to it) - even the trivially copyable ones, as they might point to memory released before the
+  message is delivered
+*/
+
+namespace jj
+{
+namespace log
+{
+
+/*! Marks a string of static lifetime which can be stored by pointer into a deferred record, see literal(). */
+struct literal_t
+{
+    const jj::char_t* Text; //!< the string itself
+
+    /*! Prints the wrapped string (so that literal() can be used with any stream provider). */
+    friend jj::ostream_t& operator<<(jj::ostream_t& os, const literal_t& v) { return os << v.Text; }
+};
+
+/*! Wraps a string of static lifetime (typically a string literal) so that the deferred formatting stores
+only the pointer to it instead of copying it. */
+inline literal_t literal(const jj::char_t* text) { literal_t ret = { text }; return ret; }
+
+/*! Specialize as std::true_type for a (small) trivially copyable type to have its values copied into the deferred
+record and printed only when the message is delivered. Do so only for types which do not point to memory that might be
+released (or changed) before that, e.g. on another thread in the asynchronous mode. */
+template<typename T>
+struct deferByCopy : public std::false_type
+{
+};
+
+/*! A compact binary record of values streamed into a log statement. The values are appended one by one
+each prefixed by a one byte tag denoting its type, see tag_t. Convert it into text by render() or str(). */
+class deferred_t
+{
+public:
+    /*! The type of a recorded value. */
+    enum tag_t
+    {
+        END, //!< not a valid tag
+        SHORT, USHORT, INT, UINT, LONG, ULONG, LLONG, ULLONG, //!< integers, the value follows
+        FLOAT, DOUBLE, LDOUBLE, //!< floating point numbers, the value follows
+        BOOL, CHAR, SCHAR, UCHAR, WCHAR, //!< booleans and characters, the value follows
+        STRING, //!< a copy of a string; length (size_t) and the characters (jj::char_t) follow
+        LITERAL, //!< a string of static lifetime; the pointer follows
+        OBJECT //!< any other trivially copyable value; render function, size (unsigned short) and the value bytes follow
+    };
+    /*! The function used to print an OBJECT value (the pointer points to a bitwise copy of the value). */
+    typedef void(*renderer_t)(jj::ostream_t&, const unsigned char*);
+
+private:
+    static const size_t INLINE_SIZE = 112; //!< records up to this size do not need any allocation
+
+    unsigned char inline_[INLINE_SIZE]; //!< the inline storage
+    unsigned char* data_; //!< either inline_ or a heap block
+    size_t size_; //!< the number of used bytes
+    size_t capacity_; //!< the number of available bytes
+
+    /*! Makes sure there is space for additional add bytes. */
+    void reserve(size_t add)
+    {
+        if (size_ + add <= capacity_)
+            return;
+        size_t ncap = capacity_ * 2;
+        while (ncap < size_ + add)
+            ncap *= 2;
+        unsigned char* n = new unsigned char[ncap];
+        memcpy(n, data_, size_);
+        if (data_ != inline_)
+            delete[] data_;
+        data_ = n;
+        capacity_ = ncap;
+    }
+    /*! Appends raw bytes. */
+    void append(const void* src, size_t len)
+    {
+        reserve(len);
+        memcpy(data_ + size_, src, len);
+        size_ += len;
+    }
+    /*! Appends a tag. */
+    void appendTag(tag_t tag)
+    {
+        unsigned char t = static_cast<unsigned char>(tag);
+        append(&t, 1);
+    }
+    /*! Reads a value of type T at the position p and moves p behind it. */
+    template<typename T>
+    static T read(const unsigned char*& p)
+    {
+        T ret;
+        memcpy(&ret, p, sizeof(T));
+        p += sizeof(T);
+        return ret;
+    }
+    /*! Prints an OBJECT of type T. */
+    template<typename T>
+    static void renderObject(jj::ostream_t& os, const unsigned char* p)
+    {
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type v;
+        memcpy(&v, p, sizeof(T));
+        os << *reinterpret_cast<const T*>(&v);
+    }
+
+public:
+    /*! Ctor - creates an empty record. */
+    deferred_t() : data_(inline_), size_(0), capacity_(INLINE_SIZE) {}
+    /*! Copy ctor */
+    deferred_t(const deferred_t& other) : data_(inline_), size_(0), capacity_(INLINE_SIZE) { append(other.data_, other.size_); }
+    /*! Move ctor - steals the heap block (if any). */
+    deferred_t(deferred_t&& other) : data_(inline_), size_(0), capacity_(INLINE_SIZE)
+    {
+        if (other.data_ == other.inline_)
+        {
+            append(other.data_, other.size_);
+        }
+        else
+        {
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_;
+            other.capacity_ = INLINE_SIZE;
+        }
+        other.size_ = 0;
+    }
+    /*! Dtor */
+    ~deferred_t()
+    {
+        if (data_ != inline_)
+            delete[] data_;
+    }
+private:
+    deferred_t& operator=(const deferred_t&); // disabled
+
+public:
+    /*! Returns true if nothing was recorded. */
+    bool empty() const { return size_ == 0; }
+    /*! Returns the size of the record in bytes. */
+    size_t size() const { return size_; }
+    /*! Returns the raw record. */
+    const unsigned char* data() const { return data_; }
+    /*! Removes all recorded values (keeps the allocated memory). */
+    void clear() { size_ = 0; }
+
+    /*! Records a value of one of the simple types (tag must be one of SHORT to WCHAR and match T). */
+    template<typename T>
+    void putValue(tag_t tag, T v)
+    {
+        reserve(1 + sizeof(T));
+        appendTag(tag);
+        append(&v, sizeof(T));
+    }
+    /*! Records a copy of the given string. */
+    void putString(const jj::char_t* s, size_t len)
+    {
+        reserve(1 + sizeof(size_t) + len * sizeof(jj::char_t));
+        appendTag(STRING);
+        append(&len, sizeof(size_t));
+        append(s, len * sizeof(jj::char_t));
+    }
+    /*! Records a pointer to a string of static lifetime. */
+    void putLiteral(const jj::char_t* s)
+    {
+        putValue(LITERAL, s);
+    }
+    /*! Records a bitwise copy of a trivially copyable value to be printed by its operator<< during rendering. */
+    template<typename T>
+    void putObject(const T& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= USHRT_MAX, "Only small trivially copyable types can be stored as objects.");
+        renderer_t fn = &deferred_t::renderObject<T>;
+        unsigned short sz = static_cast<unsigned short>(sizeof(T));
+        reserve(1 + sizeof(fn) + sizeof(sz) + sizeof(T));
+        appendTag(OBJECT);
+        append(&fn, sizeof(fn));
+        append(&sz, sizeof(sz));
+        append(&v, sizeof(T));
+    }
+
+    /*! Prints all the recorded values into the given stream (as if they were streamed into it directly). */
+    void render(jj::ostream_t& os) const
+    {
+        const unsigned char* p = data_;
+        const unsigned char* e = data_ + size_;
+        while (p < e)
+        {
+            switch (*p++)
+            {
+            case SHORT: os << read<short>(p); break;
+            case USHORT: os << read<unsigned short>(p); break;
+            case INT: os << read<int>(p); break;
+            case UINT: os << read<unsigned int>(p); break;
+            case LONG: os << read<long>(p); break;
+            case ULONG: os << read<unsigned long>(p); break;
+            case LLONG: os << read<long long>(p); break;
+            case ULLONG: os << read<unsigned long long>(p); break;
+            case FLOAT: os << read<float>(p); break;
+            case DOUBLE: os << read<double>(p); break;
+            case LDOUBLE: os << read<long double>(p); break;
+            case BOOL: os << read<bool>(p); break;
+            case CHAR: os << read<char>(p); break;
+            case SCHAR: os << read<signed char>(p); break;
+            case UCHAR: os << read<unsigned char>(p); break;
+            case WCHAR: os << read<wchar_t>(p); break;
+            case STRING:
+            {
+                size_t len = read<size_t>(p);
+                if (os.width() == 0 && reinterpret_cast<size_t>(p) % sizeof(jj::char_t) == 0)
+                {
+                    os.write(reinterpret_cast<const jj::char_t*>(p), len);
+                }
+                else
+                {
+                    // padding is only done by operator<<
+                    jj::string_t s(len, jjT('\0'));
+                    if (len != 0)
+                        memcpy(&s[0], p, len * sizeof(jj::char_t));
+                    os << s;
+                }
+                p += len * sizeof(jj::char_t);
+                break;
+            }
+            case LITERAL: os << read<const jj::char_t*>(p); break;
+            case OBJECT:
+            {
+                renderer_t fn = read<renderer_t>(p);
+                unsigned short sz = read<unsigned short>(p);
+                fn(os, p);
+                p += sz;
+                break;
+            }
+            default:
+                return; // corrupted
+            }
+        }
+    }
+    /*! Returns the recorded values converted into text. */
+    jj::string_t str() const
+    {
+        jj::osstream_t os;
+        render(os);
+        return os.str();
+    }
+    /*! Converts the recorded values into text, see str(). */
+    operator jj::string_t() const { return str(); }
+};
+
+namespace aux
+{
+/*! Maps the types stored directly in the deferred record to their tags. */
+template<typename T> struct deferredTag { static const deferred_t::tag_t value = deferred_t::END; };
+#define JJ__DEFERRED_TAG(type, tag) template<> struct deferredTag<type> { static const deferred_t::tag_t value = deferred_t::tag; }
+JJ__DEFERRED_TAG(short, SHORT);
+JJ__DEFERRED_TAG(unsigned short, USHORT);
+JJ__DEFERRED_TAG(int, INT);
+JJ__DEFERRED_TAG(unsigned int, UINT);
+JJ__DEFERRED_TAG(long, LONG);
+JJ__DEFERRED_TAG(unsigned long, ULONG);
+JJ__DEFERRED_TAG(long long, LLONG);
+JJ__DEFERRED_TAG(unsigned long long, ULLONG);
+JJ__DEFERRED_TAG(float, FLOAT);
+JJ__DEFERRED_TAG(double, DOUBLE);
+JJ__DEFERRED_TAG(long double, LDOUBLE);
+JJ__DEFERRED_TAG(bool, BOOL);
+JJ__DEFERRED_TAG(char, CHAR);
+JJ__DEFERRED_TAG(signed char, SCHAR);
+JJ__DEFERRED_TAG(unsigned char, UCHAR);
+JJ__DEFERRED_TAG(wchar_t, WCHAR);
+#undef JJ__DEFERRED_TAG
+
+/*! The ways how a value can get into the deferred record. */
+enum deferredKind_t { DK_EAGER, DK_VALUE, DK_STRING, DK_STDSTRING, DK_LITERAL, DK_OBJECT };
+
+/*! Returns true for the character types which the streams print as strings when given a pointer to them. */
+template<typename T> struct isCharLike { static const bool value = std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value || std::is_same<T, jj::char_t>::value; };
+
+/*! Returns true for the standard stream manipulators (the functions and the types returned by those of <iomanip>). */
+template<typename D> struct isManipulator
+{
+    static const bool value = (std::is_pointer<D>::value && std::is_function<typename std::remove_pointer<D>::type>::value)
+        || std::is_same<D, decltype(std::setw(0))>::value || std::is_same<D, decltype(std::setprecision(0))>::value
+        || std::is_same<D, decltype(std::setbase(0))>::value || std::is_same<D, decltype(std::setfill(jj::char_t()))>::value
+        || std::is_same<D, decltype(std::setiosflags(std::ios_base::fmtflags()))>::value
+        || std::is_same<D, decltype(std::resetiosflags(std::ios_base::fmtflags()))>::value;
+};
+
+/*! Determines how the (decayed) type D gets into the deferred record. */
+template<typename D>
+struct deferredKind
+{
+    typedef typename std::remove_cv<typename std::remove_pointer<D>::type>::type pointee_t;
+    static const deferredKind_t value =
+        deferredTag<D>::value != deferred_t::END ? DK_VALUE :
+        std::is_same<D, literal_t>::value ? DK_LITERAL :
+        std::is_pointer<D>::value && std::is_same<pointee_t, jj::char_t>::value ? DK_STRING :
+        std::is_same<D, jj::string_t>::value ? DK_STDSTRING :
+        std::is_pointer<D>::value && isCharLike<pointee_t>::value ? DK_EAGER :
+        (std::is_arithmetic<D>::value || std::is_enum<D>::value || (std::is_pointer<D>::value && std::is_void<pointee_t>::value)
+            || isManipulator<D>::value || deferByCopy<D>::value) && std::is_trivially_copyable<D>::value && sizeof(D) <= 256 ? DK_OBJECT : DK_EAGER;
+};
+
+/*! Puts a value of the (decayed) type D into the deferred record. */
+template<typename D, deferredKind_t KIND = deferredKind<D>::value>
+struct deferredPut
+{
+    static void put(deferred_t& d, const D& v) { jj::osstream_t os; os << v; jj::string_t s(os.str()); d.putString(s.c_str(), s.length()); }
+};
+template<typename D>
+struct deferredPut<D, DK_VALUE>
+{
+    static void put(deferred_t& d, D v) { d.putValue(deferredTag<D>::value, v); }
+};
+template<typename D>
+struct deferredPut<D, DK_STRING>
+{
+    static void put(deferred_t& d, const jj::char_t* v) { if (v == nullptr) d.putLiteral(v); else d.putString(v, std::char_traits<jj::char_t>::length(v)); }
+};
+template<typename D>
+struct deferredPut<D, DK_STDSTRING>
+{
+    static void put(deferred_t& d, const jj::string_t& v) { d.putString(v.c_str(), v.length()); }
+};
+template<typename D>
+struct deferredPut<D, DK_LITERAL>
+{
+    static void put(deferred_t& d, const literal_t& v) { d.putLiteral(v.Text); }
+};
+template<typename D>
+struct deferredPut<D, DK_OBJECT>
+{
+    static void put(deferred_t& d, const D& v) { d.putObject(v); }
+};
+} // namespace aux
+
+/*! A replacement of simpleStreamProvider_t which records the streamed values into a deferred_t instead
+of formatting them. The str() returns the record itself which is then formatted by message_t::render(). */
+class deferredStreamProvider_t
+{
+    deferred_t args_; //!< the recorded values
+public:
+    /*! Records the value. */
+    template<typename V>
+    deferredStreamProvider_t& operator<<(const V& v)
+    {
+        typedef typename std::decay<V>::type decayed_t;
+        aux::deferredPut<decayed_t>::put(args_, v);
+        return *this;
+    }
+    /*! Hands over the recorded values. */
+    deferred_t str() { return std::move(args_); }
+};
+
+} // namespace log
+} // namespace jj
+
+#endif // JJ_LOG_DEFERRED_H
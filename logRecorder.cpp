@@ -0,0 +1,325 @@
+#include "jj/logRecorder.h"
+#include "jj/time.h"
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#if defined(JJ_OS_WINDOWS)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace jj
+{
+namespace log
+{
+namespace aux
+{
+/*! The ring of the formatted messages of a single thread. Only the owning thread writes, the records are guarded
+by a sequence number (odd while being written) so that a dump running concurrently skips the records being changed. */
+struct recorderRing_t
+{
+    /*! The state of a record, the text is stored in Texts. */
+    struct record_t
+    {
+        std::atomic<unsigned> Seq; //!< incremented before and after the record is written
+        std::atomic<size_t> Length; //!< the number of bytes of the text
+    };
+
+    const size_t Size; //!< the number of records
+    const size_t RecordSize; //!< the space for the text of a record
+    std::unique_ptr<record_t[]> Records; //!< the records
+    std::unique_ptr<char[]> Texts; //!< the texts of the records (RecordSize bytes each)
+    std::atomic<unsigned long long> Count; //!< the number of messages ever written (the next one goes to Count % Size)
+    std::atomic<unsigned long long> Dumped; //!< the Count at the last dump
+    std::atomic<bool> Owned; //!< set while a running thread writes into the ring
+    unsigned long long Ended; //!< the order in which the threads ended (valid once Owned is false)
+    unsigned Tid; //!< the thread number (assigned on take over)
+    recorderRing_t* Next; //!< the next ring of the recorder
+
+    recorderRing_t(size_t size, size_t recordSize)
+        : Size(size), RecordSize(recordSize), Records(new record_t[size]), Texts(new char[size * recordSize]), Count(0), Dumped(0), Owned(true), Ended(0), Tid(0), Next(nullptr)
+    {
+        for (size_t i = 0; i < Size; ++i)
+        {
+            Records[i].Seq.store(0, std::memory_order_relaxed);
+            Records[i].Length.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+} // namespace aux
+
+namespace
+{
+std::atomic<unsigned long long> nextSerial(1); //!< the serial number of the next recorder
+std::atomic<const flightRecorder_t*> signalRecorder(nullptr); //!< the recorder dumped on signals
+std::atomic<unsigned long long> nextEnded(1); //!< gives the order in which the threads end
+
+/*! The rings of the calling thread (one per recorder it logged into). Gives them up once the thread ends. */
+struct recorderCache_t
+{
+    std::vector<std::pair<unsigned long long, std::shared_ptr<aux::recorderRing_t>>> Rings; //!< the rings by the serial of their recorder
+    ~recorderCache_t()
+    {
+        for (auto& r : Rings)
+        {
+            r.second->Ended = nextEnded.fetch_add(1);
+            r.second->Owned.store(false);
+        }
+    }
+};
+
+thread_local recorderCache_t recorderCache;
+
+/*! Returns the settings with the sizes adjusted to sensible minimums. */
+flightRecorder_t::options_t sanitize(flightRecorder_t::options_t opts)
+{
+    if (opts.Records < 1)
+        opts.Records = 1;
+    if (opts.RecordSize < 16)
+        opts.RecordSize = 16;
+    return opts;
+}
+
+/*! Copies as much of the UTF-8 string as fits (does not split a character), returns the new end of output. */
+char* put(char* p, char* end, const char* s, size_t len)
+{
+    size_t n = static_cast<size_t>(end - p);
+    if (len > n)
+    {
+        len = n;
+        while (len > 0 && (static_cast<unsigned char>(s[len]) & 0xC0) == 0x80)
+            --len;
+    }
+    memcpy(p, s, len);
+    return p + len;
+}
+
+/*! Copies as much of the string as fits (converted to UTF-8), returns the new end of output. */
+char* putText(char* p, char* end, const jj::char_t* s, size_t len)
+{
+#if defined(JJ_USE_WSTRING)
+    std::string u(jj::strcvt::to_string(std::wstring(s, len)));
+    return put(p, end, u.c_str(), u.length());
+#else
+    return put(p, end, s, len);
+#endif
+}
+
+/*! Formats the message into the given space (in the same layout as stdoutTarget_t), returns the length. */
+size_t format(char* text, size_t size, const message_t& msg)
+{
+    char* p = text;
+    char* end = text + size - 1; // the new line always fits
+    char stamp[jj::time::stampFormatter_t<char>::MAX_LENGTH];
+    p = put(p, end, stamp, jj::time::threadStampFormatter<char>().format(msg.Time, stamp));
+    p = put(p, end, " [", 2);
+    if (msg.LevelName != nullptr)
+        p = putText(p, end, msg.LevelName, std::char_traits<jj::char_t>::length(msg.LevelName));
+    p = put(p, end, "] ", 2);
+    p = putText(p, end, msg.Message.c_str(), msg.Message.length());
+    *p++ = '\n';
+    return static_cast<size_t>(p - text);
+}
+
+/*! Dumps the recorder set up by dumpOnSignal() and performs the default action of the signal. */
+void onSignal(int sig)
+{
+    const flightRecorder_t* r = signalRecorder.load();
+    if (r != nullptr)
+        r->dump();
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+} // namespace <anonymous>
+
+flightRecorder_t::flightRecorder_t(const jj::string_t& path, const options_t& options)
+    : opts_(sanitize(options)), serial_(nextSerial.fetch_add(1)), path_(path), head_(nullptr), nextTid_(1),
+    scratch_(new char[opts_.RecordSize]), dumping_(false)
+{
+}
+
+flightRecorder_t::~flightRecorder_t()
+{
+    const flightRecorder_t* self = this;
+    signalRecorder.compare_exchange_strong(self, nullptr);
+}
+
+aux::recorderRing_t& flightRecorder_t::ring()
+{
+    recorderCache_t& cache = recorderCache;
+    for (auto& r : cache.Rings)
+        if (r.first == serial_)
+            return *r.second;
+
+    // forget the rings of the recorders which are gone
+    for (size_t i = cache.Rings.size(); i > 0; --i)
+        if (cache.Rings[i - 1].second.use_count() == 1)
+            cache.Rings.erase(cache.Rings.begin() + static_cast<std::ptrdiff_t>(i - 1));
+
+    // take over a ring of an ended thread once its content was dumped, keep at most EndedRings with content
+    std::lock_guard<std::mutex> guard(lock_);
+    ring_t ret, oldest;
+    size_t kept = 0;
+    for (auto& r : rings_)
+    {
+        if (r->Owned.load())
+            continue;
+        if (r->Dumped.load() == r->Count.load())
+        {
+            ret = r;
+            break;
+        }
+        ++kept;
+        if (!oldest || r->Ended < oldest->Ended)
+            oldest = r;
+    }
+    if (!ret && kept >= opts_.EndedRings)
+        ret = oldest;
+    if (ret)
+    {
+        ret->Owned.store(true);
+        ret->Count.store(0, std::memory_order_release);
+        ret->Dumped.store(0, std::memory_order_relaxed);
+    }
+    else
+    {
+        ret = std::make_shared<aux::recorderRing_t>(opts_.Records, opts_.RecordSize);
+        ret->Next = head_.load(std::memory_order_relaxed);
+        rings_.push_back(ret);
+        head_.store(ret.get(), std::memory_order_release);
+    }
+    ret->Tid = nextTid_++;
+    cache.Rings.push_back(std::make_pair(serial_, ret));
+    return *ret;
+}
+
+void flightRecorder_t::log(const message_t& log)
+{
+    aux::recorderRing_t& r = ring();
+    unsigned long long n = r.Count.load(std::memory_order_relaxed);
+    size_t idx = static_cast<size_t>(n % r.Size);
+    aux::recorderRing_t::record_t& rec = r.Records[idx];
+    unsigned seq = rec.Seq.load(std::memory_order_relaxed);
+    rec.Seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    rec.Length.store(format(&r.Texts[idx * r.RecordSize], r.RecordSize, log), std::memory_order_relaxed);
+    rec.Seq.store(seq + 2, std::memory_order_release);
+    r.Count.store(n + 1, std::memory_order_release);
+
+    if (log.Level >= JJ_LOGLEVEL_FATAL && opts_.DumpOnFatal)
+        dump();
+}
+
+template<typename W>
+size_t flightRecorder_t::dumpTo(W& write, char* scratch) const
+{
+    size_t ret = 0;
+    for (aux::recorderRing_t* r = head_.load(std::memory_order_acquire); r != nullptr; r = r->Next)
+    {
+        bool ended = !r->Owned.load();
+        unsigned long long cnt = r->Count.load(std::memory_order_acquire);
+        if (cnt == 0)
+            continue;
+        // no snprintf - not safe in a signal handler
+        char hdr[48] = "--- thread ";
+        char digits[16];
+        size_t len = strlen(hdr), nd = 0;
+        for (unsigned tid = r->Tid; nd == 0 || tid != 0; tid /= 10)
+            digits[nd++] = static_cast<char>('0' + tid % 10);
+        while (nd > 0)
+            hdr[len++] = digits[--nd];
+        if (ended)
+        {
+            memcpy(hdr + len, " (ended)", 8);
+            len += 8;
+        }
+        memcpy(hdr + len, " ---\n", 5);
+        write(hdr, len + 5);
+
+        for (unsigned long long i = (cnt > r->Size ? cnt - r->Size : 0); i < cnt; ++i)
+        {
+            size_t idx = static_cast<size_t>(i % r->Size);
+            const aux::recorderRing_t::record_t& rec = r->Records[idx];
+            unsigned seq = rec.Seq.load(std::memory_order_acquire);
+            if ((seq & 1) != 0)
+                continue; // being written
+            size_t tlen = rec.Length.load(std::memory_order_relaxed);
+            if (tlen > r->RecordSize)
+                continue;
+            memcpy(scratch, &r->Texts[idx * r->RecordSize], tlen);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (rec.Seq.load(std::memory_order_relaxed) != seq)
+                continue; // changed while copied
+            write(scratch, tlen);
+            ++ret;
+        }
+        if (ended)
+            r->Dumped.store(cnt); // the ring can be taken over now
+    }
+    return ret;
+}
+
+size_t flightRecorder_t::dump(std::ostream& out) const
+{
+    std::vector<char> scratch(opts_.RecordSize);
+    auto write = [&out](const char* data, size_t len) { out.write(data, static_cast<std::streamsize>(len)); };
+    return dumpTo(write, &scratch[0]);
+}
+
+bool flightRecorder_t::dump() const
+{
+    bool busy = false;
+    if (!dumping_.compare_exchange_strong(busy, true))
+        return false;
+#if defined(JJ_OS_WINDOWS)
+    int fd = _wopen(path_.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0)
+    {
+        dumping_.store(false);
+        return false;
+    }
+    bool ok = true;
+    auto write = [fd, &ok](const char* data, size_t len)
+    {
+        while (ok && len > 0)
+        {
+#if defined(JJ_OS_WINDOWS)
+            int w = _write(fd, data, static_cast<unsigned>(len > INT_MAX ? INT_MAX : len));
+#else
+            ssize_t w = ::write(fd, data, len);
+            if (w < 0 && errno == EINTR)
+                continue;
+#endif
+            if (w <= 0)
+                ok = false;
+            else
+            {
+                data += w;
+                len -= static_cast<size_t>(w);
+            }
+        }
+    };
+    dumpTo(write, scratch_.get());
+#if defined(JJ_OS_WINDOWS)
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+    dumping_.store(false);
+    return ok;
+}
+
+void flightRecorder_t::dumpOnSignal(int signal)
+{
+    signalRecorder.store(this);
+    std::signal(signal, &onSignal);
+}
+
+} // namespace log
+} // namespace jj
@@ -0,0 +1,89 @@
+#ifndef JJ_LOG_RECORDER_H
+#define JJ_LOG_RECORDER_H
+
+#include "jj/log.h"
+#include <ostream>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace jj
+{
+namespace log
+{
+namespace aux
+{
+struct recorderRing_t;
+} // namespace aux
+
+/*! A log target keeping the last messages of each thread in memory (a "flight recorder"). The messages are
+formatted (in the same layout as stdoutTarget_t, UTF-8) into fixed-size records of a per-thread ring, so recording
+takes no lock and no allocation. The recorder also wants the messages of the disabled levels down to the given detail
+level (see logTarget_base_t::detailLevel()), so the full detail is available even while the soft limit is high.
+The content is written out only on demand (dump()), after a message of JJ_LOGLEVEL_FATAL (or higher) level and on
+the signals set up by dumpOnSignal().
+The rings of the threads which ended are kept and taken over by new threads once their content was dumped (or once
+there are more than EndedRings of them - then the ring of the thread which ended first is reused).
+Note that the recorder called on a dispatcher thread (see logger_t::startAsync() and queuedTarget_t) records the
+messages of all the logging threads into the single ring of the dispatcher thread. */
+class flightRecorder_t : public logTarget_base_t
+{
+public:
+    /*! Settings of the recorder. */
+    struct options_t
+    {
+        size_t Records; //!< the number of messages kept per thread
+        size_t RecordSize; //!< the maximal size (in bytes) of a formatted message, longer ones are truncated
+        level_t Detail; //!< the lowest log level recorded even if not enabled
+        bool DumpOnFatal; //!< whether to dump into the file after a message of JJ_LOGLEVEL_FATAL (or higher) level
+        size_t EndedRings; //!< the number of rings of the ended threads kept until dumped
+
+        /*! Ctor - sets the defaults: 1024 records of 256 bytes, everything down to debug is recorded, dumped on fatal,
+        16 rings of ended threads kept. */
+        options_t() : Records(1024), RecordSize(256), Detail(JJ_LOGLEVEL_DEBUG), DumpOnFatal(true), EndedRings(16) {}
+    };
+
+    /*! Ctor - the path is the file written by dump() (it is not opened until then). */
+    flightRecorder_t(const jj::string_t& path, const options_t& options = options_t());
+    /*! Dtor */
+    ~flightRecorder_t();
+    flightRecorder_t(const flightRecorder_t&) = delete;
+    flightRecorder_t& operator=(const flightRecorder_t&) = delete;
+
+    virtual void log(const message_t& log) override;
+    virtual level_t detailLevel() const override { return opts_.Detail; }
+
+    /*! Writes the recorded messages into the stream - per thread, the oldest first. Returns the number of messages. */
+    size_t dump(std::ostream& out) const;
+    /*! Writes (replaces) the file given in ctor with the recorded messages. Neither locks nor allocates, so it is
+    usable from a signal handler. Returns false if the file cannot be written (or another dump into it is running). */
+    bool dump() const;
+    /*! Makes the recorder dump into its file when the given signal arrives, then the default action of the signal is
+    performed (typically the program ends). Only one recorder can be set up this way (the last one wins). */
+    void dumpOnSignal(int signal);
+
+private:
+    typedef std::shared_ptr<aux::recorderRing_t> ring_t;
+
+    const options_t opts_; //!< the settings
+    const unsigned long long serial_; //!< the unique number of the recorder (the threads find their rings by it)
+    const jj::string_t path_; //!< the dump file
+    std::atomic<aux::recorderRing_t*> head_; //!< the list of the rings (walked without locking)
+    std::mutex lock_; //!< guards rings_
+    std::vector<ring_t> rings_; //!< keeps the rings alive
+    unsigned nextTid_; //!< the number of the next thread
+    std::unique_ptr<char[]> scratch_; //!< the copy of a record in dump() to file
+    mutable std::atomic<bool> dumping_; //!< set while scratch_ is used
+
+    /*! Returns the ring of the calling thread (creates or takes over one on the first call in the thread). */
+    aux::recorderRing_t& ring();
+    /*! Passes the recorded messages (copied into scratch) to the writer. */
+    template<typename W>
+    size_t dumpTo(W& write, char* scratch) const;
+};
+
+} // namespace log
+} // namespace jj
+
+#endif // JJ_LOG_RECORDER_H
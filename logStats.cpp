@@ -0,0 +1,282 @@
+#include "jj/log.h"
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <ostream>
+#include <algorithm>
+#include <cstdio>
+
+namespace jj
+{
+namespace log
+{
+namespace aux
+{
+std::atomic<bool> scopeStats(false);
+
+namespace
+{
+/*! The histogram of the durations of a single site recorded by a single thread. The buckets are log-linear
+(HDR like) - the values below SUB are exact, above that each power of 2 is split into SUB equal buckets. */
+struct histogram_t
+{
+    static const int SUB_BITS = 4;
+    static const long long SUB = 1LL << SUB_BITS;
+    static const size_t BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    const site_t* Site; //!< the recorded site
+    histogram_t* Next; //!< the next histogram of the thread
+    std::atomic<unsigned long long> Count; //!< the number of values
+    std::atomic<long long> Total; //!< the sum of values
+    std::atomic<long long> Max; //!< the largest value
+    std::atomic<unsigned long long> Buckets[BUCKETS]; //!< the numbers of values per bucket
+
+    histogram_t(const site_t* site, histogram_t* next) : Site(site), Next(next), Count(0), Total(0), Max(0)
+    {
+        for (auto& b : Buckets)
+            b.store(0, std::memory_order_relaxed);
+    }
+
+    /*! Returns the bucket of the value. */
+    static size_t bucket(long long v)
+    {
+        unsigned long long u = v < 0 ? 0 : static_cast<unsigned long long>(v);
+        if (u < static_cast<unsigned long long>(SUB))
+            return static_cast<size_t>(u);
+        int e = 63;
+        while ((u >> e) == 0)
+            --e;
+        return static_cast<size_t>((e - SUB_BITS + 1) * SUB + ((u >> (e - SUB_BITS)) & (SUB - 1)));
+    }
+    /*! Returns the value in the middle of the bucket. */
+    static long long value(size_t idx)
+    {
+        if (idx < static_cast<size_t>(SUB))
+            return static_cast<long long>(idx);
+        int e = static_cast<int>(idx / SUB) + SUB_BITS - 1;
+        unsigned long long low = (static_cast<unsigned long long>(SUB + idx % SUB)) << (e - SUB_BITS);
+        return static_cast<long long>(low + ((1ULL << (e - SUB_BITS)) >> 1));
+    }
+
+    /*! Adds the value (only called by the owning thread). */
+    void add(long long v)
+    {
+        Buckets[bucket(v)].fetch_add(1, std::memory_order_relaxed);
+        Count.fetch_add(1, std::memory_order_relaxed);
+        Total.fetch_add(v, std::memory_order_relaxed);
+        if (v > Max.load(std::memory_order_relaxed))
+            Max.store(v, std::memory_order_relaxed);
+    }
+    /*! Empties the histogram (can be called by any thread). */
+    void reset()
+    {
+        Count.store(0, std::memory_order_relaxed);
+        Total.store(0, std::memory_order_relaxed);
+        Max.store(0, std::memory_order_relaxed);
+        for (auto& b : Buckets)
+            b.store(0, std::memory_order_relaxed);
+    }
+};
+
+/*! The histograms of a single thread. Only the owning thread adds new ones (at the front of the list), anyone can walk
+the list. Once the thread ends the histograms are kept until taken over by a new thread. */
+struct threadStats_t
+{
+    std::atomic<histogram_t*> Head; //!< the list of histograms
+    std::atomic<bool> Owned; //!< set while a running thread records into the histograms
+
+    threadStats_t() : Head(nullptr), Owned(true) {}
+    ~threadStats_t()
+    {
+        for (histogram_t* h = Head.load(); h != nullptr;)
+        {
+            histogram_t* n = h->Next;
+            delete h;
+            h = n;
+        }
+    }
+};
+
+/*! All the statistics. */
+struct allStats_t
+{
+    std::mutex Lock; //!< guards the members
+    std::vector<std::unique_ptr<threadStats_t>> Threads; //!< the per-thread data
+
+    static allStats_t& instance()
+    {
+        static allStats_t inst;
+        return inst;
+    }
+
+    /*! Returns the data for the calling thread - either new or the ones left by a finished thread. */
+    threadStats_t* acquire()
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        for (auto& t : Threads)
+        {
+            bool owned = false;
+            if (t->Owned.compare_exchange_strong(owned, true))
+                return t.get();
+        }
+        Threads.emplace_back(new threadStats_t);
+        return Threads.back().get();
+    }
+};
+
+/*! Holds the statistics of the thread (and a private index into them), gives them up once the thread ends. */
+struct statsHolder_t
+{
+    threadStats_t* Stats = nullptr; //!< the data of the thread (once it recorded something)
+    std::unordered_map<const site_t*, histogram_t*> Index; //!< finds the histogram of a site
+    ~statsHolder_t() { if (Stats != nullptr) Stats->Owned.store(false); }
+};
+
+thread_local statsHolder_t statsHolder;
+} // namespace <anonymous>
+
+void recordScope(const site_t& site, long long duration)
+{
+    statsHolder_t& holder = statsHolder;
+    if (holder.Stats == nullptr)
+    {
+        holder.Stats = allStats_t::instance().acquire();
+        for (histogram_t* h = holder.Stats->Head.load(std::memory_order_acquire); h != nullptr; h = h->Next)
+            holder.Index[h->Site] = h;
+    }
+    histogram_t*& h = holder.Index[&site];
+    if (h == nullptr)
+    {
+        h = new histogram_t(&site, holder.Stats->Head.load(std::memory_order_relaxed));
+        holder.Stats->Head.store(h, std::memory_order_release);
+    }
+    h->add(duration);
+}
+} // namespace aux
+
+void startScopeStats()
+{
+    aux::scopeStats.store(true);
+}
+
+void stopScopeStats()
+{
+    aux::scopeStats.store(false);
+}
+
+void resetScopeStats()
+{
+    aux::allStats_t& all = aux::allStats_t::instance();
+    std::lock_guard<std::mutex> guard(all.Lock);
+    for (auto& t : all.Threads)
+        for (aux::histogram_t* h = t->Head.load(std::memory_order_acquire); h != nullptr; h = h->Next)
+            h->reset();
+}
+
+namespace
+{
+/*! The histograms of all threads merged per function and file. */
+struct merged_t
+{
+    unsigned long long Count = 0;
+    long long Total = 0;
+    long long Max = 0;
+    std::vector<unsigned long long> Buckets = std::vector<unsigned long long>(aux::histogram_t::BUCKETS);
+};
+
+/*! Orders the (function, file) pairs by their content. */
+struct siteLess_t
+{
+    bool operator()(const std::pair<const char*, const char*>& a, const std::pair<const char*, const char*>& b) const
+    {
+        int r = strcmp(a.first, b.first);
+        return r != 0 ? r < 0 : strcmp(a.second, b.second) < 0;
+    }
+};
+
+/*! Returns the value below which the given fraction of values in the histogram lies (capped by the maximum). */
+long long percentile(const merged_t& m, double fraction)
+{
+    unsigned long long rank = static_cast<unsigned long long>(fraction * static_cast<double>(m.Count) + 0.5), seen = 0;
+    if (rank < 1)
+        rank = 1;
+    for (size_t i = 0; i < m.Buckets.size(); ++i)
+    {
+        seen += m.Buckets[i];
+        if (seen >= rank)
+            return std::min(aux::histogram_t::value(i), m.Max);
+    }
+    return m.Max;
+}
+
+/*! Writes the time given in ns as us with 3 decimals. */
+void writeUs(std::ostream& out, long long ns)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%14.3f", static_cast<double>(ns) / 1000.0);
+    out << buf;
+}
+} // namespace <anonymous>
+
+std::vector<scopeStats_t> scopeStats()
+{
+    std::map<std::pair<const char*, const char*>, merged_t, siteLess_t> merged;
+    {
+        aux::allStats_t& all = aux::allStats_t::instance();
+        std::lock_guard<std::mutex> guard(all.Lock);
+        for (auto& t : all.Threads)
+        {
+            for (aux::histogram_t* h = t->Head.load(std::memory_order_acquire); h != nullptr; h = h->Next)
+            {
+                unsigned long long cnt = h->Count.load(std::memory_order_relaxed);
+                if (cnt == 0)
+                    continue;
+                merged_t& m = merged[std::make_pair(h->Site->function(), h->Site->file())];
+                m.Count += cnt;
+                m.Total += h->Total.load(std::memory_order_relaxed);
+                m.Max = std::max(m.Max, h->Max.load(std::memory_order_relaxed));
+                for (size_t i = 0; i < aux::histogram_t::BUCKETS; ++i)
+                    m.Buckets[i] += h->Buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    std::vector<scopeStats_t> ret;
+    ret.reserve(merged.size());
+    for (auto& m : merged)
+    {
+        scopeStats_t s;
+        s.Function = m.first.first;
+        s.File = m.first.second;
+        s.Count = m.second.Count;
+        s.Total = m.second.Total;
+        s.P50 = percentile(m.second, 0.5);
+        s.P99 = percentile(m.second, 0.99);
+        s.P999 = percentile(m.second, 0.999);
+        s.Max = m.second.Max;
+        ret.push_back(s);
+    }
+    return ret;
+}
+
+void dumpScopeStats(std::ostream& out)
+{
+    out << "         count        p50[us]        p99[us]       p999[us]        max[us]  function (file)\n";
+    for (const scopeStats_t& s : scopeStats())
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%14llu", s.Count);
+        out << buf << ' ';
+        writeUs(out, s.P50);
+        out << ' ';
+        writeUs(out, s.P99);
+        out << ' ';
+        writeUs(out, s.P999);
+        out << ' ';
+        writeUs(out, s.Max);
+        out << "  " << s.Function << " (" << s.File << ")\n";
+    }
+}
+
+} // namespace log
+} // namespace jj
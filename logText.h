@@ -0,0 +1,231 @@
+#ifndef JJ_LOG_TEXT_H
+#define JJ_LOG_TEXT_H
+
+#include "jj/string.h"
+#include "jj/stream.h"
+#include <atomic>
+#include <cstring>
+
+namespace jj
+{
+namespace log
+{
+namespace aux
+{
+/*! A block of memory of the per-thread text arena. The texts allocated from it keep it alive by holding a reference,
+the thread allocating from the block holds one reference too until it moves to a new block. */
+struct textChunk_t
+{
+    std::atomic<size_t> Refs; //!< the number of texts (and threads) referencing the block
+    size_t Size; //!< the number of characters the block can hold
+    size_t Used; //!< the number of characters already allocated (only touched by the owning thread)
+    //!< the characters follow the structure
+};
+
+/*! Allocates memory for len characters from the arena of the calling thread. The returned block is already referenced
+(for the caller), dest receives the pointer to the allocated characters. Defined in log.cpp. */
+textChunk_t* allocateText(size_t len, jj::char_t*& dest);
+/*! Drops a reference to the block, the last one releases it. */
+inline void releaseText(textChunk_t* chunk)
+{
+    if (chunk->Refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete[] reinterpret_cast<char*>(chunk);
+}
+} // namespace aux
+
+/*! The text of a log message. Short texts are stored in an inline buffer (so no allocation is needed at all),
+longer ones are stored in a per-thread arena - a larger block of memory shared by more texts and released once all
+of them are gone. The arena based storage is immutable and shared by copies of the text.
+Provides the often used subset of the jj::string_t interface, use str() to get a real string. */
+class text_t
+{
+public:
+    static const size_t INLINE_LENGTH = 127; //!< texts up to this length are stored inline
+    static const size_t npos = jj::string_t::npos; //!< same as jj::string_t::npos
+
+private:
+    jj::char_t inline_[INLINE_LENGTH + 1]; //!< the inline storage (0-terminated)
+    const jj::char_t* data_; //!< either inline_ or a string in the arena chunk_ (0-terminated)
+    size_t length_; //!< the number of characters
+    aux::textChunk_t* chunk_; //!< the arena block holding the text (or nullptr if inline)
+
+    /*! Drops the current storage and makes the text empty. */
+    void reset()
+    {
+        if (chunk_ != nullptr)
+            aux::releaseText(chunk_);
+        chunk_ = nullptr;
+        data_ = inline_;
+        length_ = 0;
+        inline_[0] = jjT('\0');
+    }
+    /*! Replaces the content by concatenation of the two given strings (the first may point into the current text). */
+    void assign(const jj::char_t* a, size_t alen, const jj::char_t* b, size_t blen)
+    {
+        size_t len = alen + blen;
+        jj::char_t* dest;
+        aux::textChunk_t* chunk = nullptr;
+        if (len <= INLINE_LENGTH)
+        {
+            dest = inline_;
+            if (a != inline_)
+                memmove(dest, a, alen * sizeof(jj::char_t));
+        }
+        else
+        {
+            chunk = aux::allocateText(len, dest);
+            memcpy(dest, a, alen * sizeof(jj::char_t));
+        }
+        memcpy(dest + alen, b, blen * sizeof(jj::char_t));
+        dest[len] = jjT('\0');
+        if (chunk_ != nullptr)
+            aux::releaseText(chunk_);
+        chunk_ = chunk;
+        data_ = dest;
+        length_ = len;
+    }
+    /*! Takes over the storage of other (or copies it if inline). */
+    void share(const text_t& other)
+    {
+        if (other.chunk_ == nullptr)
+        {
+            memcpy(inline_, other.inline_, (other.length_ + 1) * sizeof(jj::char_t));
+            data_ = inline_;
+        }
+        else
+        {
+            other.chunk_->Refs.fetch_add(1, std::memory_order_relaxed);
+            data_ = other.data_;
+        }
+        chunk_ = other.chunk_;
+        length_ = other.length_;
+    }
+
+public:
+    /*! Ctor - empty text. */
+    text_t() : data_(inline_), length_(0), chunk_(nullptr) { inline_[0] = jjT('\0'); }
+    /*! Ctor - copies the given 0-terminated string. */
+    text_t(const jj::char_t* s) : data_(inline_), length_(0), chunk_(nullptr) { inline_[0] = jjT('\0'); if (s != nullptr) assign(s, std::char_traits<jj::char_t>::length(s), s, 0); }
+    /*! Ctor - copies len characters of the given string. */
+    text_t(const jj::char_t* s, size_t len) : data_(inline_), length_(0), chunk_(nullptr) { inline_[0] = jjT('\0'); assign(s, len, s, 0); }
+    /*! Ctor - copies the given string. */
+    text_t(const jj::string_t& s) : data_(inline_), length_(0), chunk_(nullptr) { inline_[0] = jjT('\0'); assign(s.c_str(), s.length(), s.c_str(), 0); }
+    /*! Copy ctor - the arena storage is shared. */
+    text_t(const text_t& other) : chunk_(nullptr) { share(other); }
+    /*! Move ctor - takes over the arena storage. */
+    text_t(text_t&& other) : data_(other.data_), length_(other.length_), chunk_(other.chunk_)
+    {
+        if (chunk_ == nullptr)
+        {
+            memcpy(inline_, other.inline_, (length_ + 1) * sizeof(jj::char_t));
+            data_ = inline_;
+        }
+        other.chunk_ = nullptr;
+        other.reset();
+    }
+    /*! Dtor */
+    ~text_t() { if (chunk_ != nullptr) aux::releaseText(chunk_); }
+
+    /*! Assignment - the arena storage is shared. */
+    text_t& operator=(const text_t& other)
+    {
+        if (this != &other)
+        {
+            aux::textChunk_t* old = chunk_;
+            share(other);
+            if (old != nullptr)
+                aux::releaseText(old);
+        }
+        return *this;
+    }
+    /*! Assignment of a string. */
+    text_t& operator=(const jj::string_t& s) { assign(s.c_str(), s.length(), s.c_str(), 0); return *this; }
+    /*! Assignment of a 0-terminated string. */
+    text_t& operator=(const jj::char_t* s) { if (s == nullptr) reset(); else assign(s, std::char_traits<jj::char_t>::length(s), s, 0); return *this; }
+
+    /*! Appends len characters of the given string. */
+    text_t& append(const jj::char_t* s, size_t len) { if (len != 0) assign(data_, length_, s, len); return *this; }
+    /*! Appends the given string. */
+    text_t& operator+=(const jj::string_t& s) { return append(s.c_str(), s.length()); }
+    /*! Appends the given 0-terminated string. */
+    text_t& operator+=(const jj::char_t* s) { return append(s, std::char_traits<jj::char_t>::length(s)); }
+    /*! Removes the content. */
+    void clear() { reset(); }
+
+    /*! Returns the characters (0-terminated). */
+    const jj::char_t* c_str() const { return data_; }
+    /*! Returns the characters (0-terminated). */
+    const jj::char_t* data() const { return data_; }
+    /*! Returns the number of characters. */
+    size_t length() const { return length_; }
+    /*! Returns the number of characters. */
+    size_t size() const { return length_; }
+    /*! Returns true if there are no characters. */
+    bool empty() const { return length_ == 0; }
+    /*! Returns the character at given position. */
+    jj::char_t operator[](size_t pos) const { return data_[pos]; }
+    /*! Returns whether the text is stored inline (for diagnostics). */
+    bool isInline() const { return chunk_ == nullptr; }
+
+    /*! Returns a copy of the text as string. */
+    jj::string_t str() const { return jj::string_t(data_, length_); }
+    /*! Returns a copy of the text as string. */
+    operator jj::string_t() const { return str(); }
+
+    /*! Returns the position of the first occurrence of s at or after pos (or npos). */
+    size_t find(const jj::char_t* s, size_t pos = 0) const
+    {
+        size_t len = std::char_traits<jj::char_t>::length(s);
+        if (pos > length_ || len > length_ - pos)
+            return npos;
+        for (size_t i = pos; i + len <= length_; ++i)
+            if (std::char_traits<jj::char_t>::compare(data_ + i, s, len) == 0)
+                return i;
+        return npos;
+    }
+    /*! Returns the position of the first occurrence of s at or after pos (or npos). */
+    size_t find(const jj::string_t& s, size_t pos = 0) const { return find(s.c_str(), pos); }
+    /*! Returns the position of the first occurrence of ch at or after pos (or npos). */
+    size_t find(jj::char_t ch, size_t pos = 0) const
+    {
+        for (size_t i = pos; i < length_; ++i)
+            if (data_[i] == ch)
+                return i;
+        return npos;
+    }
+
+    /*! Compares with the given string. */
+    int compare(const jj::char_t* s, size_t len) const
+    {
+        int ret = std::char_traits<jj::char_t>::compare(data_, s, length_ < len ? length_ : len);
+        if (ret != 0)
+            return ret;
+        return length_ < len ? -1 : (length_ > len ? 1 : 0);
+    }
+
+    friend bool operator==(const text_t& a, const text_t& b) { return a.compare(b.data_, b.length_) == 0; }
+    friend bool operator==(const text_t& a, const jj::string_t& b) { return a.compare(b.c_str(), b.length()) == 0; }
+    friend bool operator==(const jj::string_t& a, const text_t& b) { return b == a; }
+    friend bool operator==(const text_t& a, const jj::char_t* b) { return a.compare(b, std::char_traits<jj::char_t>::length(b)) == 0; }
+    friend bool operator==(const jj::char_t* a, const text_t& b) { return b == a; }
+    friend bool operator!=(const text_t& a, const text_t& b) { return !(a == b); }
+    friend bool operator!=(const text_t& a, const jj::string_t& b) { return !(a == b); }
+    friend bool operator!=(const jj::string_t& a, const text_t& b) { return !(b == a); }
+    friend bool operator!=(const text_t& a, const jj::char_t* b) { return !(a == b); }
+    friend bool operator!=(const jj::char_t* a, const text_t& b) { return !(b == a); }
+
+    /*! Prints the text. */
+    friend jj::ostream_t& operator<<(jj::ostream_t& os, const text_t& v)
+    {
+        if (os.width() == 0)
+            return os.write(v.data_, v.length_); // padding is only done by operator<< of string
+        return os << v.str();
+    }
+    /*! Appends the text to the builder. */
+    friend jj::fmt::builder_t& operator<<(jj::fmt::builder_t& b, const text_t& v) { return b.append(v.data_, v.length_); }
+};
+
+} // namespace log
+} // namespace jj
+
+#endif // JJ_LOG_TEXT_H
@@ -0,0 +1,194 @@
+#include "jj/log.h"
+#include <vector>
+#include <mutex>
+#include <ostream>
+#include <cstdio>
+
+namespace jj
+{
+namespace log
+{
+namespace aux
+{
+std::atomic<bool> tracing(false);
+
+namespace
+{
+/*! A scope recorded by the tracing. */
+struct traceEvent_t
+{
+    const site_t* Site; //!< the jjLscope statement
+    long long Start; //!< when the scope was entered (ns of the steady clock)
+    long long End; //!< when the scope was left (ns of the steady clock)
+};
+
+/*! The ring buffer of scopes recorded by a single thread. Once the thread ends the buffer is kept (with the data)
+until taken over by a new thread. */
+struct traceRing_t
+{
+    std::vector<traceEvent_t> Events; //!< the buffer
+    std::atomic<size_t> Count; //!< the number of scopes ever written (the next one goes to Count % size)
+    std::atomic<bool> Owned; //!< set while a running thread writes into the buffer
+    unsigned Tid; //!< the thread number (assigned on take over)
+
+    traceRing_t(size_t capacity) : Events(capacity), Count(0), Owned(true), Tid(0) {}
+};
+
+/*! All the trace buffers. */
+struct traceRings_t
+{
+    std::mutex Lock; //!< guards the members
+    std::vector<std::unique_ptr<traceRing_t>> Rings; //!< the buffers
+    size_t Capacity = 16384; //!< the size of new buffers
+    unsigned NextTid = 1; //!< the number of the next thread
+
+    static traceRings_t& instance()
+    {
+        static traceRings_t inst;
+        return inst;
+    }
+
+    /*! Returns a buffer for the calling thread - either a new one or one left by a finished thread. */
+    traceRing_t* acquire()
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        for (auto& r : Rings)
+        {
+            bool owned = false;
+            if (r->Owned.compare_exchange_strong(owned, true))
+            {
+                r->Count.store(0, std::memory_order_relaxed);
+                if (r->Events.size() != Capacity && Capacity > 0)
+                    r->Events.resize(Capacity);
+                r->Tid = NextTid++;
+                return r.get();
+            }
+        }
+        Rings.emplace_back(new traceRing_t(Capacity < 1 ? 1 : Capacity));
+        Rings.back()->Tid = NextTid++;
+        return Rings.back().get();
+    }
+};
+
+/*! Holds the buffer of the thread, gives it up once the thread ends. */
+struct ringHolder_t
+{
+    traceRing_t* Ring = nullptr; //!< the buffer of the thread (once it traced something)
+    ~ringHolder_t() { if (Ring != nullptr) Ring->Owned.store(false); }
+};
+
+thread_local ringHolder_t ringHolder;
+
+/*! Writes the string as JSON string (with the quotes). */
+void writeJson(std::ostream& out, const char* s)
+{
+    out << '"';
+    for (; s != nullptr && *s != '\0'; ++s)
+    {
+        unsigned char ch = static_cast<unsigned char>(*s);
+        if (ch == '"' || ch == '\\')
+            out << '\\' << *s;
+        else if (ch < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            out << buf;
+        }
+        else
+            out << *s;
+    }
+    out << '"';
+}
+
+/*! Writes the time given in ns as us with 3 decimals. */
+void writeUs(std::ostream& out, long long ns)
+{
+    if (ns < 0)
+    {
+        out << '-';
+        ns = -ns;
+    }
+    char buf[8];
+    snprintf(buf, sizeof(buf), ".%03d", static_cast<int>(ns % 1000));
+    out << ns / 1000 << buf;
+}
+} // namespace <anonymous>
+
+void traceScope(const site_t& site, long long start, long long end)
+{
+    traceRing_t* ring = ringHolder.Ring;
+    if (ring == nullptr)
+        ring = ringHolder.Ring = traceRings_t::instance().acquire();
+    size_t n = ring->Count.load(std::memory_order_relaxed);
+    traceEvent_t& ev = ring->Events[n % ring->Events.size()];
+    ev.Site = &site;
+    ev.Start = start;
+    ev.End = end;
+    ring->Count.store(n + 1, std::memory_order_release);
+}
+
+void scopeFinished(const site_t& site, long long start)
+{
+    long long end = traceNow();
+    if (tracing.load(std::memory_order_relaxed))
+        traceScope(site, start, end);
+    if (scopeStats.load(std::memory_order_relaxed))
+        recordScope(site, end - start);
+}
+} // namespace aux
+
+void startTrace(size_t capacity)
+{
+    aux::traceRings_t& rings = aux::traceRings_t::instance();
+    {
+        std::lock_guard<std::mutex> guard(rings.Lock);
+        rings.Capacity = capacity;
+    }
+    aux::tracing.store(true);
+}
+
+void stopTrace()
+{
+    aux::tracing.store(false);
+}
+
+void clearTrace()
+{
+    aux::traceRings_t& rings = aux::traceRings_t::instance();
+    std::lock_guard<std::mutex> guard(rings.Lock);
+    for (auto& r : rings.Rings)
+        r->Count.store(0);
+}
+
+size_t exportTrace(std::ostream& out)
+{
+    aux::traceRings_t& rings = aux::traceRings_t::instance();
+    std::lock_guard<std::mutex> guard(rings.Lock);
+    size_t ret = 0;
+    out << "{\"traceEvents\":[";
+    for (auto& r : rings.Rings)
+    {
+        size_t cnt = r->Count.load(std::memory_order_acquire), size = r->Events.size();
+        for (size_t i = (cnt > size ? cnt - size : 0); i < cnt; ++i)
+        {
+            const aux::traceEvent_t& ev = r->Events[i % size];
+            out << (ret == 0 ? "\n" : ",\n") << "{\"name\":";
+            aux::writeJson(out, ev.Site->function());
+            out << ",\"cat\":";
+            aux::writeJson(out, jj::strcvt::to_string(ev.Site->component().id()).c_str());
+            out << ",\"ph\":\"X\",\"ts\":";
+            aux::writeUs(out, ev.Start);
+            out << ",\"dur\":";
+            aux::writeUs(out, ev.End - ev.Start);
+            out << ",\"pid\":1,\"tid\":" << r->Tid << ",\"args\":{\"file\":";
+            aux::writeJson(out, ev.Site->file());
+            out << ",\"line\":" << ev.Site->line() << "}}";
+            ++ret;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return ret;
+}
+
+} // namespace log
+} // namespace jj
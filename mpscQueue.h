@@ -0,0 +1,140 @@
+#ifndef JJ_MPSC_QUEUE_H
+#define JJ_MPSC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+namespace jj
+{
+
+/*! A bounded lock-free queue allowing multiple producers and a single consumer.
+The capacity is fixed at construction (rounded up to the nearest power of two).
+Producers never block - tryPush() returns false if the queue is full; it is up to the caller to decide what to do.
+The items are constructed directly inside the queue and consumed in place (see consume()), so T does not have
+to be default constructible nor assignable.
+Based on the well known bounded queue by Dmitry Vyukov (each cell carries a sequence number telling whether
+it is ready to be written or read). */
+template<typename T>
+class mpscQueue_t
+{
+    typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage_t; //!< raw memory for one item
+
+    /*! One slot of the ring. */
+    struct cell_t
+    {
+        std::atomic<size_t> Seq; //!< the position for which this cell is ready (writable if == pos, readable if == pos+1)
+        storage_t Data; //!< the item itself (valid only between push and consume)
+    };
+
+    static const size_t CACHELINE = 64; //!< used to keep producer and consumer counters on separate cache lines
+
+    const size_t mask_; //!< capacity - 1
+    std::unique_ptr<cell_t[]> cells_; //!< the ring
+    char pad0_[CACHELINE];
+    std::atomic<size_t> tail_; //!< next position to be written by producers
+    char pad1_[CACHELINE];
+    std::atomic<size_t> head_; //!< next position to be read by the consumer
+    char pad2_[CACHELINE];
+
+    mpscQueue_t(const mpscQueue_t&); // disabled
+    mpscQueue_t& operator=(const mpscQueue_t&); // disabled
+
+    /*! Returns the smallest power of two greater or equal to v (and at least 2). */
+    static size_t roundUp(size_t v)
+    {
+        size_t ret = 2;
+        while (ret < v)
+            ret <<= 1;
+        return ret;
+    }
+
+public:
+    /*! Ctor - allocates the ring with at least the given number of slots. */
+    explicit mpscQueue_t(size_t capacity)
+        : mask_(roundUp(capacity) - 1), cells_(new cell_t[mask_ + 1]), tail_(0), head_(0)
+    {
+        for (size_t i = 0; i <= mask_; ++i)
+            cells_[i].Seq.store(i, std::memory_order_relaxed);
+    }
+    /*! Dtor - destroys all items not consumed yet. */
+    ~mpscQueue_t()
+    {
+        while (consume([](T&) {}))
+            ;
+    }
+
+    /*! Returns the number of slots in the queue. */
+    size_t capacity() const { return mask_ + 1; }
+
+    /*! Constructs a new item from the given arguments at the end of the queue.
+    Safe to be called from any number of threads concurrently.
+    Returns false (and does not construct anything) if the queue is full. */
+    template<typename ... ARGS>
+    bool tryPush(ARGS&& ... args)
+    {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        cell_t* cell;
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->Seq.load(std::memory_order_acquire);
+            std::ptrdiff_t dif = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+            if (dif == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+                return false; // full
+            else
+                pos = tail_.load(std::memory_order_relaxed);
+        }
+        new (&cell->Data) T(std::forward<ARGS>(args)...);
+        cell->Seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*! Invokes fn with the first item in the queue and removes (destroys) the item afterwards.
+    Must be called by one thread at a time (the single consumer).
+    Returns false (and does not call fn) if the queue is empty. */
+    template<typename FN>
+    bool consume(FN fn)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        cell_t* cell = &cells_[pos & mask_];
+        size_t seq = cell->Seq.load(std::memory_order_acquire);
+        if (std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1) < 0)
+            return false; // empty (or the producer has not finished writing yet)
+        T* item = reinterpret_cast<T*>(&cell->Data);
+        struct guard_t
+        {
+            mpscQueue_t& q_;
+            cell_t* cell_;
+            T* item_;
+            size_t pos_;
+            ~guard_t()
+            {
+                item_->~T();
+                cell_->Seq.store(pos_ + q_.mask_ + 1, std::memory_order_release);
+                q_.head_.store(pos_ + 1, std::memory_order_release);
+            }
+        } g = { *this, cell, item, pos };
+        fn(*item);
+        return true;
+    }
+
+    /*! Returns the number of items ever reserved by producers (including those being written right now). */
+    size_t pushed() const { return tail_.load(std::memory_order_acquire); }
+    /*! Returns the number of items ever consumed (the consume() callback finished for them). */
+    size_t consumed() const { return head_.load(std::memory_order_acquire); }
+    /*! Returns whether the queue seems to be empty. It is only a snapshot - it may change at any time if producers are active. */
+    bool empty() const { return consumed() >= pushed(); }
+};
+
+} // namespace jj
+
+#endif // JJ_MPSC_QUEUE_H
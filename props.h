@@ -102,16 +102,18 @@ struct constnessHandler_t<const X, T>
     typedef const T TYPE;
 };
 
-/*! The real values are taken by reference into the props. This class allows the storage of the references. */
+/*! The real values are taken by reference into the props. This class allows the storage of the references
+(and keeps the dirty flag of the value). */
 template<typename T>
 class propwrap
 {
     T* prop_; //!< the actual prop value
+    bool dirty_; //!< whether the value changed since the flag was cleared
 public:
     /*! Ctor - just for the map container, shall never be used directly. */
-    propwrap() : prop_(nullptr) {}
+    propwrap() : prop_(nullptr), dirty_(false) {}
     /*! Ctor - the actual one to be used. Pass the reference to the actual variable that needs to be managed by props. */
-    explicit propwrap(T& p) : prop_(&p) {}
+    explicit propwrap(T& p) : prop_(&p), dirty_(false) {}
 
     /*! Assign operator - just for the map container, shall never be used directly. */
     propwrap& operator=(T& p) { prop_ = &p; return *this; }
@@ -120,6 +122,11 @@ public:
     const T& get() const { return *prop_; }
     /*! Returns the original value reference. */
     T& get() { return *prop_; }
+
+    /*! Returns true if the value is marked as changed. */
+    bool isDirty() const { return dirty_; }
+    /*! Marks the value as changed (or unchanged). */
+    void setDirty(bool dirty) { dirty_ = dirty; }
 };
 
 /*! Used when iterating nested props - automatically modifies the traversalContext. */
@@ -205,6 +212,14 @@ public:
         for (auto& x : props_)
             visitor.onValue(ctx, x.first, x.second.get());
     }
+    /*! Iterates through the dirty values calling the visitor for each of them. */
+    template<typename VISITOR, typename CTX>
+    void traverseDirty(VISITOR& visitor, CTX& ctx) const
+    {
+        for (auto& x : props_)
+            if (x.second.isDirty())
+                visitor.onValue(ctx, x.first, x.second.get());
+    }
 
     /*! Searches the container and returns value stored under given key,
     nullptr if no such key exists. */
@@ -243,7 +258,7 @@ public:
         return it->second.get();
     }
 
-    /*! Searches the container and updates the value under given key.
+    /*! Searches the container and updates the value under given key (and marks it dirty).
     Throws keyNotFound if no such key exists. */
     void set(key_type key, const T& v)
     {
@@ -251,6 +266,40 @@ public:
         if (it == props_.end())
             throw exception::keyNotFound(key);
         it->second.get() = v;
+        it->second.setDirty(true);
+    }
+
+    /*! Marks the value under given key dirty (changed).
+    Throws keyNotFound if no such key exists. */
+    void markDirty(key_type key)
+    {
+        typename holder_type::iterator it = props_.find(key);
+        if (it == props_.end())
+            throw exception::keyNotFound(key);
+        it->second.setDirty(true);
+    }
+    /*! Returns true if the value under given key is dirty.
+    Throws keyNotFound if no such key exists. */
+    bool isDirty(key_type key) const
+    {
+        typename holder_type::const_iterator it = props_.find(key);
+        if (it == props_.end())
+            throw exception::keyNotFound(key);
+        return it->second.isDirty();
+    }
+    /*! Returns true if any of the values is dirty. */
+    bool anyDirty() const
+    {
+        for (auto& x : props_)
+            if (x.second.isDirty())
+                return true;
+        return false;
+    }
+    /*! Marks all the values clean. */
+    void clearDirty()
+    {
+        for (auto& x : props_)
+            x.second.setDirty(false);
     }
 };
 
@@ -276,6 +325,24 @@ public:
         prop_type::traverse(str, ctx);
         next_type::traverse(str, ctx);
     }
+    /*! Iterates through the dirty values calling the visitor for each of them (for this and all the remaining types). */
+    template<typename VISITOR, typename CTX>
+    void traverseDirty(VISITOR& str, CTX& ctx)
+    {
+        prop_type::traverseDirty(str, ctx);
+        next_type::traverseDirty(str, ctx);
+    }
+    /*! Returns true if any value (of any type) is dirty. */
+    bool anyDirty() const
+    {
+        return prop_type::anyDirty() || next_type::anyDirty();
+    }
+    /*! Marks all the values (of all types) clean. */
+    void clearDirty()
+    {
+        prop_type::clearDirty();
+        next_type::clearDirty();
+    }
 
     // import methods from nested classes
     using prop_type::set;
@@ -330,7 +397,10 @@ protected:
 public:
     // import methods from nested classes
     using prop_type::traverse;
+    using prop_type::traverseDirty;
     using prop_type::set;
+    using prop_type::anyDirty;
+    using prop_type::clearDirty;
 
     /*! Calls action for each type in the typelist. */
     template<typename ACTION>
@@ -402,6 +472,35 @@ public:
             str.onNestedEnd(ctx);
         }
     }
+    /*! Iterates through the nested props having dirty values calling the visitor for the dirty values only
+    (it will recurse for each of them). */
+    template<typename VISITOR, typename CTX>
+    void traverseDirty(VISITOR& str, CTX& ctx)
+    {
+        for (auto& i : props_)
+        {
+            if (!i.second.get().isDirty())
+                continue;
+            traversalContextDiver_t<key_type> dive(ctx, i.first);
+            str.onNestedBegin(ctx);
+            i.second.get().traverseDirty(str, ctx);
+            str.onNestedEnd(ctx);
+        }
+    }
+    /*! Returns true if any value in the nested props is dirty. */
+    bool anyDirty() const
+    {
+        for (auto& i : props_)
+            if (i.second.get().isDirty())
+                return true;
+        return false;
+    }
+    /*! Marks all the values in the nested props clean. */
+    void clearDirty()
+    {
+        for (auto& i : props_)
+            i.second.get().clearDirty();
+    }
 
     /*! Searches the container and returns the props stored under given key or
     returns nullptr if no such key exists. */
@@ -450,6 +549,8 @@ for each of the values to register it. Use addNested() to recurse into substruct
 Later you can access the values in a generic way through get(), set() or getNested().
 Or use any available infrastructure like props::pathWalker_t, textSerializer_t or textDeserializer_t.
 Or define your own.
+The values changed by set() are marked dirty, values changed directly have to be marked by markDirty(). The dirty values
+are visited by traverseDirty() (e.g. to write just the changes), clearDirty() starts the tracking anew.
 Note that it is possible to insert multiple same keys if each is for different value type (or value and nested),
 props will not prohibit this. This will however lead to UNDEFINED BEHAVIOR with the textDeserializer_t!
 
@@ -533,6 +634,15 @@ public:
         list_type::traverse(str, ctx);
         nested_type::traverse(str, ctx);
     }
+    /*! Same as traverse(), just only the dirty values are visited (and only the nested props with dirty values).
+    Passing a serializer writes a patch - only the values changed since the dirty flags were cleared. The patch is
+    applied by reading it into the (unchanged) props by the matching deserializer, which just sets the values in it. */
+    template<typename VISITOR, typename CTX>
+    void traverseDirty(VISITOR& str, CTX& ctx)
+    {
+        list_type::traverseDirty(str, ctx);
+        nested_type::traverseDirty(str, ctx);
+    }
 
     /*! Searches the container of given type T (one of those in props) for key and returns the associated value
     or nullptr if no such key exists. */
@@ -567,7 +677,8 @@ public:
         return tmp.get(key);
     }
 
-    /*! Searches the container of given type T (one of those in props) for key and updates the associated value to v. */
+    /*! Searches the container of given type T (one of those in props) for key and updates the associated value to v
+    (and marks it dirty). */
     template<typename T>
     void set(typename setup_type::key_type key, const T& v)
     {
@@ -575,6 +686,34 @@ public:
         return tmp.set(key, v);
     }
 
+    /*! Marks the value of type T under key dirty - needed after changing the value directly (not by set()).
+    Throws keyNotFound if no such key exists. */
+    template<typename T>
+    void markDirty(typename setup_type::key_type key)
+    {
+        aux::holder_t<setup_type, T>& tmp = *this;
+        tmp.markDirty(key);
+    }
+    /*! Returns true if the value of type T under key is dirty.
+    Throws keyNotFound if no such key exists. */
+    template<typename T>
+    bool isDirty(typename setup_type::key_type key) const
+    {
+        const aux::holder_t<setup_type, T>& tmp = *this;
+        return tmp.isDirty(key);
+    }
+    /*! Returns true if any value in the props (or in the nested props) is dirty. */
+    bool isDirty() const
+    {
+        return list_type::anyDirty() || nested_type::anyDirty();
+    }
+    /*! Marks all the values in the props (and in the nested props) clean - e.g. after they were saved. */
+    void clearDirty()
+    {
+        list_type::clearDirty();
+        nested_type::clearDirty();
+    }
+
     // import methods from nested classes
     using list_type::set;
 
@@ -0,0 +1,694 @@
+#ifndef JJ_PROPS_BINARY_H
+#define JJ_PROPS_BINARY_H
+
+#include "jj/props.h"
+#include "jj/propsIndex.h"
+#include "jj/exception.h"
+#include "jj/string.h"
+#include "jj/binaryEncoding.h"
+#include <string>
+#include <list>
+#include <vector>
+#include <deque>
+#include <array>
+#include <sstream>
+#include <cstring>
+#include <type_traits>
+
+/*! Binary props format
+A compact alternative to the textual representation of textSerializer_t / textDeserializer_t. The props are written
+by binarySerializer_t (through traverse()) into a string of bytes and read back by binaryDeserializer_t from memory
+(e.g. a jj::mappedFile_t), the values are copied out of the data, nothing is parsed.
+
+The data start with the 4 byte magic "JJPB" followed by a format version byte. Then there is a sequence of records,
+each starting with a one byte type:
+'N' ... nested props; depth (varint, 1 for the props nested in the top props), key (string)
+'V' ... value; key (string), the length of the payload (varint), the payload
+A value belongs to the props of the closest preceding 'N' record (or to the top props if there is none), the path of
+the nested props is given by the keys of the preceding 'N' records of the lower depths (like [a/b] in the text).
+A payload is a type tag (one byte) followed by the data:
+'b' ... bool; one byte (0 or 1)
+'i' ... signed integer; signed varint
+'u' ... unsigned integer; varint
+'f' ... float; 4 bytes (IEEE 754, least significant first)
+'d' ... double; 8 bytes (IEEE 754, least significant first)
+'s' ... string; string
+'l' ... list (std::list, std::vector, std::deque, std::array); the number of elements (varint) followed by the
+        payloads of the elements
+'t' ... any other type as text (by the stream operator<<); string
+A custom type might write several payloads (see binarySerializer_t).
+The data might be a concatenation of several serializations (each starting with the magic), e.g. a full one followed by
+patches (see props::traverseDirty()) - they are read one after another into the same props.
+The varint, signed varint and string are the same as in the binary log (see jj/binaryEncoding.h).
+*/
+
+namespace jj
+{
+namespace props
+{
+namespace binary
+{
+/*! The magic at the beginning of the binary props. */
+const char MAGIC[4] = { 'J', 'J', 'P', 'B' };
+/*! The version of the format. */
+const unsigned char VERSION = 1;
+
+/*! The types of the records. */
+enum record_t
+{
+    REC_NESTED = 'N', //!< nested props
+    REC_VALUE = 'V' //!< value
+};
+
+/*! The type tags of the payloads. */
+enum tag_t
+{
+    TAG_BOOL = 'b', //!< bool
+    TAG_INT = 'i', //!< signed integer
+    TAG_UINT = 'u', //!< unsigned integer
+    TAG_FLOAT = 'f', //!< float
+    TAG_DOUBLE = 'd', //!< double
+    TAG_STRING = 's', //!< string
+    TAG_LIST = 'l', //!< list
+    TAG_TEXT = 't' //!< any other type as text
+};
+
+/*! Thrown on data which are not valid binary props. */
+struct format_error : public jj::exception::base
+{
+    /*! Ctor */
+    format_error(const char* what) : jj::exception::base(what) {}
+};
+
+using jj::binary::putVarint;
+using jj::binary::putSignedVarint;
+using jj::binary::putString;
+
+/*! Appends the lowest n bytes of the number (least significant first). */
+inline void putFixed(std::string& out, unsigned long long v, size_t n)
+{
+    for (size_t i = 0; i < n; ++i, v >>= 8)
+        out.push_back(static_cast<char>(v & 0xff));
+}
+/*! Reads the binary props from memory. A failed expect() (a payload of other type than expected) is remembered, the
+following expect() calls fail then too - so the reading of a value can just stop on the first failure. */
+class reader_t
+{
+    const char* p_; //!< the next byte
+    const char* end_; //!< the end of the data
+    bool mismatch_; //!< set by a failed expect()
+
+public:
+    /*! Ctor - no data. */
+    reader_t() : p_(nullptr), end_(nullptr), mismatch_(false) {}
+    /*! Ctor - reads the data between b and e. */
+    reader_t(const char* b, const char* e) : p_(b), end_(e), mismatch_(false) {}
+
+    /*! Starts reading the data between b and e (and forgets a failed expect()). */
+    void reset(const char* b, const char* e)
+    {
+        p_ = b;
+        end_ = e;
+        mismatch_ = false;
+    }
+    /*! Returns true if all the data were read. */
+    bool atEnd() const { return p_ == end_; }
+    /*! Returns the number of bytes not read yet. */
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+    /*! Reads a byte. */
+    unsigned char byte()
+    {
+        if (p_ == end_)
+            throw format_error("Unexpected end of binary props.");
+        return static_cast<unsigned char>(*p_++);
+    }
+    /*! Skips n bytes, returns the first of them. */
+    const char* bytes(unsigned long long n)
+    {
+        if (n > remaining())
+            throw format_error("Unexpected end of binary props.");
+        const char* ret = p_;
+        p_ += n;
+        return ret;
+    }
+    /*! Reads a varint. */
+    unsigned long long varint()
+    {
+        unsigned long long ret;
+        if (!jj::binary::getVarint([this]() { return byte(); }, ret))
+            throw format_error("Invalid number in binary props.");
+        return ret;
+    }
+    /*! Reads a signed varint. */
+    long long signedVarint() { return jj::binary::unzigzag(varint()); }
+    /*! Reads an n bytes long number (least significant first). */
+    unsigned long long fixed(size_t n)
+    {
+        const char* b = bytes(n);
+        unsigned long long ret = 0;
+        for (size_t i = n; i > 0; --i)
+            ret = (ret << 8) | static_cast<unsigned char>(b[i - 1]);
+        return ret;
+    }
+    /*! Reads a string. */
+    void string(std::string& out)
+    {
+        unsigned long long len = varint();
+        const char* b = bytes(len);
+        out.assign(b, static_cast<size_t>(len));
+    }
+    /*! Reads a string (converted from UTF-8). */
+    void string(std::wstring& out)
+    {
+        unsigned long long len = varint();
+        const char* b = bytes(len);
+        out = jj::strcvt::to_wstring(std::string(b, static_cast<size_t>(len)));
+    }
+
+    /*! Reads the type tag of a payload, returns true if it is the given one. Returns false if it is not (or if
+    a previous call failed already). */
+    bool expect(tag_t tag)
+    {
+        if (mismatch_)
+            return false;
+        if (byte() == static_cast<unsigned char>(tag))
+            return true;
+        mismatch_ = true;
+        return false;
+    }
+    /*! Returns true if an expect() call failed since the last reset(). */
+    bool mismatch() const { return mismatch_; }
+};
+} // namespace binary
+
+/*! Converts a props class with its values into the binary representation (see jj/propsBinary.h), which can be read
+back much faster than the textual one.
+
+It appends to the string given in ctor and uses the traverse() method to process all the values:
+std::string data;
+jj::props::binarySerializer_t s(data);
+jj::props::traversalContext_t<const jj::char_t*> ctx;
+yourprops.traverse(s, ctx);
+
+Integers, bool, float, double, strings and lists are supported directly, other types are written as text by their
+stream operator<<. To support custom types write a operator<< writing the members like this:
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const yourtype& v)
+{
+    return s << v.member1 << v.member2;
+}
+together with the operator>> for binaryDeserializer_t. */
+class binarySerializer_t
+{
+    std::string& out_; //!< where to write
+    std::string value_; //!< the payload of the value being written
+
+public:
+    /*! Ctor - writes the header into out. */
+    binarySerializer_t(std::string& out)
+        : out_(out)
+    {
+        out_.append(binary::MAGIC, sizeof(binary::MAGIC));
+        out_.push_back(static_cast<char>(binary::VERSION));
+    }
+
+    /*! Returns the payload of the value being written - to be used by the operator<< of the individual types. */
+    std::string& payload() { return value_; }
+
+    /*! Invoked by the traverse(), do not call directly. */
+    template<typename CTX, typename KEY, typename T>
+    void onValue(CTX& ctx, KEY key, const T& v);
+
+    /*! Invoked by the traverse(), do not call directly. */
+    template<typename CTX>
+    void onNestedBegin(CTX& ctx)
+    {
+        out_.push_back(static_cast<char>(binary::REC_NESTED));
+        binary::putVarint(out_, ctx.Dive.size());
+        binary::putString(out_, ctx.Dive.back());
+    }
+    /*! Invoked by the traverse(), do not call directly. */
+    template<typename CTX>
+    void onNestedEnd(CTX& ctx)
+    {
+    }
+};
+
+template<typename PROPS>
+class binaryDeserializer_t;
+
+namespace aux
+{
+/*! Writes (and reads) the payloads of the types without own operator<< (operator>>) - as text. */
+template<typename T, typename = void>
+struct binaryCodec_t
+{
+    static void write(std::string& out, const T& v)
+    {
+        std::ostringstream ss;
+        ss << v;
+        std::string tmp(ss.str());
+        out.push_back(static_cast<char>(binary::TAG_TEXT));
+        binary::putString(out, tmp.c_str(), tmp.length());
+    }
+    static void read(binary::reader_t& r, T& v)
+    {
+        if (!r.expect(binary::TAG_TEXT))
+            return;
+        std::string tmp;
+        r.string(tmp);
+        std::istringstream ss(tmp);
+        ss >> v;
+    }
+};
+/*! Writes (and reads) the payloads of signed integers. */
+template<typename T>
+struct binaryCodec_t<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type>
+{
+    static void write(std::string& out, T v)
+    {
+        out.push_back(static_cast<char>(binary::TAG_INT));
+        binary::putSignedVarint(out, static_cast<long long>(v));
+    }
+    static void read(binary::reader_t& r, T& v)
+    {
+        if (r.expect(binary::TAG_INT))
+            v = static_cast<T>(r.signedVarint());
+    }
+};
+/*! Writes (and reads) the payloads of unsigned integers. */
+template<typename T>
+struct binaryCodec_t<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value>::type>
+{
+    static void write(std::string& out, T v)
+    {
+        out.push_back(static_cast<char>(binary::TAG_UINT));
+        binary::putVarint(out, static_cast<unsigned long long>(v));
+    }
+    static void read(binary::reader_t& r, T& v)
+    {
+        if (r.expect(binary::TAG_UINT))
+            v = static_cast<T>(r.varint());
+    }
+};
+/*! Writes (and reads) the payloads of bool. */
+template<>
+struct binaryCodec_t<bool, void>
+{
+    static void write(std::string& out, bool v)
+    {
+        out.push_back(static_cast<char>(binary::TAG_BOOL));
+        out.push_back(v ? 1 : 0);
+    }
+    static void read(binary::reader_t& r, bool& v)
+    {
+        if (r.expect(binary::TAG_BOOL))
+            v = r.byte() != 0;
+    }
+};
+/*! Writes (and reads) the payloads of float. */
+template<>
+struct binaryCodec_t<float, void>
+{
+    static void write(std::string& out, float v)
+    {
+        static_assert(sizeof(float) == 4, "float is expected to be 4 bytes");
+        unsigned int bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        out.push_back(static_cast<char>(binary::TAG_FLOAT));
+        binary::putFixed(out, bits, sizeof(bits));
+    }
+    static void read(binary::reader_t& r, float& v)
+    {
+        if (!r.expect(binary::TAG_FLOAT))
+            return;
+        unsigned int bits = static_cast<unsigned int>(r.fixed(sizeof(bits)));
+        std::memcpy(&v, &bits, sizeof(bits));
+    }
+};
+/*! Writes (and reads) the payloads of double. */
+template<>
+struct binaryCodec_t<double, void>
+{
+    static void write(std::string& out, double v)
+    {
+        static_assert(sizeof(double) == 8, "double is expected to be 8 bytes");
+        unsigned long long bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        out.push_back(static_cast<char>(binary::TAG_DOUBLE));
+        binary::putFixed(out, bits, sizeof(bits));
+    }
+    static void read(binary::reader_t& r, double& v)
+    {
+        if (!r.expect(binary::TAG_DOUBLE))
+            return;
+        unsigned long long bits = r.fixed(sizeof(bits));
+        std::memcpy(&v, &bits, sizeof(bits));
+    }
+};
+
+/*! Helper - invokes the operator>> for the individual types on the payload of a value. */
+template<typename DESERIALIZER>
+struct binaryDeserializeAction_t
+{
+    DESERIALIZER& d_; //!< the actual binaryDeserializer_t
+    const char* b_; //!< the beginning of the payload
+    const char* e_; //!< the end of the payload
+
+    /*! Ctor */
+    binaryDeserializeAction_t(DESERIALIZER& d, const char* b, const char* e) : d_(d), b_(b), e_(e) {}
+
+    /*! Reads the payload into the value (each type reads from the beginning of the payload). */
+    template<typename T>
+    void operator() (T& v);
+};
+} // namespace aux
+
+/*! Reads the binary representation made by binarySerializer_t (see jj/propsBinary.h) into the values of the props.
+The data are taken from memory as a whole (e.g. from a jj::mappedFile_t), the values are copied out, no parsing is
+involved.
+
+Unlike the textual representation, each value carries the tag of its type - a value is only read into a value of the
+props with the same key and a matching type (so even the keys used for several types are read properly), the values
+of other types (e.g. after the type of a value changed) are skipped. Values of unknown keys are skipped too,
+unknown nested props throw keyNotFound.
+
+It uses the operator>> to deserialize the objects, for custom types define one reading the same as the operator<<
+for binarySerializer_t wrote, like
+template<typename P>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, yourtype& v)
+{
+    return d >> v.member1 >> v.member2;
+}
+The individual operator>> do nothing if the type tag of the payload does not match (see binary::reader_t::expect()). */
+template<typename PROPS>
+class binaryDeserializer_t
+{
+    typedef binaryDeserializer_t<PROPS> this_type;
+    typedef typename PROPS::setup_type::key_type key_type; //!< the keys of the props
+    typedef typename std::remove_const<typename std::remove_pointer<key_type>::type>::type key_char_type; //!< characters of the keys
+    typedef typename pathIndex_t<PROPS>::path_type path_type; //!< the paths in the index
+
+    /*! The nested props being read (of a depth). */
+    struct level_t
+    {
+        PROPS* Props; //!< the props (nullptr when reading into an index)
+        size_t Path; //!< the length of the path of the props in path_ (when reading into an index)
+    };
+
+    binary::reader_t data_; //!< the data
+    binary::reader_t value_; //!< the payload of the value being read
+    PROPS& ps_; //!< the top props
+    const pathIndex_t<PROPS>* index_; //!< the index of ps_ (nullptr if the props are searched level by level)
+    std::vector<level_t> levels_; //!< the nested props being read by depth (the top props first)
+    std::basic_string<key_char_type> key_; //!< the key of the actual record
+    path_type path_; //!< the path of the actual value (when reading into an index)
+
+    /*! Reads the whole data. */
+    void read();
+
+public:
+    /*! Ctor - reads the size bytes of data into props p.
+    Throws binary::format_error (derivate of jj::exception::base) if the data are not valid. */
+    binaryDeserializer_t(const char* data, size_t size, PROPS& p)
+        : data_(data, data + size), ps_(p), index_(nullptr)
+    {
+        read();
+    }
+    /*! Ctor - reads the size bytes of data into the props indexed by index (the values are found by the index
+    instead of searching the props level by level).
+    Throws binary::format_error (derivate of jj::exception::base) if the data are not valid. */
+    binaryDeserializer_t(const char* data, size_t size, pathIndex_t<PROPS>& index)
+        : data_(data, data + size), ps_(index.top()), index_(&index)
+    {
+        read();
+    }
+
+    /*! Returns the reader of the payload of the actual value - to be used by the operator>> of the individual types. */
+    binary::reader_t& payload() { return value_; }
+};
+
+} // namespace props
+} // namespace jj
+
+/*! Writes any value without own operator<< (integers, bool, float, double and everything else as text). */
+template<typename T>
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const T& v)
+{
+    jj::props::aux::binaryCodec_t<T>::write(s.payload(), v);
+    return s;
+}
+
+/*! Writes the string. */
+template<typename CH, typename TR, typename AL>
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const std::basic_string<CH, TR, AL>& v)
+{
+    s.payload().push_back(static_cast<char>(jj::props::binary::TAG_STRING));
+    jj::props::binary::putString(s.payload(), v.c_str(), v.length());
+    return s;
+}
+
+/*! Writes the list - the number of elements and the elements. */
+template<typename T>
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const std::list<T>& v)
+{
+    s.payload().push_back(static_cast<char>(jj::props::binary::TAG_LIST));
+    jj::props::binary::putVarint(s.payload(), v.size());
+    for (const T& x : v)
+        s << x;
+    return s;
+}
+
+/*! Writes the vector - the number of elements and the elements. */
+template<typename T, typename AL>
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const std::vector<T, AL>& v)
+{
+    s.payload().push_back(static_cast<char>(jj::props::binary::TAG_LIST));
+    jj::props::binary::putVarint(s.payload(), v.size());
+    for (const auto& x : v)
+        s << x;
+    return s;
+}
+
+/*! Writes the deque - the number of elements and the elements. */
+template<typename T, typename AL>
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const std::deque<T, AL>& v)
+{
+    s.payload().push_back(static_cast<char>(jj::props::binary::TAG_LIST));
+    jj::props::binary::putVarint(s.payload(), v.size());
+    for (const T& x : v)
+        s << x;
+    return s;
+}
+
+/*! Writes the array - the number of elements and the elements. */
+template<typename T, size_t N>
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const std::array<T, N>& v)
+{
+    s.payload().push_back(static_cast<char>(jj::props::binary::TAG_LIST));
+    jj::props::binary::putVarint(s.payload(), N);
+    for (const T& x : v)
+        s << x;
+    return s;
+}
+
+/*! Reads any value without own operator>> (integers, bool, float, double and everything else as text). */
+template<typename P, typename T>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, T& v)
+{
+    jj::props::aux::binaryCodec_t<T>::read(d.payload(), v);
+    return d;
+}
+
+/*! Reads the string. */
+template<typename P, typename CH, typename TR, typename AL>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, std::basic_string<CH, TR, AL>& v)
+{
+    if (d.payload().expect(jj::props::binary::TAG_STRING))
+        d.payload().string(v);
+    return d;
+}
+
+/*! Reads the list. The list is kept intact if the elements are of other type. */
+template<typename P, typename T>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, std::list<T>& v)
+{
+    jj::props::binary::reader_t& r = d.payload();
+    if (!r.expect(jj::props::binary::TAG_LIST))
+        return d;
+    unsigned long long n = r.varint();
+    std::list<T> tmp;
+    for (unsigned long long i = 0; i < n; ++i)
+    {
+        tmp.push_back(T());
+        d >> tmp.back();
+        if (r.mismatch())
+            return d;
+    }
+    v.swap(tmp);
+    return d;
+}
+
+/*! Reads the vector (the space for all the elements is allocated at once). The vector is kept intact if the elements
+are of other type. */
+template<typename P, typename T, typename AL>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, std::vector<T, AL>& v)
+{
+    jj::props::binary::reader_t& r = d.payload();
+    if (!r.expect(jj::props::binary::TAG_LIST))
+        return d;
+    unsigned long long n = r.varint();
+    if (n > r.remaining())
+        throw jj::props::binary::format_error("Invalid number of elements in binary props.");
+    std::vector<T, AL> tmp(static_cast<size_t>(n));
+    for (auto&& x : tmp)
+    {
+        T e;
+        d >> e;
+        if (r.mismatch())
+            return d;
+        x = std::move(e);
+    }
+    v.swap(tmp);
+    return d;
+}
+
+/*! Reads the deque. The deque is kept intact if the elements are of other type. */
+template<typename P, typename T, typename AL>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, std::deque<T, AL>& v)
+{
+    jj::props::binary::reader_t& r = d.payload();
+    if (!r.expect(jj::props::binary::TAG_LIST))
+        return d;
+    unsigned long long n = r.varint();
+    std::deque<T, AL> tmp;
+    for (unsigned long long i = 0; i < n; ++i)
+    {
+        tmp.push_back(T());
+        d >> tmp.back();
+        if (r.mismatch())
+            return d;
+    }
+    v.swap(tmp);
+    return d;
+}
+
+/*! Reads the array. The array is kept intact if the elements are of other type or their number is not N. */
+template<typename P, typename T, size_t N>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, std::array<T, N>& v)
+{
+    jj::props::binary::reader_t& r = d.payload();
+    if (!r.expect(jj::props::binary::TAG_LIST) || r.varint() != N)
+        return d;
+    std::array<T, N> tmp;
+    for (T& x : tmp)
+    {
+        d >> x;
+        if (r.mismatch())
+            return d;
+    }
+    v = std::move(tmp);
+    return d;
+}
+
+namespace jj
+{
+namespace props
+{
+
+template<typename CTX, typename KEY, typename T>
+void binarySerializer_t::onValue(CTX& ctx, KEY key, const T& v)
+{
+    value_.clear();
+    *this << v;
+    out_.push_back(static_cast<char>(binary::REC_VALUE));
+    binary::putString(out_, key);
+    binary::putVarint(out_, value_.size());
+    out_.append(value_);
+}
+
+namespace aux
+{
+template<typename DESERIALIZER>
+template<typename T>
+void binaryDeserializeAction_t<DESERIALIZER>::operator() (T& v)
+{
+    d_.payload().reset(b_, e_);
+    d_ >> v;
+}
+} // namespace aux
+
+template<typename PROPS>
+void binaryDeserializer_t<PROPS>::read()
+{
+    if (data_.remaining() < sizeof(binary::MAGIC) + 1 || std::memcmp(data_.bytes(sizeof(binary::MAGIC)), binary::MAGIC, sizeof(binary::MAGIC)) != 0)
+        throw binary::format_error("Not binary props.");
+    if (data_.byte() > binary::VERSION)
+        throw binary::format_error("Unsupported version of binary props.");
+
+    level_t top = { index_ == nullptr ? &ps_ : nullptr, 0 };
+    levels_.assign(1, top);
+    while (!data_.atEnd())
+    {
+        switch (data_.byte())
+        {
+        case binary::REC_NESTED:
+        {
+            unsigned long long depth = data_.varint();
+            if (depth == 0 || depth > levels_.size())
+                throw binary::format_error("Invalid depth of nested props in binary props.");
+            data_.string(key_);
+            levels_.resize(static_cast<size_t>(depth));
+            level_t l = levels_.back();
+            if (index_ != nullptr)
+            {
+                path_.resize(l.Path);
+                if (!path_.empty())
+                    path_ += jj::str::literals_t<typename path_type::value_type>::SLASH;
+                path_ += key_;
+                l.Path = path_.length();
+            }
+            else
+            {
+                l.Props = &l.Props->getNested(key_.c_str());
+            }
+            levels_.push_back(l);
+            break;
+        }
+        case binary::REC_VALUE:
+        {
+            data_.string(key_);
+            unsigned long long len = data_.varint();
+            const char* b = data_.bytes(len);
+            aux::binaryDeserializeAction_t<this_type> a(*this, b, b + len);
+            if (index_ != nullptr)
+            {
+                path_.resize(levels_.back().Path);
+                if (!path_.empty())
+                    path_ += jj::str::literals_t<typename path_type::value_type>::SLASH;
+                path_ += key_;
+                index_->apply(a, path_.c_str(), path_.length());
+            }
+            else
+            {
+                levels_.back().Props->apply(a, key_.c_str());
+            }
+            break;
+        }
+        case 'J': // the magic of a serialization concatenated to the previous one
+            if (data_.remaining() < sizeof(binary::MAGIC) || std::memcmp(data_.bytes(sizeof(binary::MAGIC) - 1), binary::MAGIC + 1, sizeof(binary::MAGIC) - 1) != 0)
+                throw binary::format_error("Invalid record in binary props.");
+            if (data_.byte() > binary::VERSION)
+                throw binary::format_error("Unsupported version of binary props.");
+            levels_.assign(1, top);
+            break;
+        default:
+            throw binary::format_error("Invalid record in binary props.");
+        }
+    }
+}
+
+} // namespace props
+} // namespace jj
+
+#endif // JJ_PROPS_BINARY_H
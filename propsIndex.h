@@ -0,0 +1,335 @@
+#ifndef JJ_PROPS_INDEX_H
+#define JJ_PROPS_INDEX_H
+
+#include "jj/props.h"
+#include <vector>
+#include <cctype>
+#include <cwctype>
+
+namespace jj
+{
+namespace props
+{
+
+namespace aux
+{
+/*! Folds the characters of paths so that the paths equal by the key comparison of the props (COMP) become equal. */
+template<typename COMP>
+struct pathFolding_t
+{
+    template<typename CH>
+    static CH fold(CH ch) { return ch; }
+};
+/*! Folds the characters of paths for the case insensitive props. */
+template<typename KEY>
+struct pathFolding_t<jj::str::lessiPred<KEY>>
+{
+    static char fold(char ch) { return static_cast<char>(std::tolower(static_cast<unsigned char>(ch))); }
+    static wchar_t fold(wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); }
+};
+
+/*! Gives the position of T in Ts as value (sizeof...(Ts) if T is not there). */
+template<typename T, typename ... Ts>
+struct typeIndex_t
+{
+    static const unsigned value = 0;
+};
+template<typename T, typename ... Ts>
+struct typeIndex_t<T, T, Ts...>
+{
+    static const unsigned value = 0;
+};
+template<typename T, typename U, typename ... Ts>
+struct typeIndex_t<T, U, Ts...>
+{
+    static const unsigned value = 1 + typeIndex_t<T, Ts...>::value;
+};
+
+/*! Calls an action with a value given as void* and the position of its type in Ts. */
+template<typename ... Ts>
+struct typeDispatch_t
+{
+    template<typename ACTION>
+    static void call(ACTION& a, unsigned index, void* v) {}
+};
+template<typename T, typename ... Ts>
+struct typeDispatch_t<T, Ts...>
+{
+    template<typename ACTION>
+    static void call(ACTION& a, unsigned index, void* v)
+    {
+        if (index == 0)
+            a(*static_cast<T*>(v));
+        else
+            typeDispatch_t<Ts...>::call(a, index - 1, v);
+    }
+};
+
+/*! Gives the types held by PROPS (a props instance). */
+template<typename PROPS>
+struct propsTypes_t;
+template<typename SETUP, typename ... Ts>
+struct propsTypes_t<props<SETUP, Ts...>>
+{
+    typedef typeDispatch_t<Ts...> dispatch_type; //!< calls actions by type index
+    static const unsigned count = sizeof...(Ts); //!< the number of types
+
+    /*! Gives the position of T in the types as value. */
+    template<typename T>
+    struct index_t : public typeIndex_t<T, Ts...>
+    {
+    };
+};
+} // namespace aux
+
+/*! A flat index of all the values in a hierarchy of props by their full path (the keys of the nested props and of the
+value joined by SEP like in pathWalker_t, e.g. "spec/colors/fore"). Unlike pathWalker_t, which searches the props on
+each level of the path, the index finds a value by a single hash lookup (open addressing) of the whole path.
+The index is built once, after all the values are registered, and does not change then - values added to the props
+later are not seen. It refers to the values, so the props have to outlive the index. */
+template<typename PROPS, typename CH = jj::char_t, CH SEP = jj::str::literals_t<CH>::SLASH>
+class pathIndex_t
+{
+public:
+    typedef CH char_type; //!< characters in the paths
+    typedef std::basic_string<char_type> path_type; //!< the type of the paths
+
+private:
+    typedef typename PROPS::setup_type setup_type;
+    typedef aux::pathFolding_t<typename setup_type::comp_type> folding_type;
+    typedef aux::propsTypes_t<PROPS> types_type;
+    static const unsigned NESTED = types_type::count; //!< the type of the entries of the nested props
+
+    /*! A value (or nested props) in the index. */
+    struct entry_t
+    {
+        path_type Path; //!< the full path
+        size_t Hash; //!< the hash of Path
+        unsigned Type; //!< the position of the type of the value in the props (or NESTED)
+        void* Value; //!< the value (nullptr for NESTED)
+        PROPS* Owner; //!< the props holding the value (to mark it dirty)
+        typename setup_type::key_type Key; //!< the key of the value in Owner
+    };
+
+    /*! Collects the entries while traversing the props. */
+    struct builder_t
+    {
+        pathIndex_t& Index; //!< where to add the entries
+        std::vector<PROPS*> Levels; //!< the props being traversed (the innermost last)
+
+        builder_t(pathIndex_t& index) : Index(index), Levels(1, &index.top_) {}
+
+        template<typename CTX>
+        void onNestedBegin(CTX& ctx)
+        {
+            Levels.push_back(Levels.back()->findNested(ctx.Dive.back()));
+            Index.add(path(ctx, nullptr), NESTED, nullptr, nullptr, nullptr);
+        }
+        template<typename CTX>
+        void onNestedEnd(CTX& ctx) { Levels.pop_back(); }
+        template<typename CTX, typename T>
+        void onValue(CTX& ctx, typename setup_type::key_type key, const T& v)
+        {
+            // the values are registered by non-const references, just the traversal gives them as const
+            Index.add(path(ctx, key), types_type::template index_t<T>::value, const_cast<T*>(&v), Levels.back(), key);
+        }
+
+        /*! Returns the path of the context (and the key if not nullptr). */
+        template<typename CTX>
+        static path_type path(CTX& ctx, typename setup_type::key_type key)
+        {
+            path_type ret;
+            for (auto& k : ctx.Dive)
+            {
+                if (!ret.empty())
+                    ret += SEP;
+                ret += k;
+            }
+            if (key != nullptr)
+            {
+                if (!ret.empty())
+                    ret += SEP;
+                ret += key;
+            }
+            return ret;
+        }
+    };
+
+    PROPS& top_; //!< the indexed props
+    std::vector<entry_t> entries_; //!< all the values and nested props
+    std::vector<unsigned> buckets_; //!< the hash table - positions in entries_ plus one (0 = empty bucket)
+    size_t mask_; //!< the size of buckets_ minus one (the size is a power of 2)
+    size_t values_; //!< the number of values in entries_
+
+    /*! Returns the hash of the path. */
+    static size_t hash(const char_type* path, size_t len)
+    {
+        unsigned long long h = 14695981039346656037ULL; // FNV-1a
+        for (size_t i = 0; i < len; ++i)
+        {
+            h ^= static_cast<unsigned long long>(folding_type::fold(path[i]));
+            h *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+    /*! Returns true if the entry has the given path. */
+    static bool matches(const entry_t& e, size_t h, const char_type* path, size_t len)
+    {
+        if (e.Hash != h || e.Path.length() != len)
+            return false;
+        for (size_t i = 0; i < len; ++i)
+            if (folding_type::fold(e.Path[i]) != folding_type::fold(path[i]))
+                return false;
+        return true;
+    }
+
+    /*! Adds an entry (the hash table is built later). */
+    void add(const path_type& path, unsigned type, void* value, PROPS* owner, typename setup_type::key_type key)
+    {
+        entry_t e;
+        e.Path = path;
+        e.Hash = hash(path.c_str(), path.length());
+        e.Type = type;
+        e.Value = value;
+        e.Owner = owner;
+        e.Key = key;
+        entries_.push_back(e);
+        if (type != NESTED)
+            ++values_;
+    }
+
+    /*! Calls f for each entry with the given path until it returns true. Returns true if f did. */
+    template<typename F>
+    bool each(const char_type* path, size_t len, F f) const
+    {
+        size_t h = hash(path, len);
+        for (size_t b = h & mask_; buckets_[b] != 0; b = (b + 1) & mask_)
+        {
+            const entry_t& e = entries_[buckets_[b] - 1];
+            if (matches(e, h, path, len) && f(e))
+                return true;
+        }
+        return false;
+    }
+    /*! Returns the entry of the path with the given type or nullptr. */
+    const entry_t* lookup(const char_type* path, size_t len, unsigned type) const
+    {
+        const entry_t* ret = nullptr;
+        each(path, len, [&ret, type](const entry_t& e) {
+            if (e.Type != type)
+                return false;
+            ret = &e;
+            return true;
+        });
+        return ret;
+    }
+    /*! Returns the entry of the value of type T at the path. Throws keyNotFound if there is none. */
+    template<typename T>
+    const entry_t& entry(const path_type& path) const
+    {
+        const entry_t* ret = lookup(path.c_str(), path.length(), types_type::template index_t<T>::value);
+        if (ret == nullptr)
+            throw exception::keyNotFound(path.c_str());
+        return *ret;
+    }
+
+public:
+    /*! Ctor - indexes all the values in the props (and in all nested props). */
+    explicit pathIndex_t(PROPS& top)
+        : top_(top), mask_(0), values_(0)
+    {
+        builder_t b(*this);
+        traversalContext_t<typename setup_type::key_type> ctx;
+        top_.traverse(b, ctx);
+
+        size_t size = 8;
+        while (size < entries_.size() * 2)
+            size <<= 1;
+        buckets_.assign(size, 0);
+        mask_ = size - 1;
+        for (size_t i = 0; i < entries_.size(); ++i)
+        {
+            size_t b = entries_[i].Hash & mask_;
+            while (buckets_[b] != 0)
+                b = (b + 1) & mask_;
+            buckets_[b] = static_cast<unsigned>(i + 1);
+        }
+    }
+    pathIndex_t(const pathIndex_t&) = delete;
+    pathIndex_t& operator=(const pathIndex_t&) = delete;
+
+    /*! Returns the indexed props. */
+    PROPS& top() { return top_; }
+    /*! Returns the number of indexed values. */
+    size_t size() const { return values_; }
+
+    /*! Returns the value of type T at the path or nullptr if there is none. */
+    template<typename T>
+    T* find(const char_type* path, size_t len) const
+    {
+        const entry_t* e = lookup(path, len, types_type::template index_t<T>::value);
+        return e == nullptr ? nullptr : static_cast<T*>(e->Value);
+    }
+    /*! Returns the value of type T at the path or nullptr if there is none. */
+    template<typename T>
+    T* find(const path_type& path) const { return find<T>(path.c_str(), path.length()); }
+    /*! Returns the value of type T at the path. Throws keyNotFound if there is none. */
+    template<typename T>
+    T& get(const path_type& path) const
+    {
+        T* ret = find<T>(path.c_str(), path.length());
+        if (ret == nullptr)
+            throw exception::keyNotFound(path.c_str());
+        return *ret;
+    }
+    /*! Updates the value of type T at the path and marks it dirty (like props::set()).
+    Throws keyNotFound if there is none. */
+    template<typename T>
+    void set(const path_type& path, const T& v) const
+    {
+        const entry_t& e = entry<T>(path);
+        *static_cast<T*>(e.Value) = v;
+        e.Owner->template markDirty<T>(e.Key);
+    }
+    /*! Marks the value of type T at the path dirty - needed after changing it through find() or get().
+    Throws keyNotFound if there is none. */
+    template<typename T>
+    void markDirty(const path_type& path) const
+    {
+        const entry_t& e = entry<T>(path);
+        e.Owner->template markDirty<T>(e.Key);
+    }
+    /*! Returns true if there are nested props at the path. */
+    bool hasNested(const char_type* path, size_t len) const { return lookup(path, len, NESTED) != nullptr; }
+
+    /*! Calls the action for the values of all types at the path (like pathWalker_t::apply()). Does nothing if there
+    is no value at the path, but throws keyNotFound if there are no nested props at the path without the last segment. */
+    template<typename ACTION>
+    void apply(ACTION& a, const char_type* path, size_t len) const
+    {
+        bool found = false;
+        each(path, len, [&a, &found](const entry_t& e) {
+            if (e.Type != NESTED)
+            {
+                types_type::dispatch_type::call(a, e.Type, e.Value);
+                found = true;
+            }
+            return false;
+        });
+        if (found)
+            return;
+        size_t parent = len;
+        while (parent > 0 && path[parent - 1] != SEP)
+            --parent;
+        if (parent > 0 && !hasNested(path, parent - 1))
+            throw exception::keyNotFound(path_type(path, parent - 1).c_str());
+    }
+    /*! Calls the action for the values of all types at the path (like pathWalker_t::apply()). */
+    template<typename ACTION>
+    void apply(ACTION& a, const path_type& path) const { apply(a, path.c_str(), path.length()); }
+};
+
+} // namespace props
+} // namespace jj
+
+#endif // JJ_PROPS_INDEX_H
@@ -0,0 +1,153 @@
+#ifndef JJ_PROPS_PARALLEL_DESERIALIZER_H
+#define JJ_PROPS_PARALLEL_DESERIALIZER_H
+
+#include "jj/propsTextDeserializer.h"
+#include "jj/source.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+namespace jj
+{
+namespace props
+{
+
+/*! Reads the textual representation made by textSerializer_t from memory (e.g. a jj::mappedFile_t) by several threads.
+The input is split into parts at the section headers ([a/b]) in one pass, the parts are parsed in parallel (by
+textDeserializer_t) into staged values and those are stored into the props in the order of the input once all
+parts are parsed. So the result is the same as of a single textDeserializer_t - a value given more times ends with
+the last one and on an error the values before it are stored and the same exception is thrown (only the value
+being read when the error occurred is left untouched).
+While reading, the props are only searched, they (and the values in them) shall not be changed by other threads. */
+template<typename PROPS, typename CH = jj::char_t>
+class parallelTextDeserializer_t
+{
+public:
+    typedef CH char_type; //!< characters of the input
+    typedef jj::bufferSource_t<char_type> source_type; //!< the source of the individual parts
+    typedef textDeserializer_t<source_type, PROPS> deserializer_type; //!< reads the individual parts
+
+    static const size_t MIN_PART = 16384; //!< the minimal length of a part (in characters), the sections are joined up to it
+
+private:
+    /*! A part of the input parsed by one thread. */
+    struct part_t
+    {
+        const char_type* Begin; //!< the first character
+        const char_type* End; //!< after the last character
+        typename deserializer_type::staging_type Staged; //!< the values read
+        std::exception_ptr Error; //!< the error which stopped the parsing (if any)
+
+        part_t(const char_type* b, const char_type* e) : Begin(b), End(e) {}
+    };
+
+    PROPS& ps_; //!< the props into which the input is read
+    pathIndex_t<PROPS>* index_; //!< the index of ps_ (nullptr if the props are searched by pathWalker_t)
+    std::vector<part_t> parts_; //!< the parts of the input
+
+    /*! Splits the input into parts of about the given length - each part (but the first) starts with a section header. */
+    void split(const char_type* b, const char_type* e, size_t length)
+    {
+        const char_type nl = jj::str::literals_t<char_type>::NL;
+        const char_type* start = b;
+        for (const char_type* p = b; p != e; )
+        {
+            // p is at the beginning of a line
+            const char_type* line = p;
+            while (p != e && *p != nl && jj::str::isspace(*p))
+                ++p;
+            if (p != e && *p == jj::str::literals_t<char_type>::LSB && static_cast<size_t>(line - start) >= length)
+            {
+                parts_.emplace_back(start, line);
+                start = line;
+            }
+            p = std::char_traits<char_type>::find(p, static_cast<size_t>(e - p), nl);
+            p = (p == nullptr ? e : p + 1);
+        }
+        parts_.emplace_back(start, e);
+    }
+
+    /*! Parses the part into its staged values. */
+    void parse(part_t& part)
+    {
+        try
+        {
+            source_type src(part.Begin, part.End);
+            deserializer_type des(src, ps_, index_, part.Staged);
+        }
+        catch (...)
+        {
+            part.Error = std::current_exception();
+        }
+    }
+
+    /*! Reads the input by up to the given number of threads. */
+    void read(const char_type* b, const char_type* e, unsigned threads)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+        if (threads == 1)
+        {
+            // nothing to parallelize - read right into the props
+            source_type src(b, e);
+            if (index_ != nullptr)
+                deserializer_type des(src, *index_);
+            else
+                deserializer_type des(src, ps_);
+            return;
+        }
+        size_t length = static_cast<size_t>(e - b) / (threads * 4);
+        if (length < MIN_PART)
+            length = MIN_PART;
+        split(b, e, length);
+
+        std::atomic<size_t> next(0);
+        auto work = [this, &next]() {
+            for (size_t i = next++; i < parts_.size(); i = next++)
+                parse(parts_[i]);
+        };
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads && i < parts_.size(); ++i)
+            workers.emplace_back(work);
+        work();
+        for (auto& w : workers)
+            w.join();
+
+        for (auto& part : parts_)
+        {
+            for (auto& v : part.Staged)
+                v->commit();
+            if (part.Error)
+                std::rethrow_exception(part.Error);
+        }
+    }
+
+public:
+    /*! Ctor - reads the input between b and e into props p by up to the given number of threads (0 = as many as
+    the hardware runs concurrently).
+    Throws what textDeserializer_t throws. */
+    parallelTextDeserializer_t(const char_type* b, const char_type* e, PROPS& p, unsigned threads = 0)
+        : ps_(p), index_(nullptr)
+    {
+        read(b, e, threads);
+    }
+    /*! Ctor - reads the input between b and e into the props indexed by index by up to the given number of threads
+    (0 = as many as the hardware runs concurrently).
+    Throws what textDeserializer_t throws. */
+    parallelTextDeserializer_t(const char_type* b, const char_type* e, pathIndex_t<PROPS>& index, unsigned threads = 0)
+        : ps_(index.top()), index_(&index)
+    {
+        read(b, e, threads);
+    }
+
+    /*! Returns the number of parts the input was split into (0 if it was read by a single thread). */
+    size_t parts() const { return parts_.size(); }
+};
+
+} // namespace props
+} // namespace jj
+
+#endif // JJ_PROPS_PARALLEL_DESERIALIZER_H
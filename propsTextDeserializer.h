@@ -2,7 +2,16 @@
 #define JJ_PROPS_TEXT_DESERIALIZER_H
 
 #include "jj/props.h"
+#include "jj/propsIndex.h"
+#include "jj/source.h"
 #include <type_traits>
+#include <functional>
+#include <memory>
+#include <map>
+#include <vector>
+#include <deque>
+#include <array>
+#include <algorithm>
 
 namespace jj
 {
@@ -27,10 +36,55 @@ struct deserializeAction_t
     }
 };
 
+/*! A value read but not stored into the props yet (see textDeserializer_t::staging_type). */
+struct stagedValue_base_t
+{
+    virtual ~stagedValue_base_t() {}
+    /*! Stores the value into the props. */
+    virtual void commit() = 0;
+};
+
+/*! A value of type T read but not stored into the props yet. */
+template<typename T>
+struct stagedValue_t : public stagedValue_base_t
+{
+    T* Target; //!< the value in the props
+    T Value; //!< the value read (starts as a copy of the target)
+
+    /*! Ctor */
+    stagedValue_t(T& target) : Target(&target), Value(target) {}
+    virtual void commit() override { *Target = std::move(Value); }
+};
+
+/*! Helper - reads the values into stagedValue_t instead of the props. */
+template<typename STREAM>
+struct stageAction_t
+{
+    STREAM& s_; //!< the actual textDeserializer_t
+    std::vector<std::unique_ptr<stagedValue_base_t>>& staged_; //!< where to add the values
+    /*! Ctor */
+    stageAction_t(STREAM& s, std::vector<std::unique_ptr<stagedValue_base_t>>& staged) : s_(s), staged_(staged) {}
+
+    /*! Invokes the operator>> for individual types and textDeserializer_t on a copy of the value */
+    template<typename T>
+    void operator() (T& v)
+    {
+        std::unique_ptr<stagedValue_t<T>> st(new stagedValue_t<T>(v));
+        s_ >> st->Value;
+        staged_.push_back(std::move(st));
+    }
+};
+
+/*! Reads the elements of a list value (like "1,2,3") from the deserializer s calling f for each. */
+template<typename T, typename DESERIALIZER, typename F>
+void readElements(DESERIALIZER& s, F& f);
+
 } // namespace aux
 
 /*! Reads the textual representation made by textSerializer_t into real values represented by objects.
 See textSerializer_t for the syntax of the textual representation. 
+With a source derived from jj::bufferSource_t (like jj::fileSource_t reading a memory mapped file) the names and the
+string values are scanned directly in the buffer, without reading it character by character.
 
 It uses the operator>> to deserialize the objects, for custom types you shall define one like
 template<typename S, typename P>
@@ -39,7 +93,7 @@ jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S,
     ...
     return s;
 }
-(note the S is assumed to be a jj::streamSource_t instance)
+(note the S is assumed to be a jj::streamSource_t or a jj::bufferSource_t instance)
 or the regular stream operator>> like
 template<typename CH, typename TR>
 std::basic_istream<CH, TR>& operator>>(std::basic_istream<CH, TR>& s, yourtype& v)
@@ -47,6 +101,13 @@ std::basic_istream<CH, TR>& operator>>(std::basic_istream<CH, TR>& s, yourtype&
     ...
     return s;
 }
+
+Huge files can be read in bounded memory: a jj::chunkedSource_t reads the file by blocks and the elements of the list
+values can be passed one by one to callbacks (elementSinks_t) instead of being collected in the props:
+typedef textDeserializer_t<jj::chunkedSource_t<std::ifstream>, yourprops> deserializer_t;
+deserializer_t::elementSinks_t sinks;
+sinks.add<int>("data/samples", [&](int& v) { ... });
+deserializer_t d(src, ps, sinks);
 */
 template<typename SOURCE, typename PROPS>
 class textDeserializer_t
@@ -54,8 +115,61 @@ class textDeserializer_t
     typedef typename SOURCE::char_type char_type; //!< character type of the underlying stream
     typedef std::basic_string<char_type> string_type; //!< the string type of character type equivalent to the stream's char_type
     typedef textDeserializer_t<SOURCE, PROPS> this_type; //!< refers to the type of this class
+
+public:
+    typedef SOURCE source_type; //!< the type of the source
+    typedef std::vector<std::unique_ptr<aux::stagedValue_base_t>> staging_type; //!< the values read but not stored yet
+
+    /*! The callbacks receiving the elements of list values one by one, by the full path of the value (like
+    "spec/numbers", case sensitive). A value with a callback is not stored into the props (the path does not even
+    have to exist in the props), so only one element at a time is held in memory. */
+    class elementSinks_t
+    {
+    public:
+        /*! Reads the elements of a value. */
+        struct sink_base_t
+        {
+            virtual ~sink_base_t() {}
+            /*! Reads all the elements of the value from the deserializer. */
+            virtual void read(this_type& s) = 0;
+        };
+
+    private:
+        /*! Passes the elements of type T to a callback. */
+        template<typename T>
+        struct sink_t : public sink_base_t
+        {
+            std::function<void(T&)> Callback; //!< receives the elements
+            sink_t(const std::function<void(T&)>& callback) : Callback(callback) {}
+            virtual void read(this_type& s) override { aux::readElements<T>(s, Callback); }
+        };
+
+        std::map<string_type, std::unique_ptr<sink_base_t>> sinks_; //!< the sinks by path
+
+    public:
+        /*! Sets the callback receiving the elements (of type T) of the list value at the path. The callback gets each
+        element once it is read (it can move it away). */
+        template<typename T>
+        void add(const string_type& path, const std::function<void(T&)>& callback)
+        {
+            sinks_[path].reset(new sink_t<T>(callback));
+        }
+        /*! Returns the sink of the path or nullptr if there is none. */
+        sink_base_t* find(const string_type& path) const
+        {
+            if (sinks_.empty())
+                return nullptr;
+            auto it = sinks_.find(path);
+            return it == sinks_.end() ? nullptr : it->second.get();
+        }
+    };
+
+private:
     SOURCE& src_; //!< the stored source stream
     PROPS& ps_; //!< the props into which the stream is read
+    const pathIndex_t<PROPS>* index_; //!< the index of ps_ (nullptr if the props are searched by pathWalker_t)
+    const elementSinks_t* sinks_; //!< the callbacks of the list values (nullptr if none)
+    staging_type* staging_; //!< where to put the values read (nullptr if they are stored into the props right away)
 
     // the lexer part of this class
 
@@ -71,7 +185,9 @@ class textDeserializer_t
         SLASH, //!< /
         NAME //!< a sequence like [A-Za-z0-9]([-_A-Za-z0-9]*)
     };
-    string_type v_; //!< if NAME is read then this contains the actual value read
+    string_type v_; //!< if NAME is read from a stream source then this contains the actual value read
+    const char_type* name_; //!< if NAME is read then this points to the beginning of its value (into v_ or the source buffer)
+    const char_type* nameEnd_; //!< if NAME is read then this points after the end of its value
 
     /*! Check if ch can start a NAME. */
     bool isNameStart(char_type ch)
@@ -106,22 +222,41 @@ class textDeserializer_t
                 return SBRACKETCLOSE;
             if (isNameStart(ch))
             {
-                v_.assign(1, ch);
-                while (src_.get(ch))
-                {
-                    if (!isNameContinue(ch))
-                    {
-                        src_.unget();
-                        break;
-                    }
-                    v_ += ch;
-                }
+                readName(ch, typename jj::isBufferSource_t<SOURCE>::type());
                 return NAME;
             }
             return INVALID;
         }
     }
 
+    /*! Reads the rest of a NAME starting with ch (already read) from a stream source. */
+    void readName(char_type ch, std::false_type)
+    {
+        v_.assign(1, ch);
+        while (src_.get(ch))
+        {
+            if (!isNameContinue(ch))
+            {
+                src_.unget();
+                break;
+            }
+            v_ += ch;
+        }
+        name_ = v_.data();
+        nameEnd_ = name_ + v_.length();
+    }
+    /*! Reads the rest of a NAME (its first character already read) from a buffer source - the NAME is not copied. */
+    void readName(char_type, std::true_type)
+    {
+        const char_type* p = src_.position();
+        const char_type* end = src_.end();
+        name_ = p - 1;
+        while (p != end && isNameContinue(*p))
+            ++p;
+        src_.seek(p);
+        nameEnd_ = p;
+    }
+
     // the parser part of the class
 
     /*! Thrown if the input syntax does not conform with the grammar. */
@@ -161,6 +296,20 @@ class textDeserializer_t
     }
 
     string_type cpath_; //!< holds the current path (for nested props), empty if processing the top props
+    string_type path_; //!< the full path of the value being read
+
+    /*! Applies the action on the value(s) at path_. */
+    template<typename ACTION>
+    void locate(ACTION& a)
+    {
+        if (index_ != nullptr)
+            index_->apply(a, path_.c_str(), path_.length());
+        else
+        {
+            pathWalker_t<PROPS> walk(ps_);
+            walk.apply(a, path_);
+        }
+    }
 
     /*! Parses the input and deserializes all values (stores into props) as part of the process. */
     void read()
@@ -176,7 +325,7 @@ class textDeserializer_t
             if (tok == SBRACKETOPEN)
             {
                 expect(NAME);
-                cpath_.assign(v_);
+                cpath_.assign(name_, nameEnd_);
                 while (true)
                 {
                     tok = expect(SBRACKETCLOSE, SLASH);
@@ -190,20 +339,42 @@ class textDeserializer_t
                         // must be a slash
                         expect(NAME);
                         cpath_ += jj::str::literals_t<char_type>::SLASH;
-                        cpath_ += v_;
+                        cpath_.append(name_, nameEnd_);
                     }
                 }
                 continue; // done reading section
             }
             if (tok == NAME)
             {
-                string_type key(v_);
+                path_.assign(cpath_);
+                if (!path_.empty())
+                    path_ += jj::str::literals_t<char_type>::SLASH;
+                path_.append(name_, nameEnd_);
                 expect(EQUALSIGN);
 
+                // pass the elements to the callback if any
+                if (sinks_ != nullptr)
+                {
+                    typename elementSinks_t::sink_base_t* sink = sinks_->find(path_);
+                    if (sink != nullptr)
+                    {
+                        sink->read(*this);
+                        expect(ENDOFLINE, ENDOFFILE);
+                        continue;
+                    }
+                }
+
                 // locate the actual property and invoke it's deserialization
-                pathWalker_t<PROPS> walk(ps_);
-                aux::deserializeAction_t<this_type> a(*this);
-                walk.apply(a, cpath_.empty() ? key : cpath_ + jj::str::literals_t<char_type>::SLASH + key);
+                if (staging_ != nullptr)
+                {
+                    aux::stageAction_t<this_type> a(*this, *staging_);
+                    locate(a);
+                }
+                else
+                {
+                    aux::deserializeAction_t<this_type> a(*this);
+                    locate(a);
+                }
 
                 expect(ENDOFLINE, ENDOFFILE);
             }
@@ -214,7 +385,33 @@ public:
     /*! Ctor - reads the given source stream s and stores contents into props p.
     Throws syntax_error (derivate of std::exception) in case of an syntax error. */
     textDeserializer_t(SOURCE& s, PROPS& p)
-        : src_(s), ps_(p)
+        : src_(s), ps_(p), index_(nullptr), sinks_(nullptr), staging_(nullptr), name_(nullptr), nameEnd_(nullptr)
+    {
+        read();
+    }
+    /*! Ctor - reads the given source stream s and stores contents into props p, except the list values with a callback
+    in sinks, whose elements are passed to the callback.
+    Throws syntax_error (derivate of std::exception) in case of an syntax error. */
+    textDeserializer_t(SOURCE& s, PROPS& p, const elementSinks_t& sinks)
+        : src_(s), ps_(p), index_(nullptr), sinks_(&sinks), staging_(nullptr), name_(nullptr), nameEnd_(nullptr)
+    {
+        read();
+    }
+    /*! Ctor - reads the given source stream s and stores contents into the props indexed by index (the values are
+    found by the index instead of searching the props level by level, which pays off when reading many values).
+    Throws syntax_error (derivate of std::exception) in case of an syntax error. */
+    textDeserializer_t(SOURCE& s, pathIndex_t<PROPS>& index)
+        : src_(s), ps_(index.top()), index_(&index), sinks_(nullptr), staging_(nullptr), name_(nullptr), nameEnd_(nullptr)
+    {
+        read();
+    }
+
+    /*! Ctor - reads the given source stream s, but instead of storing the values into props p (found by the index if
+    not nullptr) adds them to staging - to be stored later by calling their commit(). The props are not changed, so
+    several sources can be read into the same props in parallel (see parallelTextDeserializer_t).
+    Throws syntax_error (derivate of std::exception) in case of an syntax error. */
+    textDeserializer_t(SOURCE& s, PROPS& p, const pathIndex_t<PROPS>* index, staging_type& staging)
+        : src_(s), ps_(p), index_(index), sinks_(nullptr), staging_(&staging), name_(nullptr), nameEnd_(nullptr)
     {
         read();
     }
@@ -241,12 +438,18 @@ jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S,
     return s;
 }
 
-template<typename S, typename P, typename CH, typename TR, typename AL>
-jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S, P>& s, std::basic_string<CH, TR, AL>& v)
+namespace jj
+{
+namespace props
+{
+namespace aux
+{
+
+/*! Reads a quoted string (with escapes) from a stream source. */
+template<typename S, typename CH, typename TR, typename AL>
+void readString(S& str, std::basic_string<CH, TR, AL>& v, std::false_type)
 {
-    S& str = s.source();
     typedef typename S::char_type char_type;
-    static_assert(std::is_same<char_type, CH>::value, "Must be of same character type!");
     char_type ch;
     if (!str.get(ch) || ch != jj::str::literals_t<char_type>::QUOTE)
         throw jj::exception::base("Expected a '\"'.");
@@ -284,6 +487,66 @@ jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S,
     }
     if (!done)
         throw jj::exception::base("Expected a '\"'.");
+}
+
+/*! Reads a quoted string (with escapes) from a buffer source - the runs of characters without escapes are copied at once. */
+template<typename S, typename CH, typename TR, typename AL>
+void readString(S& str, std::basic_string<CH, TR, AL>& v, std::true_type)
+{
+    typedef typename S::char_type char_type;
+    const char_type* p = str.position();
+    const char_type* end = str.end();
+    if (p == end || *p != jj::str::literals_t<char_type>::QUOTE)
+        throw jj::exception::base("Expected a '\"'.");
+    v.clear();
+    const char_type* run = ++p; // the characters not copied into v yet
+    while (p != end)
+    {
+        char_type ch = *p;
+        if (ch == jj::str::literals_t<char_type>::NL)
+            throw jj::exception::base("Unexpected newline, a '\"' was expected.");
+        if (ch == jj::str::literals_t<char_type>::QUOTE)
+        {
+            v.append(run, p);
+            str.seek(p + 1);
+            return;
+        }
+        if (ch != jj::str::literals_t<char_type>::BSLASH)
+        {
+            ++p;
+            continue;
+        }
+        v.append(run, p);
+        if (++p == end)
+            break;
+        ch = *p;
+        if (ch == jj::str::literals_t<char_type>::NL)
+            throw jj::exception::base("Unexpected newline, a '\"' was expected.");
+        if (ch == jj::str::literals_t<char_type>::BSLASH || ch == jj::str::literals_t<char_type>::QUOTE)
+            v += ch;
+        else if (ch == jj::str::literals_t<char_type>::n)
+            v += jj::str::literals_t<char_type>::NL;
+        else
+        {
+            // unknown escape, fallback
+            v += jj::str::literals_t<char_type>::BSLASH;
+            v += ch;
+        }
+        run = ++p;
+    }
+    throw jj::exception::base("Expected a '\"'.");
+}
+
+} // namespace aux
+} // namespace props
+} // namespace jj
+
+template<typename S, typename P, typename CH, typename TR, typename AL>
+jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S, P>& s, std::basic_string<CH, TR, AL>& v)
+{
+    typedef typename S::char_type char_type;
+    static_assert(std::is_same<char_type, CH>::value, "Must be of same character type!");
+    jj::props::aux::readString(s.source(), v, typename jj::isBufferSource_t<S>::type());
     return s;
 }
 
@@ -294,12 +557,11 @@ namespace props
 namespace aux
 {
 
-template<typename S, typename P, typename C, typename T>
-inline void readContainer(jj::props::textDeserializer_t<S, P>& s, C& c)
+template<typename T, typename DESERIALIZER, typename F>
+void readElements(DESERIALIZER& s, F& f)
 {
-    S& src = s.source();
-    typedef typename S::char_type char_type;
-    c.clear();
+    auto& src = s.source();
+    typedef typename DESERIALIZER::source_type::char_type char_type;
 
     // check for empty container
     char_type ch;
@@ -313,9 +575,11 @@ inline void readContainer(jj::props::textDeserializer_t<S, P>& s, C& c)
     src.unget();
 
     // otherwise read the first element
-    T x;
-    s >> x;
-    c.push_back(x);
+    {
+        T x;
+        s >> x;
+        f(x);
+    }
 
     // now read all the remaining elements
     while (src.get(ch))
@@ -329,13 +593,40 @@ inline void readContainer(jj::props::textDeserializer_t<S, P>& s, C& c)
         {
             T x;
             s >> x;
-            c.push_back(x);
+            f(x);
         }
         else
             throw jj::exception::base("Syntax error. Expected ',' or newline.");
     }
 }
 
+template<typename S, typename P, typename C, typename T>
+inline void readContainer(jj::props::textDeserializer_t<S, P>& s, C& c)
+{
+    c.clear();
+    auto add = [&c](T& x) { c.push_back(std::move(x)); };
+    readElements<T>(s, add);
+}
+
+/*! Reserves the space for the elements of the value in a buffer source - by the number of commas till the end of
+line (which is enough even if some of them are within the elements). */
+template<typename S, typename C>
+inline void reserveElements(S& src, C& c, std::true_type)
+{
+    typedef typename S::char_type char_type;
+    const char_type nl = jj::str::literals_t<char_type>::NL, comma = jj::str::literals_t<char_type>::COMMA;
+    const char_type* p = src.position();
+    const char_type* end = std::char_traits<char_type>::find(p, static_cast<size_t>(src.end() - p), nl);
+    if (end == nullptr)
+        end = src.end();
+    c.reserve(static_cast<size_t>(std::count(p, end, comma)) + 1);
+}
+/*! Does nothing for a stream source - the elements cannot be counted ahead. */
+template<typename S, typename C>
+inline void reserveElements(S&, C&, std::false_type)
+{
+}
+
 } // namespace aux
 } // namespace props
 } // namespace jj
@@ -347,4 +638,38 @@ jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S,
     return s;
 }
 
+/*! Reads the vector - with a buffer source the space for all the elements is reserved ahead, otherwise it grows
+geometrically (and the capacity is kept from previous reads). */
+template<typename S, typename P, typename T, typename AL>
+jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S, P>& s, std::vector<T, AL>& v)
+{
+    v.clear();
+    jj::props::aux::reserveElements(s.source(), v, typename jj::isBufferSource_t<S>::type());
+    jj::props::aux::readContainer<S, P, std::vector<T, AL>, T>(s, v);
+    return s;
+}
+
+template<typename S, typename P, typename T, typename AL>
+jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S, P>& s, std::deque<T, AL>& v)
+{
+    jj::props::aux::readContainer<S, P, std::deque<T, AL>, T>(s, v);
+    return s;
+}
+
+/*! Reads the array - exactly N elements are expected. */
+template<typename S, typename P, typename T, size_t N>
+jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S, P>& s, std::array<T, N>& v)
+{
+    size_t n = 0;
+    auto set = [&v, &n](T& x) {
+        if (n == N)
+            throw jj::exception::base("Too many elements for the array.");
+        v[n++] = std::move(x);
+    };
+    jj::props::aux::readElements<T>(s, set);
+    if (n != N)
+        throw jj::exception::base("Too few elements for the array.");
+    return s;
+}
+
 #endif // JJ_PROPS_TEXT_DESERIALIZER_H
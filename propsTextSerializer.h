@@ -2,7 +2,11 @@
 #define JJ_PROPS_TEXT_SERIALIZER_H
 
 #include "jj/props.h"
+#include "jj/format.h"
 #include <type_traits>
+#include <vector>
+#include <deque>
+#include <array>
 
 namespace jj
 {
@@ -105,23 +109,6 @@ jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, co
     return s;
 }
 
-namespace jj
-{
-namespace props
-{
-template<typename STREAM>
-template<typename CTX, typename KEY, typename T>
-void textSerializer_t<STREAM>::onValue(CTX& ctx, KEY key, const T& v)
-{
-    indent(ctx.Dive.size());
-    s_ << key << jj::str::literals_t<char_type>::EQUAL;
-    *this << v;
-    s_ << jj::str::literals_t<char_type>::NL;
-}
-
-} // namespace props
-} // namespace jj
-
 template<typename S>
 jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, bool v)
 {
@@ -153,21 +140,117 @@ jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, co
     return s;
 }
 
-template<typename S, typename T>
-jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, const std::list<T>& v)
+namespace jj
+{
+namespace props
+{
+namespace aux
+{
+/*! Tells whether T is an integer written as a number by the streams (not bool or a character). */
+template<typename T>
+struct isNumericInteger_t : public std::integral_constant<bool, std::is_integral<T>::value && !std::is_same<T, bool>::value
+    && !std::is_same<T, char>::value && !std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value
+    && !std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value>
+{
+};
+
+/*! Writes the elements separated by commas. */
+template<typename S, typename IT>
+void writeElements(jj::props::textSerializer_t<S>& s, IT b, IT e, std::false_type)
 {
     typedef typename jj::props::textSerializer_t<S>::stream_type stream_type;
     typedef typename stream_type::char_type char_type;
     stream_type& sr = s.stream();
-    bool first = true;
-    for (const T& x : v)
+    for (IT it = b; it != e; ++it)
     {
-        if (!first)
+        if (it != b)
             sr << jj::str::literals_t<char_type>::COMMA;
-        s << x;
-        first = false;
+        s << *it;
     }
+}
+/*! Writes the integers separated by commas - formatted all at once and written into the stream in one go (unless
+the format of the stream was changed). */
+template<typename S, typename IT>
+void writeElements(jj::props::textSerializer_t<S>& s, IT b, IT e, std::true_type)
+{
+    typedef typename jj::props::textSerializer_t<S>::stream_type stream_type;
+    typedef typename stream_type::char_type char_type;
+    typedef typename std::iterator_traits<IT>::value_type value_type;
+    stream_type& sr = s.stream();
+    std::ios_base::fmtflags base = sr.flags() & std::ios_base::basefield;
+    if ((base != std::ios_base::dec && base != 0) || (sr.flags() & std::ios_base::showpos) != 0 || sr.width() != 0)
+    {
+        writeElements(s, b, e, std::false_type());
+        return;
+    }
+    std::basic_string<char_type> out;
+    char_type num[jj::fmt::MAX_NUMBER];
+    char_type* end = num + jj::fmt::MAX_NUMBER;
+    for (IT it = b; it != e; ++it)
+    {
+        if (it != b)
+            out += jj::str::literals_t<char_type>::COMMA;
+        char_type* p = std::is_signed<value_type>::value
+            ? jj::fmt::formatSigned(static_cast<long long>(*it), end)
+            : jj::fmt::formatUnsigned(static_cast<unsigned long long>(*it), end);
+        out.append(p, end);
+    }
+    sr.write(out.data(), static_cast<std::streamsize>(out.length()));
+}
+
+/*! Writes the elements of a container separated by commas. */
+template<typename S, typename C>
+void writeContainer(jj::props::textSerializer_t<S>& s, const C& c)
+{
+    writeElements(s, c.begin(), c.end(), typename isNumericInteger_t<typename C::value_type>::type());
+}
+} // namespace aux
+} // namespace props
+} // namespace jj
+
+template<typename S, typename T>
+jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, const std::list<T>& v)
+{
+    jj::props::aux::writeContainer(s, v);
     return s;
 }
 
+template<typename S, typename T, typename AL>
+jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, const std::vector<T, AL>& v)
+{
+    jj::props::aux::writeContainer(s, v);
+    return s;
+}
+
+template<typename S, typename T, typename AL>
+jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, const std::deque<T, AL>& v)
+{
+    jj::props::aux::writeContainer(s, v);
+    return s;
+}
+
+template<typename S, typename T, size_t N>
+jj::props::textSerializer_t<S>& operator<<(jj::props::textSerializer_t<S>& s, const std::array<T, N>& v)
+{
+    jj::props::aux::writeContainer(s, v);
+    return s;
+}
+
+namespace jj
+{
+namespace props
+{
+template<typename STREAM>
+template<typename CTX, typename KEY, typename T>
+void textSerializer_t<STREAM>::onValue(CTX& ctx, KEY key, const T& v)
+{
+    indent(ctx.Dive.size());
+    s_ << key << jj::str::literals_t<char_type>::EQUAL;
+    *this << v;
+    s_ << jj::str::literals_t<char_type>::NL;
+}
+
+} // namespace props
+} // namespace jj
+
 #endif // JJ_PROPS_TEXT_SERIALIZER_H
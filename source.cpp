@@ -0,0 +1,99 @@
+#include "jj/source.h"
+#include "jj/exception.h"
+#include "jj/stream.h"
+#include <sstream>
+#if defined(JJ_OS_WINDOWS)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace jj
+{
+
+#if defined(JJ_OS_WINDOWS)
+mappedFile_t::mappedFile_t(const jj::string_t& path)
+    : data_(nullptr), size_(0), handle_(nullptr)
+{
+#if defined(JJ_USE_WSTRING)
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#else
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#endif
+    if (file == INVALID_HANDLE_VALUE)
+        throw jj::exception::base(jjS2(std::ostringstream, "Cannot open file [" << jj::strcvt::to_string(path) << "]; error=" << GetLastError()));
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        DWORD err = GetLastError();
+        CloseHandle(file);
+        throw jj::exception::base(jjS2(std::ostringstream, "Cannot get size of file [" << jj::strcvt::to_string(path) << "]; error=" << err));
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0)
+    {
+        CloseHandle(file);
+        return; // an empty file cannot be mapped
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        throw jj::exception::base(jjS2(std::ostringstream, "Cannot map file [" << jj::strcvt::to_string(path) << "]; error=" << GetLastError()));
+    data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr)
+    {
+        DWORD err = GetLastError();
+        CloseHandle(mapping);
+        throw jj::exception::base(jjS2(std::ostringstream, "Cannot map file [" << jj::strcvt::to_string(path) << "]; error=" << err));
+    }
+    handle_ = mapping;
+}
+
+mappedFile_t::~mappedFile_t()
+{
+    if (data_ != nullptr)
+        UnmapViewOfFile(data_);
+    if (handle_ != nullptr)
+        CloseHandle(handle_);
+}
+#else
+mappedFile_t::mappedFile_t(const jj::string_t& path)
+    : data_(nullptr), size_(0), handle_(nullptr)
+{
+    int fd = open(jj::strcvt::to_string(path).c_str(), O_RDONLY);
+    if (fd < 0)
+        throw jj::exception::base(jjS2(std::ostringstream, "Cannot open file [" << jj::strcvt::to_string(path) << "]; error=" << errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        close(fd);
+        throw jj::exception::base(jjS2(std::ostringstream, "Cannot get size of file [" << jj::strcvt::to_string(path) << "]; error=" << err));
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0)
+    {
+        close(fd);
+        return; // an empty file cannot be mapped
+    }
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);
+    if (data == MAP_FAILED)
+        throw jj::exception::base(jjS2(std::ostringstream, "Cannot map file [" << jj::strcvt::to_string(path) << "]; error=" << err));
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+}
+
+mappedFile_t::~mappedFile_t()
+{
+    if (data_ != nullptr)
+        munmap(const_cast<char*>(data_), size_);
+}
+#endif // defined(JJ_OS_WINDOWS)
+
+} // namespace jj
@@ -2,15 +2,48 @@
 #define JJ_SOURCE_H
 
 #include "jj/string.h"
+#include "jj/stringLiterals.h"
+#include <streambuf>
+#include <istream>
+#include <memory>
+#include <vector>
+#include <type_traits>
 
 namespace jj
 {
 
-/*! Allows reading characters from a stream end of file is autodetected. */
+/*! A position in a text - both the line and the column start at 1. The column counts characters (not bytes or
+glyphs), a tab is a single column. */
+struct textLocation_t
+{
+    size_t Line; //!< the line
+    size_t Column; //!< the column
+
+    /*! Ctor - the beginning of the text. */
+    textLocation_t() : Line(1), Column(1) {}
+
+    /*! Moves the location past the characters from begin up to (excluding) end. */
+    template<typename CH>
+    void advance(const CH* begin, const CH* end)
+    {
+        for (; begin != end; ++begin)
+        {
+            if (*begin == jj::str::literals_t<CH>::NL)
+            {
+                ++Line;
+                Column = 1;
+            }
+            else
+                ++Column;
+        }
+    }
+};
+
+/*! Allows reading characters from a stream end of file is autodetected.
+It does not track the location (see bufferSource_t or chunkedSource_t for that). */
 template<typename STREAM>
 class streamSource_t
 {
-    // TODO add position tracking policy (probably as derived source classes)
 public:
     typedef STREAM stream_type; //!< underlying stream type
     typedef typename stream_type::char_type char_type; //!< character type in the underlying stream
@@ -29,10 +62,13 @@ public:
     Returns true until EOF (before reading the char). */
     bool peek(char_type& ch)
     {
-        bool ret = get(ch);
-        if (ret)
-            unget();
-        return ret;
+        if (!s_.good() || s_.eof())
+            return false;
+        typename stream_type::int_type tmp = s_.peek();
+        if (tmp == stream_type::traits_type::eof())
+            return false;
+        ch = char_type(tmp);
+        return true;
     }
 
     /*! Reads next char and skips past it.
@@ -59,6 +95,229 @@ public:
         s_.unget();
     }
 };
+
+/*! Allows reading characters from a memory buffer (which has to stay valid while the source is used). Besides the
+interface of streamSource_t it gives direct access to the characters not read yet (see position(), end() and seek()),
+so readers can scan the text by pointers without copying it. The stream() reads from the same buffer (at the same
+position), it is created on first use. */
+template<typename CH>
+class bufferSource_t : private std::basic_streambuf<CH>
+{
+public:
+    typedef std::basic_istream<CH> stream_type; //!< the type of stream()
+    typedef CH char_type; //!< character type in the buffer
+
+private:
+    std::unique_ptr<stream_type> stream_; //!< the stream reading the buffer (nullptr until needed)
+    mutable textLocation_t loc_; //!< the location of locPos_
+    mutable const char_type* locPos_; //!< the position up to which the location was counted
+
+public:
+    /*! Ctor - takes the characters from begin up to (excluding) end. */
+    bufferSource_t(const char_type* begin, const char_type* end) { assign(begin, end); }
+    bufferSource_t(const bufferSource_t&) = delete;
+    bufferSource_t& operator=(const bufferSource_t&) = delete;
+
+    /*! Starts reading the characters from begin up to (excluding) end. */
+    void assign(const char_type* begin, const char_type* end)
+    {
+        char_type* b = const_cast<char_type*>(begin); // the buffer is never written to
+        this->setg(b, b, const_cast<char_type*>(end));
+        loc_ = textLocation_t();
+        locPos_ = begin;
+    }
+
+    /*! Returns a stream reading from the current position (reading from it moves the position of the source). */
+    stream_type& stream()
+    {
+        if (!stream_)
+            stream_.reset(new stream_type(this));
+        return *stream_;
+    }
+
+    /*! Returns the next character to be read. */
+    const char_type* position() const { return this->gptr(); }
+    /*! Returns the end of the buffer. */
+    const char_type* end() const { return this->egptr(); }
+    /*! Moves the position (has to be between the beginning of the buffer and end()). */
+    void seek(const char_type* pos) { this->setg(this->eback(), const_cast<char_type*>(pos), this->egptr()); }
+    /*! Returns the line and column of the next character to be read. It is counted on demand (from where the last
+    call ended), so it costs nothing while not used (e.g. until an error needs to be reported). */
+    textLocation_t location() const
+    {
+        if (this->gptr() < locPos_)
+        {
+            loc_ = textLocation_t();
+            locPos_ = this->eback();
+        }
+        loc_.advance<char_type>(locPos_, this->gptr());
+        locPos_ = this->gptr();
+        return loc_;
+    }
+
+    /*! Reads next char, but does not skip past it.
+    Returns true until end of the buffer. */
+    bool peek(char_type& ch)
+    {
+        if (this->gptr() == this->egptr())
+            return false;
+        ch = *this->gptr();
+        return true;
+    }
+
+    /*! Reads next char and skips past it.
+    Returns true until end of the buffer. */
+    bool get(char_type& ch)
+    {
+        if (this->gptr() == this->egptr())
+            return false;
+        ch = *this->gptr();
+        this->gbump(1);
+        return true;
+    }
+
+    /*! Goes back by one character. Does nothing if at the beginning. */
+    void unget()
+    {
+        if (this->gptr() != this->eback())
+            this->gbump(-1);
+    }
+};
+
+/*! Allows reading characters from a stream by chunks - the stream is read once per chunk (of the size given to ctor)
+into a buffer, reading the individual characters is then as cheap as with bufferSource_t. The source tracks the
+location (line and column) of the characters read.
+The stream() reads from the buffer too (at the same position), the underlying stream shall not be read directly while
+the source is used. */
+template<typename STREAM>
+class chunkedSource_t : private std::basic_streambuf<typename STREAM::char_type>
+{
+public:
+    typedef typename STREAM::char_type char_type; //!< character type in the underlying stream
+    typedef std::basic_istream<char_type> stream_type; //!< the type of stream()
+
+private:
+    typedef std::basic_streambuf<char_type> parent_t;
+    typedef typename parent_t::traits_type traits_type;
+
+    STREAM& s_; //!< the underlying stream
+    std::vector<char_type> buf_; //!< the chunk read from s_ (the first character is the last one of the previous chunk)
+    textLocation_t loc_; //!< the location of the beginning of the get area
+    std::unique_ptr<stream_type> stream_; //!< the stream reading the buffer (nullptr until needed)
+
+protected:
+    /*! Reads the next chunk from the underlying stream. The last character read is kept so unget() works. */
+    virtual typename parent_t::int_type underflow() override
+    {
+        if (this->gptr() < this->egptr())
+            return traits_type::to_int_type(*this->gptr());
+        size_t keep = 0;
+        if (this->eback() != this->egptr())
+        {
+            loc_.advance<char_type>(this->eback(), this->egptr() - 1);
+            buf_[0] = this->egptr()[-1];
+            keep = 1;
+        }
+        size_t n = 0;
+        if (s_.good())
+        {
+            s_.read(&buf_[keep], static_cast<std::streamsize>(buf_.size() - keep));
+            n = static_cast<size_t>(s_.gcount());
+        }
+        this->setg(&buf_[0], &buf_[keep], &buf_[keep] + n);
+        return n == 0 ? traits_type::eof() : traits_type::to_int_type(*this->gptr());
+    }
+
+public:
+    /*! Ctor - takes stream by reference, chunk is the number of characters read at once. */
+    chunkedSource_t(STREAM& s, size_t chunk = 65536) : s_(s), buf_(chunk < 1 ? 2 : chunk + 1) {}
+    chunkedSource_t(const chunkedSource_t&) = delete;
+    chunkedSource_t& operator=(const chunkedSource_t&) = delete;
+
+    /*! Returns a stream reading from the current position (reading from it moves the position of the source). */
+    stream_type& stream()
+    {
+        if (!stream_)
+            stream_.reset(new stream_type(this));
+        return *stream_;
+    }
+
+    /*! Reads next char, but does not skip past it.
+    Returns true until EOF (before reading the char). */
+    bool peek(char_type& ch)
+    {
+        typename parent_t::int_type tmp = this->sgetc();
+        if (traits_type::eq_int_type(tmp, traits_type::eof()))
+            return false;
+        ch = traits_type::to_char_type(tmp);
+        return true;
+    }
+
+    /*! Reads next char and skips past it.
+    Returns true until EOF (before reading the char). */
+    bool get(char_type& ch)
+    {
+        typename parent_t::int_type tmp = this->sbumpc();
+        if (traits_type::eq_int_type(tmp, traits_type::eof()))
+            return false;
+        ch = traits_type::to_char_type(tmp);
+        return true;
+    }
+
+    /*! Goes back by one character - guaranteed to work only once and only if get() was called before calling unget().
+    Does nothing if at the beginning. */
+    void unget()
+    {
+        if (this->gptr() != this->eback())
+            this->gbump(-1);
+    }
+
+    /*! Returns the line and column of the next character to be read. */
+    textLocation_t location() const
+    {
+        textLocation_t ret(loc_);
+        ret.advance<char_type>(this->eback(), this->gptr());
+        return ret;
+    }
+};
+
+/*! A read-only view of a whole file mapped into memory. */
+class mappedFile_t
+{
+    const char* data_; //!< the content
+    size_t size_; //!< the size of the content
+    void* handle_; //!< the system handle of the mapping (if needed by the system)
+
+public:
+    /*! Ctor - maps the file, throws jj::exception::base if it cannot be opened or mapped. */
+    explicit mappedFile_t(const jj::string_t& path);
+    /*! Dtor - unmaps the file. */
+    ~mappedFile_t();
+    mappedFile_t(const mappedFile_t&) = delete;
+    mappedFile_t& operator=(const mappedFile_t&) = delete;
+
+    /*! Returns the beginning of the content (nullptr if the file is empty). */
+    const char* data() const { return data_; }
+    /*! Returns the size of the file in bytes. */
+    size_t size() const { return size_; }
+};
+
+/*! Allows reading characters from a file mapped into memory. This is the fastest way of reading a whole file by
+textDeserializer_t and the other readers working with sources. The file is read as bytes (no conversions). */
+class fileSource_t : public bufferSource_t<char>
+{
+    mappedFile_t file_; //!< the content
+
+public:
+    /*! Ctor - maps the file, throws jj::exception::base if it cannot be opened or mapped. */
+    explicit fileSource_t(const jj::string_t& path) : bufferSource_t<char>(nullptr, nullptr), file_(path) { assign(file_.data(), file_.data() + file_.size()); }
+};
+
+/*! Tells whether the characters of the SOURCE are directly accessible in memory (by position(), end() and seek()). */
+template<typename SOURCE>
+struct isBufferSource_t : public std::is_base_of<bufferSource_t<typename SOURCE::char_type>, SOURCE>
+{
+};
 } // namespace jj
 
 #endif // JJ_SOURCE_H
@@ -2,6 +2,7 @@
 #define JJ_STREAM_H
 
 #include "jj/string.h"
+#include "jj/format.h"
 #include <iosfwd>
 
 namespace jj
@@ -68,13 +69,13 @@ public:
 } // namespace AUX
 } // namespace jj
 
-/*! Expands to an expression which "in-line" uses default stringstream to convert
-given streamed values into a string. Usage:
+/*! Expands to an expression which "in-line" converts given streamed values into a string (by jj::fmt::builder_t,
+see jj/format.h). Usage:
 my_function_taking_string_as_parameter(jjS(jjT("the values are [") << a << jjT(',') << b << jjT(']'))) */
-#define jjS(text) (jj::AUX::SStreamWrap<jj::sstream_t>() << text).str()
-/*! Expands to an expression which "in-line" uses given stringstream type to convert
-given streamed values into a string. Usage:
+#define jjS(text) (jj::fmt::builder_t() << text).str()
+/*! Expands to an expression which "in-line" converts given streamed values into a string of the character type
+of given stringstream type. Usage:
 throw MyException(jjS2(std::ostringstream, jjT("invalid argument [") << a << jjT(']'))) */
-#define jjS2(type,text) (jj::AUX::SStreamWrap<type>() << text).str()
+#define jjS2(type,text) (jj::fmt::basicBuilder_t<type::char_type>() << text).str()
 
 #endif // JJ_STREAM_H
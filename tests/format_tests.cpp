@@ -0,0 +1,158 @@
+#include "jj/format.h"
+#include "jj/stream.h"
+#include "jj/test/test.h"
+#include <iomanip>
+#include <sstream>
+#include <limits>
+#include <random>
+#include <cstring>
+#include <cstdlib>
+
+namespace formatTests
+{
+/*! Returns the text of the double formatted by jj::fmt. */
+std::string fmtDouble(double v)
+{
+    char buf[jj::fmt::MAX_NUMBER];
+    return std::string(buf, jj::fmt::formatDouble(v, buf));
+}
+
+/*! Returns the text of the float formatted by jj::fmt. */
+std::string fmtFloat(float v)
+{
+    char buf[jj::fmt::MAX_NUMBER];
+    return std::string(buf, jj::fmt::formatFloat(v, buf));
+}
+
+/*! Returns the text of the number formatted by a string stream. */
+template<typename T>
+std::string streamed(T v)
+{
+    std::ostringstream s;
+    s << v;
+    return s.str();
+}
+} // namespace formatTests
+
+JJ_TEST_CLASS(formatTests_t)
+
+JJ_TEST_CASE(integers)
+{
+    using formatTests::streamed;
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << 0).text() == "0");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << 7 << ' ' << 10 << ' ' << 99 << ' ' << 100 << ' ' << -1).text() == "7 10 99 100 -1");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::numeric_limits<int>::min()).text() == streamed(std::numeric_limits<int>::min()));
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::numeric_limits<int>::max()).text() == streamed(std::numeric_limits<int>::max()));
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::numeric_limits<long long>::min()).text() == "-9223372036854775808");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::numeric_limits<unsigned long long>::max()).text() == "18446744073709551615");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << static_cast<short>(-32768) << static_cast<unsigned short>(65535)).text() == "-3276865535");
+    std::mt19937_64 rnd(17);
+    bool same = true;
+    for (int i = 0; i < 10000; ++i)
+    {
+        long long v = static_cast<long long>(rnd()) >> (i % 64);
+        if ((jj::fmt::basicBuilder_t<char>() << v).text() != streamed(v))
+            same = false;
+    }
+    JJ_TEST(same);
+}
+
+JJ_TEST_CASE(doubles)
+{
+    using formatTests::fmtDouble;
+    JJ_TEST(fmtDouble(0.0) == "0");
+    JJ_TEST(fmtDouble(-0.0) == "-0");
+    JJ_TEST(fmtDouble(1.0) == "1");
+    JJ_TEST(fmtDouble(-2.5) == "-2.5");
+    JJ_TEST(fmtDouble(0.1) == "0.1");
+    JJ_TEST(fmtDouble(0.3) == "0.3");
+    JJ_TEST(fmtDouble(123.456) == "123.456");
+    JJ_TEST(fmtDouble(1e16) == "10000000000000000");
+    JJ_TEST(fmtDouble(1e17) == "1e+17");
+    JJ_TEST(fmtDouble(1.5e20) == "1.5e+20");
+    JJ_TEST(fmtDouble(1e-5) == "0.00001");
+    JJ_TEST(fmtDouble(1e-6) == "1e-06");
+    JJ_TEST(fmtDouble(5e-324) == "5e-324");
+    JJ_TEST(fmtDouble(std::numeric_limits<double>::max()) == "1.7976931348623157e+308");
+    JJ_TEST(fmtDouble(std::numeric_limits<double>::infinity()) == "inf");
+    JJ_TEST(fmtDouble(-std::numeric_limits<double>::infinity()) == "-inf");
+    JJ_TEST(fmtDouble(std::numeric_limits<double>::quiet_NaN()) == "nan");
+}
+
+JJ_TEST_CASE(doubles_roundtrip)
+{
+    std::mt19937_64 rnd(42);
+    size_t wrong = 0;
+    for (int i = 0; i < 100000; ++i)
+    {
+        unsigned long long bits = rnd();
+        double v;
+        memcpy(&v, &bits, sizeof(v));
+        if (v != v)
+            continue;
+        std::string s = formatTests::fmtDouble(v);
+        double back = strtod(s.c_str(), nullptr);
+        if (memcmp(&back, &v, sizeof(v)) != 0)
+            ++wrong;
+    }
+    JJ_TEST(wrong == 0u);
+}
+
+JJ_TEST_CASE(floats)
+{
+    using formatTests::fmtFloat;
+    JJ_TEST(fmtFloat(0.1f) == "0.1");
+    JJ_TEST(fmtFloat(3.14159f) == "3.14159");
+    JJ_TEST(fmtFloat(16777216.f) == "16777216");
+    JJ_TEST(fmtFloat(std::numeric_limits<float>::max()) == "3.4028235e+38");
+    JJ_TEST(fmtFloat(std::numeric_limits<float>::denorm_min()) == "1e-45");
+    std::mt19937 rnd(7);
+    size_t wrong = 0;
+    for (int i = 0; i < 100000; ++i)
+    {
+        unsigned bits = rnd();
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        if (v != v)
+            continue;
+        std::string s = fmtFloat(v);
+        float back = strtof(s.c_str(), nullptr);
+        if (memcmp(&back, &v, sizeof(v)) != 0)
+            ++wrong;
+    }
+    JJ_TEST(wrong == 0u);
+}
+
+JJ_TEST_CASE(manipulators)
+{
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::hex << 255 << ' ' << std::dec << 255).text() == "ff 255");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::setprecision(3) << 3.14159 << ' ' << std::setprecision(6) << 2.5).text() == "3.14 2.5");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::setw(4) << 1 << '|' << std::setw(3) << "ab" << '|').text() == "   1| ab|");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::boolalpha << true << std::noboolalpha << true).text() == "true1");
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << 'a' << std::endl << 'b').text() == "a\nb");
+    jj::fmt::basicBuilder_t<char> b;
+    b << std::hex << 255;
+    b.clear();
+    b << 255;
+    JJ_TEST(b.text() == "255");
+    JJ_TEST(b.str() == "255");
+    JJ_TEST(b.text().empty());
+}
+
+JJ_TEST_CASE(other_values)
+{
+    const void* p = nullptr;
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << p).text() == formatTests::streamed(p));
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << std::string("str") << 1.5f << true).text() == "str1.51");
+    char buf[] = "mutable";
+    JJ_TEST((jj::fmt::basicBuilder_t<char>() << buf).text() == "mutable");
+}
+
+JJ_TEST_CASE(wide)
+{
+    JJ_TEST((jj::fmt::basicBuilder_t<wchar_t>() << L"v=" << -42 << L' ' << 0.25 << L' ' << std::hex << 255u).text() == L"v=-42 0.25 ff");
+    JJ_TEST(jjS(jjT("a") << 1 << jjT(',') << 2.5) == jjT("a1,2.5"));
+    JJ_TEST(jjS2(std::wostringstream, L"b" << 3) == L"b3");
+}
+
+JJ_TEST_CLASS_END(formatTests_t, integers, doubles, doubles_roundtrip, floats, manipulators, other_values, wide)
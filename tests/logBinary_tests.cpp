@@ -0,0 +1,172 @@
+#include "jj/logBinary.h"
+#include "jj/test/test.h"
+#include "tempFile_tests.h"
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+
+JJ_DECLARE_LOG_COMPONENT2(binLogOther, "other");
+
+static jj::log::message_t binaryMessage(const jj::char_t* text, jj::log::timestamp_t t = jj::log::clock_t::now(), jj::log::level_t level = JJ_LOGLEVEL_INFO, jj::log::levelName_t name = jj::log::logger_t::NAME_INFO, int line = __LINE__)
+{
+    return jj::log::message_t(t, level, name, text, JJ_FUNC, __FILE__, line, JJ_LOG_COMPONENT);
+}
+
+static size_t decodeFile(const jj::string_t& path, std::vector<jj::log::decodedMessage_t>& out)
+{
+    std::ifstream f(jj::strcvt::to_string(path).c_str(), std::ios::in | std::ios::binary);
+    if (!f)
+        return 0;
+    jj::log::binaryDecoder_t dec(f);
+    jj::log::decodedMessage_t msg;
+    size_t ret = 0;
+    while (dec.next(msg))
+    {
+        out.push_back(msg);
+        ++ret;
+    }
+    return ret;
+}
+
+static void removeBinaryLogs(const jj::string_t& path)
+{
+    std::remove(jj::strcvt::to_string(path).c_str());
+    for (int i = 1; i < 10; ++i)
+        std::remove(jj::strcvt::to_string(path + jjT('.') + jj::strcvt::to_string_t(std::to_string(i))).c_str());
+}
+
+JJ_TEST_CLASS(logBinaryTests_t)
+
+JJ_TEST_CASE(varints)
+{
+    std::string buf;
+    jj::log::binary::putVarint(buf, 0);
+    jj::log::binary::putVarint(buf, 127);
+    jj::log::binary::putVarint(buf, 128);
+    jj::log::binary::putVarint(buf, ~0ULL);
+    jj::log::binary::putSignedVarint(buf, -1);
+    jj::log::binary::putSignedVarint(buf, 1);
+    JJ_TEST(buf.length() == 1 + 1 + 2 + 10 + 1 + 1);
+    JJ_TEST(buf[0] == 0 && buf[1] == 127);
+    JJ_TEST(buf[14] == 1 && buf[15] == 2);
+}
+
+JJ_TEST_CASE(roundtrip)
+{
+    jj::log::binaryEncoder_t enc;
+    std::string data;
+    enc.header(data);
+    jj::log::timestamp_t t0 = jj::log::clock_t::now();
+    std::string batch;
+    enc.encode(binaryMessage(jjT("first"), t0, JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, 10), batch);
+    enc.encode(binaryMessage(jjT("second"), t0 + std::chrono::milliseconds(5), JJ_LOGLEVEL_WARNING, jj::log::logger_t::NAME_WARNING, 20), batch);
+    enc.encode(jj::log::message_t(t0 - std::chrono::milliseconds(1), JJ_LOGLEVEL_ERROR, jj::log::logger_t::NAME_ERROR, jjT("third"), "fn", "file.cpp", 30, binLogOtherComponent_t::instance()), batch);
+    data += batch;
+    batch.clear();
+    enc.encode(binaryMessage(jj::string_t(300, jjT('x')).c_str(), t0, JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, 40), batch);
+    data += batch;
+
+    std::istringstream in(data);
+    jj::log::binaryDecoder_t dec(in);
+    jj::log::decodedMessage_t msg;
+    JJ_TEST(dec.next(msg));
+    JJ_TEST(msg.Time == t0);
+    JJ_TEST(msg.Level == JJ_LOGLEVEL_INFO);
+    JJ_TEST(msg.LevelName == "INFO");
+    JJ_TEST(msg.Component == "<main>");
+    JJ_TEST(msg.File == __FILE__);
+    JJ_TEST(msg.Line == 10);
+    JJ_TEST(msg.Message == "first");
+    JJ_TEST(dec.next(msg));
+    JJ_TEST(msg.Time == t0 + std::chrono::milliseconds(5));
+    JJ_TEST(msg.LevelName == "WARN");
+    JJ_TEST(msg.Line == 20);
+    JJ_TEST(msg.Message == "second");
+    JJ_TEST(dec.next(msg));
+    JJ_TEST(msg.Time == t0 - std::chrono::milliseconds(1));
+    JJ_TEST(msg.Level == JJ_LOGLEVEL_ERROR);
+    JJ_TEST(msg.Component == "other");
+    JJ_TEST(msg.File == "file.cpp");
+    JJ_TEST(msg.Function == "fn");
+    JJ_TEST(msg.Message == "third");
+    JJ_TEST(dec.next(msg));
+    JJ_TEST(msg.Time == t0);
+    JJ_TEST(msg.Line == 40);
+    JJ_TEST(msg.Message == std::string(300, 'x'));
+    JJ_TEST(!dec.next(msg));
+}
+
+JJ_TEST_CASE(corrupt)
+{
+    {
+        std::istringstream in("not a log");
+        jj::log::binaryDecoder_t dec(in);
+        jj::log::decodedMessage_t msg;
+        JJ_TEST_THAT_THROWS(dec.next(msg), std::runtime_error);
+    }
+    {
+        jj::log::binaryEncoder_t enc;
+        std::string data;
+        enc.header(data);
+        enc.encode(binaryMessage(jjT("truncated")), data);
+        data.resize(data.length() - 3);
+        std::istringstream in(data);
+        jj::log::binaryDecoder_t dec(in);
+        jj::log::decodedMessage_t msg;
+        JJ_TEST_THAT_THROWS(dec.next(msg), std::runtime_error);
+    }
+}
+
+JJ_TEST_CASE(same_as_text)
+{
+    jj::log::message_t m(binaryMessage(jjT("rendered the same")));
+    jj::log::binaryEncoder_t enc;
+    std::string data;
+    enc.header(data);
+    enc.encode(m, data);
+    std::istringstream in(data);
+    jj::log::binaryDecoder_t dec(in);
+    jj::log::decodedMessage_t msg;
+    JJ_TEST(dec.next(msg));
+    std::ostringstream bin;
+    jj::log::binaryDecoder_t::render(bin, msg);
+
+    jj::log::textEncoder_t text;
+    std::string exp;
+    text.encode(m, exp);
+    JJ_TEST(bin.str() == exp, jjOOO(jj::strcvt::to_string_t(bin.str()),==,jj::strcvt::to_string_t(exp)));
+}
+
+JJ_TEST_CASE(file_target)
+{
+    jj::string_t path(tempPath(jjT("jjlogtest_binary.log")));
+    removeBinaryLogs(path);
+    jj::log::fileTarget_t::options_t opts;
+    opts.BufferSize = 64;
+    opts.MaxSize = 200;
+    opts.Backups = 3;
+    {
+        jj::log::fileTarget_t tgt(path, opts, std::make_shared<jj::log::binaryEncoder_t>());
+        for (int i = 0; i < 20; ++i)
+        {
+            tgt.log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT("binary line"), JJ_FUNC, __FILE__, i, i % 2 ? binLogOtherComponent_t::instance() : JJ_LOG_COMPONENT));
+            if (i % 4 == 3)
+                tgt.flush(); // the rotation is decided per batch
+        }
+        JJ_TEST(tgt.rotations() > 0);
+    }
+    // every file (including the rotated ones) is decodable on its own
+    std::vector<jj::log::decodedMessage_t> msgs;
+    JJ_TEST(decodeFile(path, msgs) > 0);
+    size_t cnt = msgs.size();
+    JJ_TEST(decodeFile(path + jjT(".1"), msgs) > 0);
+    for (const jj::log::decodedMessage_t& m : msgs)
+    {
+        JJ_TEST(m.Message == "binary line");
+        JJ_TEST(m.Component == (m.Line % 2 ? "other" : "<main>"));
+    }
+    JJ_TEST(msgs.size() > cnt);
+    removeBinaryLogs(path);
+}
+
+JJ_TEST_CLASS_END(logBinaryTests_t, varints, roundtrip, corrupt, same_as_text, file_target)
@@ -0,0 +1,164 @@
+#include "jj/log.h"
+#include "jj/test/test.h"
+#include <iomanip>
+#include <functional>
+
+#define DEFERRED_LOG(msg) JJ__LOGGER2(JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT, ((jj::log::deferredStreamProvider_t() << msg).str()))
+
+struct renderCounted
+{
+    static int rendered;
+    int v;
+};
+int renderCounted::rendered = 0;
+
+jj::ostream_t& operator<<(jj::ostream_t& s, const renderCounted& v)
+{
+    ++renderCounted::rendered;
+    return s << jjT('<') << v.v << jjT('>');
+}
+
+namespace jj
+{
+namespace log
+{
+template<>
+struct deferByCopy<renderCounted> : public std::true_type
+{
+};
+} // namespace log
+} // namespace jj
+
+/*! Trivially copyable, but not safe to copy - points to the text. */
+struct pointsTo
+{
+    const jj::char_t* p;
+};
+
+jj::ostream_t& operator<<(jj::ostream_t& s, const pointsTo& v)
+{
+    return s << v.p;
+}
+
+struct notTrivial
+{
+    jj::string_t s;
+};
+
+jj::ostream_t& operator<<(jj::ostream_t& s, const notTrivial& v)
+{
+    return s << jjT('{') << v.s << jjT('}');
+}
+
+struct deferredTargetCb : public jj::log::logTarget_base_t
+{
+    deferredTargetCb(std::function<void(const jj::log::message_t&)> fn) : fn_(fn) {}
+    virtual void log(const jj::log::message_t& log) override { fn_(log); }
+private:
+    std::function<void(const jj::log::message_t&)> fn_;
+};
+
+JJ_TEST_CLASS(logDeferredTests_t)
+
+#define CHECK_SAME(values) \
+    { \
+        jj::string_t exp = (jj::log::simpleStreamProvider_t() << values).str(); \
+        jj::string_t got = (jj::log::deferredStreamProvider_t() << values).str(); \
+        JJ_TEST(got == exp, jjOOO(got,==,exp)); \
+    }
+
+JJ_TEST_CASE(values)
+{
+    CHECK_SAME(jjT(""));
+    CHECK_SAME(jjT("abc") << 1 << jjT(' ') << -2 << jjT(' ') << 3u << jjT(' ') << -4L << jjT(' ') << 5UL << jjT(' ') << -6LL << jjT(' ') << 7ULL);
+    CHECK_SAME(short(-8) << jjT('|') << (unsigned short)9 << jjT('|') << 'c' << jjT('|') << (signed char)'d' << jjT('|') << (unsigned char)'e');
+    CHECK_SAME(3.1415 << jjT('|') << 2.5f << jjT('|') << 1e300 << jjT('|') << (long double)0.125 << jjT('|') << true << false);
+    const jj::char_t* p = jjT("pointer");
+    jj::string_t s(jjT("string"));
+    CHECK_SAME(p << s << jj::log::literal(jjT("literal")));
+    renderCounted rc = { 12 };
+    CHECK_SAME(rc << jjT('|') << notTrivial{ jjT("x") });
+    void* vp = &rc;
+    CHECK_SAME(vp);
+}
+
+JJ_TEST_CASE(manipulators)
+{
+    CHECK_SAME(std::setw(6) << 42 << jjT('|') << std::hex << 255 << jjT('|') << std::dec << 255);
+    CHECK_SAME(std::setfill(jjT('*')) << std::setw(5) << jjT("ab") << std::left << std::setw(5) << jj::string_t(jjT("cd")) << jjT('|'));
+    CHECK_SAME(std::boolalpha << true << std::noboolalpha << true << std::fixed << std::setprecision(2) << 3.14159);
+}
+
+JJ_TEST_CASE(copies)
+{
+    jj::string_t exp;
+    jj::log::deferredStreamProvider_t dp;
+    for (int i = 0; i < 200; ++i)
+    {
+        dp << i << jjT("abcdefgh");
+        exp += jj::strcvt::to_string_t(std::to_string(i)) + jjT("abcdefgh");
+    }
+    jj::log::deferred_t d(dp.str());
+    JJ_TEST(d.size() > 1000);
+    JJ_TEST(d.str() == exp);
+    jj::log::deferred_t c(d);
+    JJ_TEST(c.str() == exp);
+    jj::log::deferred_t m(std::move(d));
+    JJ_TEST(m.str() == exp);
+    JJ_TEST(d.empty());
+    JJ_TEST(d.str() == jjT(""));
+}
+
+JJ_TEST_CASE(values_copied)
+{
+    jj::char_t buf[] = jjT("before");
+    jj::string_t s(jjT("string"));
+    jj::log::deferred_t d((jj::log::deferredStreamProvider_t() << buf << s).str());
+    buf[0] = jjT('X');
+    s = jjT("changed");
+    JJ_TEST(d.str() == jjT("beforestring"));
+
+    // not marked by deferByCopy, so formatted right away
+    buf[0] = jjT('b');
+    pointsTo pt = { buf };
+    static_assert(jj::log::aux::deferredKind<pointsTo>::value == jj::log::aux::DK_EAGER, "pointsTo must not be deferred");
+    jj::log::deferred_t d2((jj::log::deferredStreamProvider_t() << pt).str());
+    buf[0] = jjT('X');
+    JJ_TEST(d2.str() == jjT("before"));
+}
+
+JJ_TEST_CASE(rendered_when_delivered)
+{
+    renderCounted rc = { 5 };
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(nullptr);
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    renderCounted::rendered = 0;
+    // no real target - nothing to format
+    jj::log::logger_t::instance().log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, (jj::log::deferredStreamProvider_t() << rc).str(), JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT));
+    JJ_TEST(renderCounted::rendered == 0);
+
+    jj::string_t msg;
+    jj::log::logger_t::instance().replaceTargets(std::make_shared<deferredTargetCb>([&](const jj::log::message_t& log) { msg = log.Message; }));
+    DEFERRED_LOG(jjT("value ") << rc << jjT(' ') << 7);
+    JJ_TEST(renderCounted::rendered == 1);
+    JJ_TEST(msg == jjT("value <5> 7"), jjOOO(msg,==,jjT("value <5> 7")));
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(asynchronous)
+{
+    jj::string_t msg;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<deferredTargetCb>([&](const jj::log::message_t& log) { msg = log.Message; }));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::logger_t::instance().startAsync();
+    {
+        jj::string_t tmp(jjT("temporary"));
+        DEFERRED_LOG(tmp << jjT(' ') << 1.5 << jjT(' ') << jj::log::literal(jjT("end")));
+    }
+    jj::log::logger_t::instance().flush();
+    JJ_TEST(msg == jjT("temporary 1.5 end"), jjOOO(msg,==,jjT("temporary 1.5 end")));
+    jj::log::logger_t::instance().stopAsync();
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CLASS_END(logDeferredTests_t, values, manipulators, copies, values_copied, rendered_when_delivered, asynchronous)
@@ -0,0 +1,188 @@
+#include "jj/logRecorder.h"
+#include "jj/test/test.h"
+#include "tempFile_tests.h"
+#include <sstream>
+#include <fstream>
+#include <thread>
+#include <cstdio>
+
+namespace recorder
+{
+size_t countOf(const std::string& s, const std::string& what)
+{
+    size_t ret = 0;
+    for (size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + 1))
+        ++ret;
+    return ret;
+}
+
+std::string readFile(const jj::string_t& path)
+{
+    std::ifstream f(jj::strcvt::to_string(path).c_str(), std::ios::binary);
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+/*! Counts the messages which are not only details. */
+struct counter_t : public jj::log::logTarget_base_t
+{
+    size_t Count = 0;
+    virtual void log(const jj::log::message_t& log) override { ++Count; }
+};
+} // namespace recorder
+
+JJ_TEST_CLASS(logRecorderTests_t)
+
+JJ_TEST_CASE(records_details)
+{
+    std::shared_ptr<recorder::counter_t> cnt(std::make_shared<recorder::counter_t>());
+    jj::log::flightRecorder_t::options_t opts;
+    opts.Detail = JJ_LOGLEVEL_INFO;
+    std::shared_ptr<jj::log::flightRecorder_t> rec(std::make_shared<jj::log::flightRecorder_t>(tempPath(jjT("jjrec1.log")), opts));
+    jj::log::logger_t::logTargets_t olog = jj::log::logger_t::instance().setTargets(jj::log::logger_t::logTargets_t{ cnt, rec });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_WARNING);
+
+    JJ_TEST(jjLW(jjT("warning ") << 1));
+    JJ_TEST(jjLA(jjT("alert ") << 2));
+    JJ_TEST(!jjLI(jjT("info ") << 3)); // produced for the recorder only, so not logged
+    JJ_TEST(!jjLV(jjT("verbose ") << 4)); // below the detail level
+    JJ_TEST(cnt->Count == 2);
+
+    std::ostringstream out;
+    JJ_TEST(rec->dump(out) == 3);
+    std::string s(out.str());
+    JJ_TEST(s.find("--- thread ") == 0);
+    JJ_TEST(s.find("[WARN] warning 1\n") != std::string::npos);
+    JJ_TEST(s.find("] alert 2\n") != std::string::npos);
+    JJ_TEST(s.find("[INFO] info 3\n") != std::string::npos);
+    JJ_TEST(s.find("verbose") == std::string::npos);
+    JJ_TEST(s.find("warning") < s.find("info"));
+
+    jj::log::logger_t::instance().setTargets(olog);
+    JJ_TEST(!jjLI(jjT("not produced")));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+}
+
+JJ_TEST_CASE(details_not_limited)
+{
+    std::shared_ptr<recorder::counter_t> cnt(std::make_shared<recorder::counter_t>());
+    jj::log::flightRecorder_t::options_t opts;
+    opts.Detail = JJ_LOGLEVEL_INFO;
+    std::shared_ptr<jj::log::flightRecorder_t> rec(std::make_shared<jj::log::flightRecorder_t>(tempPath(jjT("jjrec4.log")), opts));
+    jj::log::logger_t::logTargets_t olog = jj::log::logger_t::instance().setTargets(jj::log::logger_t::logTargets_t{ cnt, rec });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_WARNING);
+    jjTheLogComponent.setRateLimit(JJ_LOGLEVEL_INFO, jj::log::rateLimit_t(0.001, 2));
+
+    for (int i = 0; i < 5; ++i)
+        JJ_TEST(!jjLI(jjT("detail ") << i));
+    JJ_TEST(cnt->Count == 0);
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    JJ_TEST(jjLI(jjT("first"))); // the details did not take the tokens
+    JJ_TEST(jjLI(jjT("second")));
+    JJ_TEST(!jjLI(jjT("third"))); // suppressed, but still recorded as a detail
+    JJ_TEST(cnt->Count == 2);
+    std::ostringstream out;
+    JJ_TEST(rec->dump(out) == 8);
+
+    jjTheLogComponent.setRateLimit(JJ_LOGLEVEL_INFO, jj::log::rateLimit_t());
+    jj::log::logger_t::instance().setTargets(olog);
+}
+
+JJ_TEST_CASE(ring_per_thread)
+{
+    jj::log::flightRecorder_t::options_t opts;
+    opts.Records = 4;
+    opts.RecordSize = 64;
+    jj::log::flightRecorder_t rec(tempPath(jjT("jjrec2.log")), opts);
+    jj::log::message_t msg(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT(""), "f", "file", 1, jjTheLogComponent);
+    for (int i = 0; i < 10; ++i)
+    {
+        msg.Message = jj::string_t(jjT("main")) + jj::strcvt::to_string_t(std::to_string(i));
+        rec.log(msg);
+    }
+    std::thread th([&rec, &msg]() {
+        jj::log::message_t m(msg);
+        m.Message = jjT("other thread message which does not fit into the record");
+        rec.log(m);
+    });
+    th.join();
+
+    std::ostringstream out;
+    JJ_TEST(rec.dump(out) == 5);
+    std::string s(out.str());
+    JJ_TEST(recorder::countOf(s, "--- thread ") == 2);
+    JJ_TEST(s.find("main5") == std::string::npos);
+    JJ_TEST(s.find("main6") != std::string::npos);
+    JJ_TEST(s.find("main9") != std::string::npos);
+    JJ_TEST(s.find("main6") < s.find("main9"));
+    JJ_TEST(s.find("other thread") != std::string::npos);
+    JJ_TEST(s.find("not fit") == std::string::npos); // truncated
+    JJ_TEST(recorder::countOf(s, "\n") == 7);
+
+    // the ring of the finished thread is taken over
+    std::thread th2([&rec, &msg]() { rec.log(msg); });
+    th2.join();
+    std::ostringstream out2;
+    JJ_TEST(rec.dump(out2) == 5);
+    JJ_TEST(out2.str().find("other thread") == std::string::npos);
+}
+
+JJ_TEST_CASE(ended_rings_kept)
+{
+    jj::log::flightRecorder_t::options_t opts;
+    opts.Records = 4;
+    opts.EndedRings = 2;
+    jj::log::flightRecorder_t rec(tempPath(jjT("jjrec5.log")), opts);
+    jj::log::message_t msg(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT(""), "f", "file", 1, jjTheLogComponent);
+    auto logOnThread = [&rec, &msg](const jj::char_t* text) {
+        std::thread th([&rec, &msg, text]() {
+            jj::log::message_t m(msg);
+            m.Message = text;
+            rec.log(m);
+        });
+        th.join();
+    };
+
+    // the ring of an ended thread is not taken over until dumped
+    logOnThread(jjT("first"));
+    logOnThread(jjT("second"));
+    std::ostringstream out;
+    JJ_TEST(rec.dump(out) == 2);
+    JJ_TEST(out.str().find("first") != std::string::npos);
+    JJ_TEST(out.str().find("second") != std::string::npos);
+    JJ_TEST(recorder::countOf(out.str(), " (ended) ---") == 2);
+
+    // with more than EndedRings not dumped, the ring of the thread which ended first is reused
+    logOnThread(jjT("third"));
+    logOnThread(jjT("fourth"));
+    logOnThread(jjT("fifth"));
+    std::ostringstream out2;
+    JJ_TEST(rec.dump(out2) == 2);
+    JJ_TEST(out2.str().find("third") == std::string::npos);
+    JJ_TEST(out2.str().find("fourth") != std::string::npos);
+    JJ_TEST(out2.str().find("fifth") != std::string::npos);
+}
+
+JJ_TEST_CASE(dump_to_file)
+{
+    jj::string_t path(tempPath(jjT("jjrec3.log")));
+    std::remove(jj::strcvt::to_string(path).c_str());
+    std::shared_ptr<jj::log::flightRecorder_t> rec(std::make_shared<jj::log::flightRecorder_t>(path));
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(rec);
+
+    jjLV(jjT("some detail"));
+    JJ_TEST(recorder::readFile(path).empty()); // nothing written yet
+    JJ_TEST(rec->dump());
+    JJ_TEST(recorder::countOf(recorder::readFile(path), "some detail") == 1);
+    jjLI(jjT("more"));
+    jjLF(jjT("the end"));
+    std::string s(recorder::readFile(path));
+    JJ_TEST(recorder::countOf(s, "some detail") == 1);
+    JJ_TEST(s.find("[FATAL] the end\n") != std::string::npos);
+
+    jj::log::logger_t::instance().replaceTargets(olog);
+    std::remove(jj::strcvt::to_string(path).c_str());
+}
+
+JJ_TEST_CLASS_END(logRecorderTests_t, records_details, details_not_limited, ring_per_thread, ended_rings_kept, dump_to_file)
@@ -0,0 +1,67 @@
+#include "jj/log.h"
+#include "jj/test/test.h"
+#include <iomanip>
+#include <thread>
+
+namespace streamProvider
+{
+/*! A value whose formatting uses the provider too (as a log statement within operator<< would). */
+struct nested_t
+{
+    int v;
+};
+
+jj::ostream_t& operator<<(jj::ostream_t& s, const nested_t& n)
+{
+    jj::log::text_t inner((jj::log::threadStreamProvider_t() << jjT("inner ") << n.v).str());
+    return s << jjT('<') << inner << jjT('>');
+}
+} // namespace streamProvider
+
+JJ_TEST_CLASS(logStreamProviderTests_t)
+
+JJ_TEST_CASE(reused)
+{
+    jj::log::text_t t1((jj::log::threadStreamProvider_t() << jjT("a") << 1 << jjT('b') << 2.5).str());
+    JJ_TEST(t1 == jjT("a1b2.5"));
+    jj::log::text_t t2((jj::log::threadStreamProvider_t() << jjT("x")).str());
+    JJ_TEST(t2 == jjT("x"));
+    JJ_TEST(t1 == jjT("a1b2.5"));
+    jj::string_t lng(1000, jjT('l'));
+    jj::log::text_t t3((jj::log::threadStreamProvider_t() << lng << 7).str());
+    JJ_TEST(t3 == lng + jjT("7"));
+    JJ_TEST((jj::log::threadStreamProvider_t()).str().empty());
+}
+
+JJ_TEST_CASE(format_reset)
+{
+    jj::log::text_t t1((jj::log::threadStreamProvider_t() << std::hex << 255 << jjT(' ') << std::setprecision(2) << 3.14159 << jjT(' ') << std::setfill(jjT('*')) << std::setw(4) << 1).str());
+    JJ_TEST(t1 == jjT("ff 3.1 ***1"));
+    jj::log::text_t t2((jj::log::threadStreamProvider_t() << 255 << jjT(' ') << 3.14159 << jjT(' ') << std::setw(4) << 1).str());
+    JJ_TEST(t2 == jjT("255 3.14159    1"));
+}
+
+JJ_TEST_CASE(nested)
+{
+    jj::log::text_t t((jj::log::threadStreamProvider_t() << jjT("outer ") << streamProvider::nested_t{ 5 } << jjT(" end")).str());
+    JJ_TEST(t == jjT("outer <inner 5> end"));
+    jj::log::text_t after((jj::log::threadStreamProvider_t() << jjT("after")).str());
+    JJ_TEST(after == jjT("after"));
+}
+
+JJ_TEST_CASE(threads)
+{
+    bool ok = true;
+    std::thread th([&ok]() {
+        for (int i = 0; i < 1000; ++i)
+            if ((jj::log::threadStreamProvider_t() << jjT("t") << i).str() != jjT("t") + jj::strcvt::to_string_t(std::to_string(i)))
+                ok = false;
+    });
+    for (int i = 0; i < 1000; ++i)
+        if ((jj::log::threadStreamProvider_t() << jjT("m") << i).str() != jjT("m") + jj::strcvt::to_string_t(std::to_string(i)))
+            ok = false;
+    th.join();
+    JJ_TEST(ok);
+}
+
+JJ_TEST_CLASS_END(logStreamProviderTests_t, reused, format_reset, nested, threads)
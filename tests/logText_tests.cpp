@@ -0,0 +1,86 @@
+#include "jj/log.h"
+#include "jj/test/test.h"
+#include <thread>
+#include <vector>
+
+JJ_TEST_CLASS(logTextTests_t)
+
+JJ_TEST_CASE(inline_text)
+{
+    jj::log::text_t e;
+    JJ_TEST(e.empty());
+    JJ_TEST(e == jjT(""));
+    JJ_TEST(e.c_str()[0] == jjT('\0'));
+    jj::log::text_t t(jjT("hello"));
+    JJ_TEST(t.isInline());
+    JJ_TEST(t.length() == 5);
+    JJ_TEST(t == jjT("hello"));
+    JJ_TEST(t != jjT("hell"));
+    JJ_TEST(t != jjT("hello!"));
+    JJ_TEST(jj::string_t(jjT("hello")) == t);
+    JJ_TEST(t.str() == jjT("hello"));
+    JJ_TEST(t.find(jjT("ll")) == 2);
+    JJ_TEST(t.find(jjT("x")) == jj::log::text_t::npos);
+    JJ_TEST(t.find(jjT('o')) == 4);
+    jj::log::text_t full(jj::string_t(jj::log::text_t::INLINE_LENGTH, jjT('a')));
+    JJ_TEST(full.isInline());
+}
+
+JJ_TEST_CASE(arena_text)
+{
+    jj::string_t lng(300, jjT('x'));
+    jj::log::text_t t(lng);
+    JJ_TEST(!t.isInline());
+    JJ_TEST(t == lng);
+    JJ_TEST(t.c_str()[300] == jjT('\0'));
+    jj::log::text_t c(t);
+    JJ_TEST(c.c_str() == t.c_str()); // shared
+    jj::log::text_t m(std::move(t));
+    JJ_TEST(m.c_str() == c.c_str());
+    JJ_TEST(t.empty());
+    JJ_TEST(t.isInline());
+    c = jjT("short");
+    JJ_TEST(c.isInline());
+    JJ_TEST(c == jjT("short"));
+    JJ_TEST(m == lng);
+    jj::string_t huge(100000, jjT('h'));
+    jj::log::text_t h(huge);
+    JJ_TEST(h == huge);
+}
+
+JJ_TEST_CASE(append)
+{
+    jj::log::text_t t(jjT("abc"));
+    t += jjT("def");
+    JJ_TEST(t == jjT("abcdef"));
+    JJ_TEST(t.isInline());
+    jj::string_t exp(jjT("abcdef"));
+    for (int i = 0; i < 50; ++i)
+    {
+        t += jjT("0123456789");
+        exp += jjT("0123456789");
+        JJ_TEST(t == exp);
+    }
+    JJ_TEST(!t.isInline());
+    jj::sstream_t ss;
+    ss << t;
+    JJ_TEST(ss.str() == exp);
+}
+
+JJ_TEST_CASE(released_on_other_thread)
+{
+    std::vector<jj::log::text_t> texts;
+    std::thread th([&texts]() {
+        for (int i = 0; i < 1000; ++i)
+            texts.push_back(jj::log::text_t(jj::string_t(200 + i % 50, jjT('a') + i % 26)));
+    });
+    th.join();
+    bool ok = true;
+    for (int i = 0; i < 1000; ++i)
+        if (texts[i] != jj::string_t(200 + i % 50, jjT('a') + i % 26))
+            ok = false;
+    JJ_TEST(ok);
+    texts.clear();
+}
+
+JJ_TEST_CLASS_END(logTextTests_t, inline_text, arena_text, append, released_on_other_thread)
@@ -0,0 +1,168 @@
+#include "jj/log.h"
+#include "jj/test/test.h"
+#include <sstream>
+#include <cstring>
+#include <thread>
+
+struct formatCounted
+{
+    static int formatted;
+};
+int formatCounted::formatted = 0;
+
+jj::ostream_t& operator<<(jj::ostream_t& s, const formatCounted& v)
+{
+    ++formatCounted::formatted;
+    return s << jjT("counted");
+}
+
+static int traceInner(int v)
+{
+    jjLscope(jjT("inner ") << v);
+    return v + 1;
+}
+
+static int traceOuter(int v)
+{
+    jjLscope(formatCounted());
+    int ret = 0;
+    for (int i = 0; i < v; ++i)
+        ret += traceInner(i);
+    return ret;
+}
+
+static size_t countOf(const std::string& s, const std::string& what)
+{
+    size_t ret = 0;
+    for (size_t pos = s.find(what); pos != std::string::npos; pos = s.find(what, pos + 1))
+        ++ret;
+    return ret;
+}
+
+JJ_TEST_CLASS(logTraceTests_t)
+
+JJ_TEST_CASE(scopes_recorded)
+{
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(nullptr);
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::clearTrace();
+    formatCounted::formatted = 0;
+    traceOuter(3);
+    JJ_TEST(!jj::log::isTracing());
+    std::ostringstream none;
+    JJ_TEST(jj::log::exportTrace(none) == 0);
+
+    jj::log::startTrace();
+    JJ_TEST(jj::log::isTracing());
+    traceOuter(3);
+    std::thread th([]() { traceOuter(2); });
+    th.join();
+    jj::log::stopTrace();
+    traceOuter(5); // not recorded any more
+    JJ_TEST(formatCounted::formatted == 0); // the scope logs are disabled - the messages are not even formatted
+
+    std::ostringstream out;
+    JJ_TEST(jj::log::exportTrace(out) == 4 + 3);
+    std::string json(out.str());
+    JJ_TEST(json.find("{\"traceEvents\":[") == 0);
+    JJ_TEST(countOf(json, "\"ph\":\"X\"") == 7);
+    JJ_TEST(countOf(json, "traceInner") == 5);
+    JJ_TEST(countOf(json, "traceOuter") == 2);
+    JJ_TEST(countOf(json, "\"cat\":\"jjMainLog\"") == 7);
+    JJ_TEST(countOf(json, "\"tid\":") == 7);
+    JJ_TEST(json.find("logTrace_tests.cpp") != std::string::npos);
+    jj::log::clearTrace();
+    std::ostringstream cleared;
+    JJ_TEST(jj::log::exportTrace(cleared) == 0);
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(ring_overwritten)
+{
+    jj::log::clearTrace();
+    jj::log::startTrace(4);
+    std::thread th([]() { traceOuter(10); });
+    th.join();
+    jj::log::stopTrace();
+    std::ostringstream out;
+    JJ_TEST(jj::log::exportTrace(out) == 4);
+    std::string json(out.str());
+    JJ_TEST(countOf(json, "traceOuter") == 1); // the last one
+    jj::log::clearTrace();
+    jj::log::startTrace();
+    jj::log::stopTrace();
+}
+
+JJ_TEST_CASE(logs_while_tracing)
+{
+    size_t enters = 0, leaves = 0;
+    struct cb_t : public jj::log::logTarget_base_t
+    {
+        size_t& e;
+        size_t& l;
+        cb_t(size_t& e, size_t& l) : e(e), l(l) {}
+        virtual void log(const jj::log::message_t& log) override { (log.LevelName == jj::log::logger_t::NAME_ENTER ? e : l)++; }
+    };
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<cb_t>(enters, leaves));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_SCOPE);
+    jj::log::clearTrace();
+    jj::log::startTrace();
+    formatCounted::formatted = 0;
+    traceOuter(2);
+    jj::log::stopTrace();
+    JJ_TEST(formatCounted::formatted == 1);
+    JJ_TEST(enters == 3);
+    JJ_TEST(leaves == 3);
+    std::ostringstream out;
+    JJ_TEST(jj::log::exportTrace(out) == 3);
+    jj::log::clearTrace();
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(scope_stats)
+{
+    jj::log::resetScopeStats();
+    traceOuter(2);
+    JJ_TEST(!jj::log::isCollectingScopeStats());
+    JJ_TEST(jj::log::scopeStats().empty());
+
+    jj::log::startScopeStats();
+    JJ_TEST(jj::log::isCollectingScopeStats());
+    for (int i = 0; i < 10; ++i)
+        traceOuter(3);
+    std::thread th([]() { traceOuter(5); });
+    th.join();
+    jj::log::stopScopeStats();
+    traceOuter(5); // not recorded any more
+
+    std::vector<jj::log::scopeStats_t> stats = jj::log::scopeStats();
+    JJ_TEST(stats.size() == 2);
+    if (stats.size() == 2)
+    {
+        const jj::log::scopeStats_t& inner = (strstr(stats[0].Function, "traceInner") != nullptr ? stats[0] : stats[1]);
+        const jj::log::scopeStats_t& outer = (strstr(stats[0].Function, "traceInner") != nullptr ? stats[1] : stats[0]);
+        JJ_TEST(strstr(outer.Function, "traceOuter") != nullptr);
+        JJ_TEST(strstr(inner.File, "logTrace_tests.cpp") != nullptr);
+        JJ_TEST(inner.Count == 35);
+        JJ_TEST(outer.Count == 11);
+        for (const jj::log::scopeStats_t& s : stats)
+        {
+            JJ_TEST(s.P50 <= s.P99);
+            JJ_TEST(s.P99 <= s.P999);
+            JJ_TEST(s.P999 <= s.Max);
+            JJ_TEST(s.Max <= s.Total);
+        }
+        JJ_TEST(outer.Total >= inner.Total); // the outer scopes contain the inner ones
+    }
+    std::ostringstream out;
+    jj::log::dumpScopeStats(out);
+    JJ_TEST(out.str().find("p99") != std::string::npos);
+    JJ_TEST(countOf(out.str(), "\n") == 3);
+    JJ_TEST(countOf(out.str(), "traceOuter") == 1);
+
+    jj::log::resetScopeStats();
+    JJ_TEST(jj::log::scopeStats().empty());
+}
+
+JJ_TEST_CLASS_END(logTraceTests_t, scopes_recorded, ring_overwritten, logs_while_tracing, scope_stats)
@@ -1,7 +1,14 @@
 #include "jj/log.h"
 #include "jj/test/test.h"
+#include "tempFile_tests.h"
 #include "jj/time.h"
 #include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 #define LLL1(msg) JJ__LOGGER(JJ_LOGLEVEL_OFF - 1, jjT("LLL1"), msg)
 #define LLL2(msg) JJ__LOGGER(JJ_LOGLEVEL_INFO + 1, jjT("LLL2"), msg)
@@ -52,6 +59,20 @@ struct testTargetCnt : public jj::log::logTarget_base_t
 
 JJ_LOGGER_INITIALIZER(,)
 
+namespace earlyLog
+{
+JJ_DEFINE_LOG_COMPONENT(early, "early", JJ_LOGLEVEL_ERROR);
+// a log statement at namespace scope (not enabled, so nothing is logged during the static initialization)
+bool logged = jjLI(jjT("early ") << 1);
+} // namespace earlyLog
+
+static int siteLine = 0;
+static void logAtSite(int v)
+{
+    siteLine = __LINE__ + 1;
+    jjLV(jjT("site ") << v);
+}
+
 JJ_TEST_CLASS(logTests_t)
 
 JJ_TEST_CASE(fields)
@@ -425,6 +446,13 @@ JJ_TEST_CASE(scope_return)
     result = scopemethod2(false, true);
     JJ_TEST(result == 666);
     JJ_TEST(cnt == 8);
+
+    // neither ENTER nor LEAVE once the scope is switched off
+    JJ_TEST(jj::log::site_t::setMode("log_tests.cpp", scopeline1, jj::log::site_t::OFF) == 1);
+    scopemethod2(true, true);
+    scopemethod2(false, false);
+    JJ_TEST(cnt == 8);
+    jj::log::site_t::setMode("log_tests.cpp", scopeline1, jj::log::site_t::DEFAULT);
     jj::log::logger_t::instance().replaceTargets(olog);
 }
 
@@ -490,8 +518,142 @@ JJ_TEST_CASE(scope_throw)
     jj::log::logger_t::instance().replaceTargets(olog);
 }
 
+JJ_TEST_CASE(targets_set)
+{
+    std::shared_ptr<testTargetCb> tgt1, tgt2;
+    size_t c1 = 0, c2 = 0;
+    jj::log::logger_t::logTargets_t otgts = jj::log::logger_t::instance().setTargets({
+        tgt1 = std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { ++c1; }),
+        tgt2 = std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { ++c2; }) });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    JJ_TEST(jj::log::logger_t::instance().targets().size() == 2);
+    jjLI(1);
+    JJ_TEST(c1 == 1);
+    JJ_TEST(c2 == 1);
+    jj::log::logger_t::instance().unregisterTarget(tgt1);
+    jjLI(2);
+    JJ_TEST(c1 == 1);
+    JJ_TEST(c2 == 2);
+    JJ_TEST(jj::log::logger_t::instance().targets().size() == 1);
+    JJ_TEST(jj::log::logger_t::instance().targets().front() == tgt2);
+    jj::log::logger_t::logTargets_t prev = jj::log::logger_t::instance().setTargets(otgts);
+    JJ_TEST(prev.size() == 1);
+    JJ_TEST(prev.front() == tgt2);
+}
+
+JJ_TEST_CASE(targets_switch_concurrent)
+{
+    std::atomic<size_t> c1(0), c2(0);
+    std::shared_ptr<jj::log::logTarget_base_t> tgt1 = std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { ++c1; });
+    std::shared_ptr<jj::log::logTarget_base_t> tgt2 = std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { ++c2; });
+    jj::log::logger_t::logTargets_t otgts = jj::log::logger_t::instance().setTargets({ tgt1 });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> logged(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([&]() {
+            while (!stop)
+            {
+                jjLI(jjT("concurrent"));
+                ++logged;
+            }
+        });
+    for (int i = 0; i < 200; ++i)
+    {
+        jj::log::logger_t::instance().setTargets({ tgt2 });
+        jj::log::logger_t::instance().registerTarget(tgt1);
+        jj::log::logger_t::instance().replaceTargets(tgt1);
+    }
+    jj::log::logger_t::instance().replaceTargets(tgt2);
+    size_t after = c1;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    JJ_TEST(c1 == after); // tgt1 is not called any more once replaced
+    stop = true;
+    for (auto& t : threads)
+        t.join();
+    JJ_TEST(c1 + c2 >= logged, jjOOO(c1 + c2,>=,logged));
+    jj::log::logger_t::instance().setTargets(otgts);
+}
+
+JJ_TEST_CASE(targets_churn)
+{
+    // each change installs brand new targets, so a list released too early would call a destroyed target
+    struct churnTarget_t : public jj::log::logTarget_base_t
+    {
+        enum { ALIVE = 0x600d, DEAD = 0xdead };
+        std::atomic<unsigned> state;
+        std::atomic<size_t>& bad;
+        churnTarget_t(std::atomic<size_t>& b) : state(ALIVE), bad(b) {}
+        ~churnTarget_t() { state = DEAD; }
+        virtual void log(const jj::log::message_t&) override
+        {
+            if (state.load() != ALIVE)
+                ++bad;
+        }
+    };
+    std::atomic<size_t> bad(0);
+    jj::log::logger_t::logTargets_t otgts = jj::log::logger_t::instance().setTargets({ std::make_shared<churnTarget_t>(bad) });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([&]() {
+            while (!stop)
+                jjLI(jjT("churn"));
+        });
+    for (int i = 0; i < 2000; ++i)
+    {
+        jj::log::logger_t::instance().setTargets({ std::make_shared<churnTarget_t>(bad), std::make_shared<churnTarget_t>(bad) });
+        jj::log::logger_t::instance().registerTarget(std::make_shared<churnTarget_t>(bad));
+        if (i % 100 == 0)
+            std::this_thread::yield();
+    }
+    stop = true;
+    for (auto& t : threads)
+        t.join();
+    JJ_TEST(bad == 0u);
+    jj::log::logger_t::instance().setTargets(otgts);
+}
+
+JJ_TEST_CASE(sites)
+{
+    std::vector<const jj::log::site_t*> sites;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { sites.push_back(log.Site); }));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_VERBOSE);
+    logAtSite(1);
+    JJ_MUSTBE(sites.size() == 1 && sites[0] != nullptr);
+    const jj::log::site_t& site = *sites[0];
+    JJ_TEST(site.line() == siteLine);
+    JJ_TEST(!earlyLog::logged);
+    JJ_TEST(site.level() == JJ_LOGLEVEL_VERBOSE);
+    JJ_TEST(&site.component() == &JJ_LOG_COMPONENT);
+    JJ_TEST(std::string(site.file()) == __FILE__);
+    bool registered = false;
+    for (jj::log::site_t* s = jj::log::site_t::first(); s != nullptr; s = s->next())
+        if (s == &site)
+            registered = true;
+    JJ_TEST(registered);
+
+    JJ_TEST(jj::log::site_t::setMode("log_tests.cpp", siteLine, jj::log::site_t::OFF) == 1);
+    logAtSite(2);
+    JJ_TEST(sites.size() == 1);
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_ERROR);
+    JJ_TEST(jj::log::site_t::setMode("_tests.cpp", siteLine, jj::log::site_t::ON) == 1);
+    logAtSite(3);
+    JJ_TEST(sites.size() == 2);
+    jjLV(jjT("other site not enabled"));
+    JJ_TEST(sites.size() == 2);
+    JJ_TEST(jj::log::site_t::setMode("other.cpp", 0, jj::log::site_t::ON) == 0);
+    const_cast<jj::log::site_t&>(site).setMode(jj::log::site_t::DEFAULT);
+    logAtSite(4);
+    JJ_TEST(sites.size() == 2);
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
 JJ_TEST_CLASS_END(logTests_t, fields, levels, message1, message2, message3, recursion, multiple_targets, targets_switch, \
-    scope_default, scope_return, scope_returnvoid, scope_throw)
+    targets_set, targets_switch_concurrent, targets_churn, sites, scope_default, scope_return, scope_returnvoid, scope_throw)
 
 template<typename T>
 void logRoot(const T& v)
@@ -572,6 +734,19 @@ void resetCounts(size_t& v1, size_t& v2, size_t& v3, size_t& v4)
     v4 = 0;
 }
 
+namespace logLimited
+{
+JJ_DEFINE_LOG_COMPONENT(compLimited)
+void logMany(size_t cnt)
+{
+    for (size_t i = 0; i < cnt; ++i)
+    {
+        jjLW(jjT("warning ") << i);
+        jjLE(jjT("error ") << i);
+    }
+}
+}
+
 JJ_TEST_CLASS(logComponentTests_t)
 
 JJ_TEST_CASE_VARIANTS(components_and_levels, (jj::log::level_t limitRoot, jj::log::level_t limitB), (JJ_LOGLEVEL_INFO, JJ_LOGLEVEL_INFO), (JJ_LOGLEVEL_SCOPE, JJ_LOGLEVEL_SCOPE))
@@ -670,4 +845,496 @@ JJ_TEST_CASE_VARIANTS(components_and_levels, (jj::log::level_t limitRoot, jj::lo
 
 // TODO add dedicated (multifile component tests)
 
-JJ_TEST_CLASS_END(logComponentTests_t, components_and_levels)
+JJ_TEST_CASE(sampling)
+{
+    size_t warnings = 0, errors = 0, summaries = 0;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) {
+        if (log.Message.find(jjT("suppressed 9 messages")) != jj::string_t::npos)
+            ++summaries;
+        else if (log.Level == JJ_LOGLEVEL_WARNING)
+            ++warnings;
+        else
+            ++errors;
+    }));
+    jj::log::component_t& comp = logLimited::compLimitedComponent_t::instance();
+    comp.setRateLimit(JJ_LOGLEVEL_WARNING, jj::log::rateLimit_t(0, 1, 10, std::chrono::milliseconds(0)));
+    logLimited::logMany(100);
+    JJ_TEST(warnings == 10, jjOOO(warnings,==,10));
+    JJ_TEST(summaries == 9, jjOOO(summaries,==,9));
+    JJ_TEST(errors == 100, jjOOO(errors,==,100));
+    JJ_TEST(comp.suppressed(JJ_LOGLEVEL_WARNING) == 90);
+    JJ_TEST(comp.suppressed(JJ_LOGLEVEL_ERROR) == 0);
+    comp.setRateLimit(JJ_LOGLEVEL_WARNING, jj::log::rateLimit_t());
+    warnings = 0;
+    logLimited::logMany(10);
+    JJ_TEST(warnings == 10, jjOOO(warnings,==,10));
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(rate_limit)
+{
+    size_t errors = 0, suppressed = 0;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) {
+        if (log.Level != JJ_LOGLEVEL_ERROR)
+            return;
+        if (log.Message.find(jjT("suppressed ")) != jj::string_t::npos)
+            ++suppressed;
+        else
+            ++errors;
+    }));
+    jj::log::component_t& comp = logLimited::compLimitedComponent_t::instance();
+    comp.setRateLimit(JJ_LOGLEVEL_ERROR, jj::log::rateLimit_t(0.001, 5));
+    unsigned long long before = comp.suppressed(JJ_LOGLEVEL_ERROR);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([]() { logLimited::logMany(100); });
+    for (auto& t : threads)
+        t.join();
+    JJ_TEST(errors == 5, jjOOO(errors,==,5));
+    JJ_TEST(suppressed == 0); // nothing passed after the suppressed ones
+    JJ_TEST(comp.suppressed(JJ_LOGLEVEL_ERROR) - before == 395);
+    comp.setRateLimit(JJ_LOGLEVEL_ERROR, jj::log::rateLimit_t(1000000, 1));
+    logLimited::logMany(1);
+    JJ_TEST(suppressed == 1);
+    JJ_TEST(errors == 6, jjOOO(errors,==,6));
+    comp.setRateLimit(JJ_LOGLEVEL_ERROR, jj::log::rateLimit_t());
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(registry)
+{
+    jj::log::component_t& b = logB::compBComponent_t::instance();
+    jj::log::component_t& c = logC::compCComponent_t::instance();
+    JJ_TEST(jj::log::component_t::find(jjT("compB")) == &b);
+    JJ_TEST(jj::log::component_t::find(jjT("compC")) == &c);
+    JJ_TEST(jj::log::component_t::find(jjT("jjMainLog")) == &JJ_LOG_COMPONENT);
+    JJ_TEST(jj::log::component_t::find(jjT("comp")) == nullptr);
+    size_t cnt = 0;
+    for (jj::log::component_t* i = jj::log::component_t::first(); i != nullptr; i = i->next())
+        ++cnt;
+    JJ_TEST(cnt >= 4);
+
+    jj::log::level_t lb = b.limit(), lc = c.limit();
+    JJ_TEST(jj::log::component_t::configure(jjT("compB=WARN, compC = verbose,")) == 2);
+    JJ_TEST(b.limit() == JJ_LOGLEVEL_WARNING);
+    JJ_TEST(c.limit() == JJ_LOGLEVEL_VERBOSE);
+    JJ_TEST_THAT_THROWS(jj::log::component_t::configure(jjT("compB=INFO,unknown=INFO")), std::runtime_error);
+    JJ_TEST_THAT_THROWS(jj::log::component_t::configure(jjT("compB=LOUD")), std::runtime_error);
+    JJ_TEST_THAT_THROWS(jj::log::component_t::configure(jjT("compB")), std::runtime_error);
+    JJ_TEST(b.limit() == JJ_LOGLEVEL_WARNING);
+    JJ_TEST(jj::log::component_t::configure(jjT("*=ERROR,compC=123456")) == cnt + 1);
+    JJ_TEST(b.limit() == JJ_LOGLEVEL_ERROR);
+    JJ_TEST(c.limit() == (123456 < JJ_LOGLIMIT_HARD ? JJ_LOGLIMIT_HARD : 123456));
+    jj::log::component_t::configure(jjT("*=INFO"));
+    b.setLevel(lb);
+    c.setLevel(lc);
+}
+
+JJ_TEST_CASE(level_change_concurrent)
+{
+    jj::log::component_t& b = logB::compBComponent_t::instance();
+    jj::log::level_t lb = b.limit();
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> enabled(0);
+    std::thread reader([&]() {
+        while (!stop)
+            if (b.enabled(JJ_LOGLEVEL_INFO))
+                ++enabled;
+    });
+    for (int i = 0; i < 10000; ++i)
+        b.setLevel(i % 2 ? JJ_LOGLEVEL_INFO : JJ_LOGLEVEL_ERROR);
+    stop = true;
+    reader.join();
+    JJ_TEST(b.limit() == JJ_LOGLEVEL_INFO);
+    b.setLevel(lb);
+}
+
+JJ_TEST_CLASS_END(logComponentTests_t, components_and_levels, sampling, rate_limit, registry, level_change_concurrent)
+
+JJ_TEST_CLASS(logAsyncTests_t)
+
+JJ_TEST_CASE(delivered_in_order)
+{
+    std::shared_ptr<testTargetCnt> tgt;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(tgt = std::make_shared<testTargetCnt>());
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::logger_t::instance().startAsync(16);
+    JJ_TEST(jj::log::logger_t::instance().isAsync());
+    for (int i = 0; i < 100; ++i)
+        jjLI(jjT("M") << i);
+    jj::log::logger_t::instance().flush();
+    JJ_TEST(tgt->lines == 100);
+    jj::string_t line;
+    int lcnt = 0;
+    while (std::getline(tgt->s, line))
+    {
+        JJ_TEST(line.find(jjS(jjT("M") << lcnt << jjT('('))) != jj::string_t::npos);
+        ++lcnt;
+    }
+    JJ_TEST(lcnt == 100);
+    jj::log::logger_t::instance().stopAsync();
+    JJ_TEST(!jj::log::logger_t::instance().isAsync());
+    JJ_TEST(jj::log::logger_t::instance().dropped() == 0);
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(delivered_on_other_thread)
+{
+    std::thread::id tid;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { tid = std::this_thread::get_id(); }));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jjLI(1);
+    JJ_TEST(tid == std::this_thread::get_id());
+    jj::log::logger_t::instance().startAsync();
+    jjLI(2);
+    jj::log::logger_t::instance().flush();
+    JJ_TEST(tid != std::this_thread::get_id());
+    jj::log::logger_t::instance().stopAsync();
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(multiple_producers)
+{
+    const int THREADS = 4, PERTHREAD = 2000;
+    std::atomic<int> cnt(0);
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { ++cnt; }));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::logger_t::instance().startAsync(64, jj::log::logger_t::BLOCK);
+    std::vector<std::thread> ths;
+    for (int t = 0; t < THREADS; ++t)
+        ths.push_back(std::thread([]() { for (int i = 0; i < PERTHREAD; ++i) jjLI(i); }));
+    for (auto& t : ths)
+        t.join();
+    jj::log::logger_t::instance().stopAsync();
+    JJ_TEST(cnt == THREADS * PERTHREAD);
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE_VARIANTS(overflow, (jj::log::logger_t::overflow_t overflow), (jj::log::logger_t::DROP_NEWEST), (jj::log::logger_t::DROP_AND_COUNT))
+{
+    std::mutex gate;
+    int cnt = 0, reports = 0;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) {
+        std::lock_guard<std::mutex> l(gate);
+        if (log.Message.find(jjT("dropped")) != jj::string_t::npos)
+            ++reports;
+        else
+            ++cnt;
+    }));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::logger_t::instance().startAsync(8, overflow);
+    {
+        std::lock_guard<std::mutex> l(gate); // the target is stuck until released
+        for (int i = 0; i < 100; ++i)
+            jjLI(i);
+    }
+    jj::log::logger_t::instance().flush();
+    size_t dropped = jj::log::logger_t::instance().dropped();
+    JJ_TEST(dropped > 0);
+    JJ_TEST(cnt + dropped == 100);
+    JJ_TEST(reports == (overflow == jj::log::logger_t::DROP_AND_COUNT ? 1 : 0));
+    jj::log::logger_t::instance().stopAsync();
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CASE(logging_from_target)
+{
+    int cnt = 0;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) {
+        if (++cnt == 1)
+            jjLW(jjT("nested"));
+    }));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::logger_t::instance().startAsync();
+    jjLI(jjT("outer"));
+    jj::log::logger_t::instance().flush();
+    JJ_TEST(cnt == 2);
+    jj::log::logger_t::instance().stopAsync();
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CLASS_END(logAsyncTests_t, delivered_in_order, delivered_on_other_thread, multiple_producers, overflow, logging_from_target)
+
+JJ_TEST_CLASS(logTargetFilterTests_t)
+
+JJ_TEST_CASE(levels)
+{
+    std::shared_ptr<testTargetCnt> all(std::make_shared<testTargetCnt>()), fast(std::make_shared<testTargetCnt>()), slow(std::make_shared<testTargetCnt>());
+    jj::log::logger_t::logTargets_t olog = jj::log::logger_t::instance().setTargets(jj::log::logger_t::logTargets_t{ all,
+        std::make_shared<jj::log::filterTarget_t>(fast, JJ_LOGLEVEL_VERBOSE, std::vector<const jj::log::component_t*>(), true),
+        std::make_shared<jj::log::filterTarget_t>(slow, JJ_LOGLEVEL_ERROR) });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jjLE(jjT("error"));
+    jjLW(jjT("warning"));
+    jjLI(jjT("info"));
+    jjLV(jjT("verbose")); // below the soft limit, produced for the fast target only
+    JJ_TEST(all->lines == 3);
+    JJ_TEST(fast->lines == 4);
+    JJ_TEST(slow->lines == 1);
+    JJ_TEST(slow->s.str().find(jjT("[ERROR] error")) != jj::string_t::npos);
+    JJ_TEST(fast->s.str().find(jjT("[VERB] verbose")) != jj::string_t::npos);
+    jj::log::logger_t::instance().setTargets(olog);
+}
+
+JJ_TEST_CASE(components)
+{
+    std::shared_ptr<testTargetCnt> b(std::make_shared<testTargetCnt>()), c(std::make_shared<testTargetCnt>());
+    std::vector<const jj::log::component_t*> cb{ jj::log::component_t::find(jjT("compB")) }, cc{ jj::log::component_t::find(jjT("compC")) };
+    jj::log::logger_t::logTargets_t olog = jj::log::logger_t::instance().setTargets(jj::log::logger_t::logTargets_t{
+        std::make_shared<jj::log::filterTarget_t>(b, JJ_LOGLEVEL_INFO, cb, true),
+        std::make_shared<jj::log::filterTarget_t>(c, JJ_LOGLEVEL_INFO, cc, true) });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    jj::log::component_t::find(jjT("compB"))->setLevel(JJ_LOGLEVEL_INFO);
+    jjLE(jjT("main"));
+    logB::method(1);
+    logC::method(2); // compC is set to WARNING, the info is produced for the filter
+    JJ_TEST(b->lines == 3);
+    JJ_TEST(c->lines == 3);
+    JJ_TEST(b->s.str().find(jjT("main")) == jj::string_t::npos);
+    JJ_TEST(c->s.str().find(jjT("[INFO] 2")) != jj::string_t::npos);
+    // only the filtered components produce the details
+    JJ_TEST(jj::log::component_t::find(jjT("compC"))->detailLevel() == JJ_LOGLEVEL_INFO);
+    JJ_TEST(JJ_LOG_COMPONENT.detailLevel() == JJ_LOGLEVEL_OFF);
+    jj::log::logger_t::instance().setTargets(olog);
+    JJ_TEST(jj::log::component_t::find(jjT("compC"))->detailLevel() == JJ_LOGLEVEL_OFF);
+}
+
+JJ_TEST_CASE(narrowing)
+{
+    std::shared_ptr<testTargetCnt> narrow(std::make_shared<testTargetCnt>()), wide(std::make_shared<testTargetCnt>());
+    jj::log::logger_t::logTargets_t olog = jj::log::logger_t::instance().setTargets(jj::log::logger_t::logTargets_t{
+        std::make_shared<jj::log::filterTarget_t>(narrow, JJ_LOGLEVEL_ERROR),
+        std::make_shared<jj::log::filterTarget_t>(wide, JJ_LOGLEVEL_VERBOSE, std::vector<const jj::log::component_t*>(), true) });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_FATAL);
+    JJ_TEST(!jjLE(jjT("error"))); // below the soft limit, produced for the widening filter only
+    JJ_TEST(narrow->lines == 0);
+    JJ_TEST(wide->lines == 1);
+    JJ_LOG_COMPONENT.setLevel(JJ_LOGLEVEL_OFF); // a component switched OFF produces nothing for any filter
+    JJ_TEST(!jjLE(jjT("error")));
+    jjLF(jjT("fatal"));
+    JJ_TEST(narrow->lines == 0);
+    JJ_TEST(wide->lines == 1);
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    JJ_TEST(jjLE(jjT("error")));
+    JJ_TEST(narrow->lines == 1);
+    JJ_TEST(wide->lines == 2);
+    jj::log::logger_t::instance().setTargets(olog);
+}
+
+JJ_TEST_CASE(queued)
+{
+    std::mutex gate;
+    std::thread::id tid;
+    int slow = 0, fast = 0;
+    bool ordered = true;
+    std::shared_ptr<jj::log::queuedTarget_t> q(std::make_shared<jj::log::queuedTarget_t>(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) {
+        std::lock_guard<std::mutex> l(gate);
+        if (log.Message != jjS(slow))
+            ordered = false;
+        ++slow;
+        tid = std::this_thread::get_id();
+    })));
+    jj::log::logger_t::logTargets_t olog = jj::log::logger_t::instance().setTargets(jj::log::logger_t::logTargets_t{ q,
+        std::make_shared<testTargetCb>([&](const jj::log::message_t& log) { ++fast; }) });
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    {
+        std::lock_guard<std::mutex> l(gate); // the slow target is stuck until released
+        for (int i = 0; i < 3; ++i)
+            jjLI(i);
+        JJ_TEST(fast == 3);
+    }
+    jj::log::logger_t::instance().flush();
+    JJ_TEST(slow == 3);
+    JJ_TEST(ordered);
+    JJ_TEST(tid != std::this_thread::get_id());
+    JJ_TEST(q->dropped() == 0);
+    jj::log::logger_t::instance().setTargets(olog);
+}
+
+JJ_TEST_CASE(queued_overflow)
+{
+    std::mutex gate;
+    int cnt = 0;
+    std::shared_ptr<jj::log::queuedTarget_t> q(std::make_shared<jj::log::queuedTarget_t>(std::make_shared<testTargetCb>([&](const jj::log::message_t& log) {
+        std::lock_guard<std::mutex> l(gate);
+        ++cnt;
+    }), 8, jj::log::logger_t::DROP_NEWEST));
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(q);
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    {
+        std::lock_guard<std::mutex> l(gate);
+        for (int i = 0; i < 100; ++i)
+            jjLI(i);
+    }
+    jj::log::logger_t::instance().flush();
+    JJ_TEST(q->dropped() > 0);
+    JJ_TEST(cnt + q->dropped() == 100);
+    jj::log::logger_t::instance().replaceTargets(olog);
+}
+
+JJ_TEST_CLASS_END(logTargetFilterTests_t, levels, components, narrowing, queued, queued_overflow)
+
+static size_t countLines(const jj::string_t& path, size_t* bytes = nullptr)
+{
+    std::ifstream f(jj::strcvt::to_string(path).c_str());
+    std::string line;
+    size_t ret = 0, sz = 0;
+    while (std::getline(f, line))
+    {
+        ++ret;
+        sz += line.length() + 1;
+    }
+    if (bytes != nullptr)
+        *bytes = sz;
+    return ret;
+}
+
+static bool waitForLines(const jj::string_t& path, size_t lines)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        if (countLines(path) >= lines)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+static void removeLogs(const jj::string_t& path)
+{
+    std::remove(jj::strcvt::to_string(path).c_str());
+    for (int i = 1; i < 10; ++i)
+        std::remove(jj::strcvt::to_string(path + jjT('.') + jj::strcvt::to_string_t(std::to_string(i))).c_str());
+}
+
+JJ_TEST_CLASS(logFileTargetTests_t)
+
+JJ_TEST_CASE(buffered)
+{
+    jj::string_t path(tempPath(jjT("jjlogtest_buffered.log")));
+    removeLogs(path);
+    jj::log::fileTarget_t::options_t opts;
+    opts.FlushInterval = std::chrono::milliseconds(0);
+    {
+        std::shared_ptr<jj::log::fileTarget_t> tgt = std::make_shared<jj::log::fileTarget_t>(path, opts);
+        std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(tgt);
+        jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+        jjLI(jjT("first"));
+        jjLI(jjT("second"));
+        JJ_TEST(countLines(path) == 0);
+        jj::log::logger_t::instance().flush();
+        JJ_TEST(countLines(path) == 2);
+        jjLI(jjT("third"));
+        jj::log::logger_t::instance().replaceTargets(olog);
+    }
+    JJ_TEST(countLines(path) == 3);
+    std::ifstream f(jj::strcvt::to_string(path).c_str());
+    std::string line;
+    std::getline(f, line);
+    JJ_TEST(line.find("[INFO] first") != std::string::npos);
+    removeLogs(path);
+}
+
+JJ_TEST_CASE(buffer_full)
+{
+    jj::string_t path(tempPath(jjT("jjlogtest_full.log")));
+    removeLogs(path);
+    jj::log::fileTarget_t::options_t opts;
+    opts.BufferSize = 256;
+    opts.FlushInterval = std::chrono::milliseconds(0);
+    jj::log::fileTarget_t tgt(path, opts);
+    for (int i = 0; i < 21; ++i)
+        tgt.log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT("some text to fill the buffer"), JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT));
+    JJ_TEST(waitForLines(path, 1)); // written by the writer thread without flush()
+    tgt.flush();
+    JJ_TEST(countLines(path) == 21);
+    removeLogs(path);
+}
+
+JJ_TEST_CASE(rotate_by_size)
+{
+    jj::string_t path(tempPath(jjT("jjlogtest_size.log")));
+    removeLogs(path);
+    jj::log::fileTarget_t::options_t opts;
+    opts.BufferSize = 1;
+    opts.MaxSize = 300;
+    opts.Backups = 2;
+    {
+        jj::log::fileTarget_t tgt(path, opts);
+        for (int i = 0; i < 50; ++i)
+        {
+            // one message per batch, the rotation is decided per batch
+            tgt.log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT("rotated line"), JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT));
+            tgt.flush();
+        }
+        JJ_TEST(tgt.rotations() > 2);
+    }
+    size_t bytes = 0;
+    JJ_TEST(countLines(path, &bytes) > 0);
+    JJ_TEST(bytes <= 300);
+    JJ_TEST(countLines(path + jjT(".1"), &bytes) > 0);
+    JJ_TEST(bytes <= 300);
+    JJ_TEST(countLines(path + jjT(".2")) > 0);
+    JJ_TEST(countLines(path + jjT(".3")) == 0);
+    removeLogs(path);
+}
+
+JJ_TEST_CASE(rotate_by_time)
+{
+    jj::string_t path(tempPath(jjT("jjlogtest_time.log")));
+    removeLogs(path);
+    jj::log::fileTarget_t::options_t opts;
+    opts.Interval = std::chrono::seconds(1);
+    {
+        jj::log::fileTarget_t tgt(path, opts);
+        tgt.log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT("before"), JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT));
+        tgt.flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1300));
+        JJ_TEST(tgt.rotations() == 1); // rotated by the writer thread even though nothing was logged
+        tgt.log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT("after"), JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT));
+        tgt.flush();
+        JJ_TEST(tgt.rotations() == 1);
+    }
+    JJ_TEST(countLines(path) == 1);
+    JJ_TEST(countLines(path + jjT(".1")) == 1);
+    removeLogs(path);
+}
+
+JJ_TEST_CASE(flush_interval)
+{
+    jj::string_t path(tempPath(jjT("jjlogtest_interval.log")));
+    removeLogs(path);
+    jj::log::fileTarget_t::options_t opts;
+    opts.FlushInterval = std::chrono::milliseconds(20);
+    {
+        jj::log::fileTarget_t tgt(path, opts);
+        tgt.log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT("idle"), JJ_FUNC, __FILE__, __LINE__, JJ_LOG_COMPONENT));
+        JJ_TEST(waitForLines(path, 1));
+    }
+    removeLogs(path);
+}
+
+JJ_TEST_CASE_VARIANTS(multiple_threads, (bool async), (false), (true))
+{
+    const int THREADS = 4, PERTHREAD = 1000;
+    jj::string_t path(tempPath(jjT("jjlogtest_threads.log")));
+    removeLogs(path);
+    jj::log::fileTarget_t::options_t opts;
+    opts.BufferSize = 1024;
+    std::shared_ptr<jj::log::logTarget_base_t> olog = jj::log::logger_t::instance().replaceTargets(std::make_shared<jj::log::fileTarget_t>(path, opts));
+    jj::log::logger_t::instance().setLevel(JJ_LOGLEVEL_INFO);
+    if (async)
+        jj::log::logger_t::instance().startAsync();
+    std::vector<std::thread> ths;
+    for (int t = 0; t < THREADS; ++t)
+        ths.push_back(std::thread([]() { for (int i = 0; i < PERTHREAD; ++i) jjLI(jjT("line ") << i); }));
+    for (auto& t : ths)
+        t.join();
+    jj::log::logger_t::instance().flush();
+    JJ_TEST(countLines(path) == THREADS * PERTHREAD);
+    jj::log::logger_t::instance().stopAsync();
+    jj::log::logger_t::instance().replaceTargets(olog);
+    removeLogs(path);
+}
+
+JJ_TEST_CLASS_END(logFileTargetTests_t, buffered, buffer_full, rotate_by_size, rotate_by_time, flush_interval, multiple_threads)
@@ -0,0 +1,102 @@
+#include "jj/mpscQueue.h"
+#include "jj/test/test.h"
+#include <thread>
+#include <vector>
+#include <string>
+
+struct counted
+{
+    static int alive;
+    int v;
+    counted(int x) : v(x) { ++alive; }
+    counted(const counted& o) : v(o.v) { ++alive; }
+    ~counted() { --alive; }
+};
+int counted::alive = 0;
+
+JJ_TEST_CLASS(mpscQueueTests_t)
+
+JJ_TEST_CASE(capacity_roundup)
+{
+    JJ_TEST(jj::mpscQueue_t<int>(0).capacity() == 2);
+    JJ_TEST(jj::mpscQueue_t<int>(2).capacity() == 2);
+    JJ_TEST(jj::mpscQueue_t<int>(3).capacity() == 4);
+    JJ_TEST(jj::mpscQueue_t<int>(1000).capacity() == 1024);
+}
+
+JJ_TEST_CASE(push_consume_fifo)
+{
+    jj::mpscQueue_t<std::string> q(4);
+    int v = 0;
+    JJ_TEST(q.empty());
+    JJ_TEST(!q.consume([&](std::string&) { ++v; }));
+    JJ_TEST(v == 0);
+    JJ_TEST(q.tryPush("A"));
+    JJ_TEST(q.tryPush(std::string("B")));
+    JJ_TEST(q.tryPush(2, 'C'));
+    JJ_TEST(q.tryPush("D"));
+    JJ_TEST(!q.tryPush("E"));
+    JJ_TEST(!q.empty());
+    std::string got;
+    while (q.consume([&](std::string& s) { got += s; }))
+        ;
+    JJ_TEST(got == "ABCCD");
+    JJ_TEST(q.empty());
+    JJ_TEST(q.pushed() == 4);
+    JJ_TEST(q.consumed() == 4);
+    // wraps around
+    JJ_TEST(q.tryPush("F"));
+    JJ_TEST(q.consume([&](std::string& s) { got += s; }));
+    JJ_TEST(got == "ABCCDF");
+}
+
+JJ_TEST_CASE(items_destroyed)
+{
+    counted::alive = 0;
+    {
+        jj::mpscQueue_t<counted> q(8);
+        q.tryPush(1);
+        q.tryPush(2);
+        q.tryPush(3);
+        JJ_TEST(counted::alive == 3);
+        int sum = 0;
+        q.consume([&](counted& c) { sum += c.v; });
+        JJ_TEST(sum == 1);
+        JJ_TEST(counted::alive == 2);
+    }
+    JJ_TEST(counted::alive == 0);
+}
+
+JJ_TEST_CASE(multiple_producers)
+{
+    const int PRODUCERS = 4, PERTHREAD = 10000;
+    jj::mpscQueue_t<int> q(64);
+    std::vector<std::thread> ths;
+    for (int p = 0; p < PRODUCERS; ++p)
+        ths.push_back(std::thread([&q, p, PERTHREAD]() {
+            for (int i = 0; i < PERTHREAD; ++i)
+                while (!q.tryPush(p * PERTHREAD + i))
+                    std::this_thread::yield();
+        }));
+    std::vector<int> last(PRODUCERS, -1);
+    bool ordered = true;
+    int cnt = 0;
+    while (cnt < PRODUCERS * PERTHREAD)
+    {
+        if (!q.consume([&](int v) {
+            int p = v / PERTHREAD;
+            if (v % PERTHREAD <= last[p])
+                ordered = false;
+            last[p] = v % PERTHREAD;
+            ++cnt;
+        }))
+            std::this_thread::yield();
+    }
+    for (auto& t : ths)
+        t.join();
+    JJ_TEST(cnt == PRODUCERS * PERTHREAD);
+    JJ_TEST(ordered);
+    JJ_TEST(q.empty());
+}
+
+JJ_TEST_CLASS_END(mpscQueueTests_t, capacity_roundup, push_consume_fifo, items_destroyed, multiple_producers)
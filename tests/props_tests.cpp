@@ -1,9 +1,18 @@
 #include "jj/props.h"
 #include "jj/propsTextSerializer.h"
 #include "jj/propsTextDeserializer.h"
+#include "jj/propsIndex.h"
+#include "jj/propsBinary.h"
+#include "jj/propsParallelDeserializer.h"
 #include "jj/source.h"
 #include "jj/test/test.h"
+#include "tempFile_tests.h"
 #include <limits>
+#include <vector>
+#include <deque>
+#include <array>
+#include <fstream>
+#include <cstdio>
 
 struct color_t
 {
@@ -51,6 +60,17 @@ jj::props::textDeserializer_t<S, P>& operator>>(jj::props::textDeserializer_t<S,
     return s;
 }
 
+jj::props::binarySerializer_t& operator<<(jj::props::binarySerializer_t& s, const color_t& c)
+{
+    return s << c.R << c.G << c.B;
+}
+
+template<typename P>
+jj::props::binaryDeserializer_t<P>& operator>>(jj::props::binaryDeserializer_t<P>& d, color_t& v)
+{
+    return d >> v.R >> v.G >> v.B;
+}
+
 using namespace jj::props;
 
 typedef props<setup::cstrkey_t<jj::char_t>, int, bool, jj::string_t, double, std::list<jj::string_t>, std::list<int>, color_t> myprops;
@@ -597,6 +617,173 @@ JJ_TEST_CASE(path_differentseparator2)
 
 JJ_TEST_CLASS_END(propsPathTests_t, basic_getset, path_getset, path_apply, path_differentseparator1, path_differentseparator2)
 
+namespace propsIndex
+{
+/*! Records the values it is applied to. */
+struct action_t
+{
+    std::list<jj::string_t> encounter;
+    void operator()(int& v) { encounter.push_back(jjS(jjT("int/") << v)); }
+    void operator()(bool& v) { encounter.push_back(jjS(jjT("bool/") << v)); }
+    void operator()(jj::string_t& v) { encounter.push_back(jjS(jjT("string/") << v)); }
+    void operator()(double& v) { encounter.push_back(jjS(jjT("double/") << v)); }
+    void operator()(std::list<jj::string_t>& v) { encounter.push_back(jjS(jjT("list<string>/") << v.size())); }
+    void operator()(std::list<int>& v) { encounter.push_back(jjS(jjT("list<int>/") << v.size())); }
+    void operator()(color_t&) { encounter.push_back(jjT("color")); }
+};
+
+struct APPLY : myprops
+{
+    ApplyKeyPROPS X;
+    int a;
+    APPLY() : a(1)
+    {
+        addProp(jjT("a"), a);
+        addNested(jjT("X"), X);
+    }
+};
+
+typedef props<setup::icstrkey_t<jj::char_t>, int, double> iprops;
+
+struct ILEAF : iprops
+{
+    int Value;
+    ILEAF() : Value(1) { addProp(jjT("Value"), Value); }
+};
+
+struct IMAIN : iprops
+{
+    ILEAF Leaf;
+    double Ratio;
+    IMAIN() : Ratio(0.5)
+    {
+        addNested(jjT("Leaf"), Leaf);
+        addProp(jjT("Ratio"), Ratio);
+    }
+};
+} // namespace propsIndex
+
+JJ_TEST_CLASS(propsIndexTests_t)
+
+JJ_TEST_CASE(getset)
+{
+    MAIN ps;
+    pathIndex_t<myprops> index(ps);
+    JJ_TEST(index.size() == 14u);
+    JJ_TEST(&index.get<int>(jjT("num2")) == &ps.num2);
+    JJ_TEST(&index.get<double>(jjT("2/precise")) == &ps.spec2.precise);
+    JJ_TEST(&index.get<color_t>(jjT("1/colors/fore")) == &ps.spec1.colors.fore);
+    index.set<jj::string_t>(jjT("text"), jjT("change"));
+    JJ_TEST(ps.text == jjT("change"));
+    JJ_TEST(index.find<int>(jjT("text")) == nullptr);
+    JJ_TEST(index.find<double>(jjT("1/colors")) == nullptr);
+    JJ_TEST(index.find<double>(jjT("3/precise")) == nullptr);
+    JJ_TEST_THAT_THROWS(index.get<int>(jjT("1/num1")), jj::props::exception::keyNotFound);
+}
+
+JJ_TEST_CASE(apply)
+{
+    propsIndex::APPLY ps;
+    pathIndex_t<myprops> index(ps);
+    propsIndex::action_t a;
+    index.apply(a, jjT("X/A"));
+    std::list<jj::string_t> expected = { jjT("int/5"), jjT("double/33.33"), jjT("list<string>/2") };
+    JJ_TEST(a.encounter == expected);
+    a.encounter.clear();
+    index.apply(a, jjT("a"));
+    index.apply(a, jjT("X/none"));
+    index.apply(a, jjT("none"));
+    JJ_TEST(a.encounter == std::list<jj::string_t>{ jjT("int/1") });
+    JJ_TEST_THAT_THROWS(index.apply(a, jjT("Y/A")), jj::props::exception::keyNotFound);
+    JJ_TEST_THAT_THROWS(index.apply(a, jjT("X/A/B")), jj::props::exception::keyNotFound);
+}
+
+JJ_TEST_CASE(caseinsensitive)
+{
+    propsIndex::IMAIN ps;
+    pathIndex_t<propsIndex::iprops> index(ps);
+    JJ_TEST(&index.get<int>(jjT("leaf/value")) == &ps.Leaf.Value);
+    JJ_TEST(&index.get<int>(jjT("LEAF/Value")) == &ps.Leaf.Value);
+    JJ_TEST(&index.get<double>(jjT("ratio")) == &ps.Ratio);
+    JJ_TEST(index.find<double>(jjT("leaf/value")) == nullptr);
+}
+
+JJ_TEST_CASE(separator)
+{
+    MAIN ps;
+    pathIndex_t<myprops, jj::char_t, jjT(':')> index(ps);
+    JJ_TEST(&index.get<color_t>(jjT("2:colors:fore")) == &ps.spec2.colors.fore);
+    JJ_TEST(index.find<color_t>(jjT("2/colors/fore")) == nullptr);
+}
+
+JJ_TEST_CLASS_END(propsIndexTests_t, getset, apply, caseinsensitive, separator)
+
+
+namespace propsSerDeser
+{
+/*! Changes some values of MAIN from the defaults. */
+void setSample(MAIN& ps)
+{
+    ps.num1 = 7;
+    ps.flag = false;
+    ps.text = jjT("quoted \"\\ and\nnew line");
+    ps.words = { jjT("a"), jjT(""), jjT("\"b\"") };
+    ps.spec1.colors.back.G = 17;
+    ps.spec2.numbers.clear();
+    ps.spec2.precise = 0.5;
+}
+
+/*! Returns the serialized form of MAIN with some values changed from the defaults. */
+jj::string_t sample()
+{
+    MAIN ps;
+    setSample(ps);
+    jj::osstream_t str;
+    textSerializer_t<jj::osstream_t> ser(str, 2, jjT(' '));
+    traversalContext_t<const jj::char_t*> ctx;
+    ps.traverse(ser, ctx);
+    return str.str();
+}
+
+/*! Returns the textual form of the props. */
+jj::string_t text(myprops& ps)
+{
+    jj::osstream_t str;
+    textSerializer_t<jj::osstream_t> ser(str, 0);
+    traversalContext_t<const jj::char_t*> ctx;
+    ps.traverse(ser, ctx);
+    return str.str();
+}
+
+typedef props<setup::cstrkey_t<jj::char_t>, std::vector<int>, std::vector<jj::string_t>, std::deque<double>, std::array<int, 3>, std::vector<unsigned long long>, color_t> cprops;
+
+/*! Props holding the other containers. */
+struct CONTAINERS : cprops
+{
+    std::vector<int> ints;
+    std::vector<jj::string_t> words;
+    std::deque<double> reals;
+    std::array<int, 3> triple;
+    std::vector<unsigned long long> big;
+
+    CONTAINERS() : ints({ 1, -2, 300000 }), words({ jjT("a,b"), jjT("") }), reals({ 0.5, -1.25 }), triple({ { 7, 8, 9 } })
+    {
+        addProp(jjT("ints"), ints);
+        addProp(jjT("words"), words);
+        addProp(jjT("reals"), reals);
+        addProp(jjT("triple"), triple);
+        addProp(jjT("big"), big);
+    }
+};
+
+/*! Checks that the deserialized props hold the values set by sample(). */
+bool isSample(MAIN& ps)
+{
+    std::list<jj::string_t> words = { jjT("a"), jjT(""), jjT("\"b\"") };
+    return ps.num1 == 7 && ps.num2 == -2 && !ps.flag && ps.text == jjT("quoted \"\\ and\nnew line") && ps.words == words
+        && ps.spec1.colors.back.G == 17 && ps.spec1.colors.fore.R == 192 && ps.spec2.numbers.empty() && ps.spec2.precise == 0.5;
+}
+} // namespace propsSerDeser
 
 JJ_TEST_CLASS(propsTSerDeserTests_t)
 
@@ -647,4 +834,390 @@ JJ_TEST_CASE(basic)
     JJ_TEST(str1.str() == str3.str());
 }
 
-JJ_TEST_CLASS_END(propsTSerDeserTests_t, basic)
+JJ_TEST_CASE(buffer_source)
+{
+    jj::string_t text(propsSerDeser::sample());
+    jj::bufferSource_t<jj::char_t> src(text.data(), text.data() + text.length());
+    MAIN ps;
+    ps.spec2.numbers = { 1 };
+    textDeserializer_t<jj::bufferSource_t<jj::char_t>, myprops> des(src, ps);
+    JJ_TEST(propsSerDeser::isSample(ps));
+    JJ_TEST(src.position() == src.end());
+
+    jj::string_t bad(jjT("text = \"not closed\n"));
+    jj::bufferSource_t<jj::char_t> badsrc(bad.data(), bad.data() + bad.length());
+    JJ_TEST_THAT_THROWS((textDeserializer_t<jj::bufferSource_t<jj::char_t>, myprops>(badsrc, ps)), jj::exception::base);
+}
+
+JJ_TEST_CASE(chunked_source)
+{
+    jj::isstream_t str(propsSerDeser::sample());
+    jj::chunkedSource_t<jj::isstream_t> src(str, 7);
+    MAIN ps;
+    textDeserializer_t<jj::chunkedSource_t<jj::isstream_t>, myprops> des(src, ps);
+    JJ_TEST(propsSerDeser::isSample(ps));
+}
+
+JJ_TEST_CASE(indexed)
+{
+    jj::string_t text(propsSerDeser::sample());
+    jj::bufferSource_t<jj::char_t> src(text.data(), text.data() + text.length());
+    MAIN ps;
+    pathIndex_t<myprops> index(ps);
+    textDeserializer_t<jj::bufferSource_t<jj::char_t>, myprops> des(src, index);
+    JJ_TEST(propsSerDeser::isSample(ps));
+
+    jj::string_t bad(jjT("[3]\nnum1 = 1\n"));
+    jj::bufferSource_t<jj::char_t> badsrc(bad.data(), bad.data() + bad.length());
+    JJ_TEST_THAT_THROWS((textDeserializer_t<jj::bufferSource_t<jj::char_t>, myprops>(badsrc, index)), jj::props::exception::keyNotFound);
+}
+
+JJ_TEST_CASE(element_sinks)
+{
+    jj::string_t text(jjT("num1=3\n[1]\nnumbers=1, 2,3\n[2]\nnumbers=7\nsamples=\"a\",\"b,c\"\n"));
+    for (int i = 0; i < 1000; ++i)
+        text += jjT("big=1,2,3,4,5,6,7,8,9,10\n");
+    jj::isstream_t str(text);
+    typedef textDeserializer_t<jj::chunkedSource_t<jj::isstream_t>, myprops> deserializer_t;
+    jj::chunkedSource_t<jj::isstream_t> src(str, 64);
+    deserializer_t::elementSinks_t sinks;
+    int sum = 0, count = 0;
+    std::list<jj::string_t> samples;
+    sinks.add<int>(jjT("1/numbers"), [&sum](int& v) { sum += v; });
+    sinks.add<int>(jjT("2/big"), [&count](int& v) { ++count; });
+    sinks.add<jj::string_t>(jjT("2/samples"), [&samples](jj::string_t& v) { samples.push_back(std::move(v)); });
+    MAIN ps;
+    deserializer_t des(src, ps, sinks);
+    JJ_TEST(ps.num1 == 3);
+    JJ_TEST(sum == 6);
+    JJ_TEST(ps.spec1.numbers == std::list<int>({ 3, 14, 15 }));
+    JJ_TEST(ps.spec2.numbers == std::list<int>{ 7 });
+    JJ_TEST(count == 10000);
+    JJ_TEST(samples == std::list<jj::string_t>({ jjT("a"), jjT("b,c") }));
+
+    jj::isstream_t bad(jjT("[1]\nnumbers=1;2\n"));
+    jj::chunkedSource_t<jj::isstream_t> badsrc(bad);
+    JJ_TEST_THAT_THROWS(deserializer_t(badsrc, ps, sinks), jj::exception::base);
+}
+
+JJ_TEST_CASE(parallel)
+{
+    jj::string_t text(propsSerDeser::sample());
+    for (int i = 0; i < 500; ++i)
+        text += jjS(jjT("[1]\nprecise=") << i << jjT("\n[2/colors]\nback={1,") << i % 200 << jjT(",3}\n[1/colors]\nfore={192,") << i % 100 << jjT(",0}\n"));
+
+    MAIN ps, ps2;
+    parallelTextDeserializer_t<myprops> des(text.data(), text.data() + text.length(), ps, 4);
+    JJ_TEST(des.parts() > 1u);
+    JJ_TEST(propsSerDeser::isSample(ps));
+    JJ_TEST(ps.spec1.precise == 499);
+    JJ_TEST(ps.spec2.colors.back.G == 99);
+    jj::bufferSource_t<jj::char_t> src(text.data(), text.data() + text.length());
+    textDeserializer_t<jj::bufferSource_t<jj::char_t>, myprops> seq(src, ps2);
+    JJ_TEST(propsSerDeser::text(ps) == propsSerDeser::text(ps2));
+
+    // the values before an error are read, those after are not
+    jj::string_t bad(text);
+    bad.insert(bad.find(jjT("[1]\n"), bad.length() / 2), jjT("[3]\nnum1=1\n"));
+    MAIN ps3;
+    pathIndex_t<myprops> index(ps3);
+    JJ_TEST_THAT_THROWS((parallelTextDeserializer_t<myprops>(bad.data(), bad.data() + bad.length(), index, 4)), jj::props::exception::keyNotFound);
+    JJ_TEST(ps3.spec1.precise > 100 && ps3.spec1.precise < 400);
+    JJ_TEST(ps3.num2 == -2);
+}
+
+JJ_TEST_CASE(containers)
+{
+    propsSerDeser::CONTAINERS ps;
+    ps.big = { 0, std::numeric_limits<unsigned long long>::max() };
+    jj::osstream_t str;
+    textSerializer_t<jj::osstream_t> ser(str, 0);
+    traversalContext_t<const jj::char_t*> ctx;
+    ps.traverse(ser, ctx);
+    jj::string_t text(str.str());
+    JJ_TEST(text.find(jjT("ints=1,-2,300000\n")) != jj::string_t::npos);
+    JJ_TEST(text.find(jjT("triple=7,8,9\n")) != jj::string_t::npos);
+    JJ_TEST(text.find(jjT("words=\"a,b\",\"\"\n")) != jj::string_t::npos);
+    JJ_TEST(text.find(jjT("big=0,18446744073709551615\n")) != jj::string_t::npos);
+
+    propsSerDeser::CONTAINERS ps2;
+    ps2.ints.clear();
+    ps2.words.clear();
+    ps2.reals.clear();
+    ps2.triple.fill(0);
+    jj::bufferSource_t<jj::char_t> src(text.data(), text.data() + text.length());
+    textDeserializer_t<jj::bufferSource_t<jj::char_t>, propsSerDeser::cprops> des(src, ps2);
+    JJ_TEST(ps2.ints == ps.ints);
+    JJ_TEST(ps2.ints.capacity() >= 3u);
+    JJ_TEST(ps2.words == ps.words);
+    JJ_TEST(ps2.reals == ps.reals);
+    JJ_TEST(ps2.triple == ps.triple);
+    JJ_TEST(ps2.big == ps.big);
+
+    propsSerDeser::CONTAINERS ps3;
+    jj::isstream_t in(jjT("ints=\nreals=3\ntriple=1,2,3\n"));
+    jj::streamSource_t<jj::isstream_t> ssrc(in);
+    textDeserializer_t<jj::streamSource_t<jj::isstream_t>, propsSerDeser::cprops> des3(ssrc, ps3);
+    JJ_TEST(ps3.ints.empty());
+    JJ_TEST(ps3.reals == std::deque<double>{ 3 });
+    JJ_TEST(ps3.triple[2] == 3);
+
+    jj::isstream_t many(jjT("triple=1,2,3,4\n")), few(jjT("triple=1,2\n"));
+    jj::streamSource_t<jj::isstream_t> msrc(many), fsrc(few);
+    JJ_TEST_THAT_THROWS((textDeserializer_t<jj::streamSource_t<jj::isstream_t>, propsSerDeser::cprops>(msrc, ps3)), jj::exception::base);
+    JJ_TEST_THAT_THROWS((textDeserializer_t<jj::streamSource_t<jj::isstream_t>, propsSerDeser::cprops>(fsrc, ps3)), jj::exception::base);
+}
+
+#if !defined(JJ_USE_WSTRING)
+JJ_TEST_CASE(file_source)
+{
+    jj::string_t path(tempPath(jjT("jjprops_file_source.txt")));
+    {
+        std::ofstream out(path.c_str(), std::ios::binary);
+        out << propsSerDeser::sample();
+    }
+    {
+        jj::fileSource_t src(path);
+        MAIN ps;
+        textDeserializer_t<jj::fileSource_t, myprops> des(src, ps);
+        JJ_TEST(propsSerDeser::isSample(ps));
+    }
+    remove(path.c_str());
+}
+#endif // !defined(JJ_USE_WSTRING)
+
+#if defined(JJ_USE_WSTRING)
+JJ_TEST_CLASS_END(propsTSerDeserTests_t, basic, buffer_source, chunked_source, indexed, element_sinks, parallel, containers)
+#else
+JJ_TEST_CLASS_END(propsTSerDeserTests_t, basic, buffer_source, chunked_source, indexed, element_sinks, parallel, containers, file_source)
+#endif
+
+namespace propsBinary
+{
+/*! Returns the binary form of the props. */
+std::string serialize(myprops& ps)
+{
+    std::string ret;
+    binarySerializer_t ser(ret);
+    traversalContext_t<const jj::char_t*> ctx;
+    ps.traverse(ser, ctx);
+    return ret;
+}
+} // namespace propsBinary
+
+JJ_TEST_CLASS(propsBSerDeserTests_t)
+
+JJ_TEST_CASE(basic)
+{
+    MAIN ps;
+    propsSerDeser::setSample(ps);
+    ps.num2 = std::numeric_limits<int>::min();
+    ps.num3 = std::numeric_limits<int>::max();
+    ps.spec1.numbers = { 0,1,1,2,3,5 };
+    ps.spec1.colors.fore.G = 255;
+    ps.spec2.precise = 1.618;
+    std::string data(propsBinary::serialize(ps));
+    JJ_TEST(data.compare(0, 4, "JJPB") == 0);
+
+    MAIN ps2;
+    ps2.spec2.numbers = { 1 };
+    binaryDeserializer_t<myprops> des(data.data(), data.size(), ps2);
+    JJ_TEST(ps2.num2 == std::numeric_limits<int>::min());
+    JJ_TEST(ps2.num3 == std::numeric_limits<int>::max());
+    JJ_TEST(ps2.spec1.colors.fore.G == 255);
+    JJ_TEST(ps2.spec2.precise == 1.618);
+    JJ_TEST(propsSerDeser::text(ps2) == propsSerDeser::text(ps));
+    JJ_TEST(propsBinary::serialize(ps2) == data);
+}
+
+JJ_TEST_CASE(indexed)
+{
+    MAIN ps;
+    propsSerDeser::setSample(ps);
+    std::string data(propsBinary::serialize(ps));
+    MAIN ps2;
+    pathIndex_t<myprops> index(ps2);
+    binaryDeserializer_t<myprops> des(data.data(), data.size(), index);
+    JJ_TEST(propsSerDeser::isSample(ps2));
+}
+
+JJ_TEST_CASE(samekey_differenttypes)
+{
+    propsIndex::APPLY ps;
+    ps.X.numA = -8;
+    ps.X.flA = 0.25;
+    ps.X.lsA = { jjT("gamma") };
+    std::string data(propsBinary::serialize(ps));
+    propsIndex::APPLY ps2;
+    binaryDeserializer_t<myprops> des(data.data(), data.size(), ps2);
+    JJ_TEST(ps2.X.numA == -8);
+    JJ_TEST(ps2.X.flA == 0.25);
+    JJ_TEST(ps2.X.lsA == std::list<jj::string_t>{ jjT("gamma") });
+}
+
+JJ_TEST_CASE(othertypes_skipped)
+{
+    // fore=3 (int) and words=[1] (list of int)
+    std::string data("JJPB\x01" "V\x04" "fore\x02" "i\x06" "V\x05" "words\x04" "l\x01i\x02", 26);
+    LEAF leaf;
+    binaryDeserializer_t<myprops> des1(data.data(), data.size(), leaf);
+    JJ_TEST(leaf.fore.R == 192);
+    MAIN ps;
+    binaryDeserializer_t<myprops> des2(data.data(), data.size(), ps);
+    JJ_TEST(ps.words.size() == 3u);
+}
+
+JJ_TEST_CASE(invalid_throws)
+{
+    MAIN ps;
+    std::string data(propsBinary::serialize(ps));
+    JJ_TEST_THAT_THROWS((binaryDeserializer_t<myprops>("JJPX\x01", 5, ps)), jj::exception::base);
+    JJ_TEST_THAT_THROWS((binaryDeserializer_t<myprops>("JJPB\x02", 5, ps)), jj::exception::base);
+    JJ_TEST_THAT_THROWS((binaryDeserializer_t<myprops>(data.data(), data.size() - 1, ps)), jj::exception::base);
+    JJ_TEST_THAT_THROWS((binaryDeserializer_t<myprops>("JJPB\x01X", 6, ps)), jj::exception::base);
+    JJ_TEST_THAT_THROWS((binaryDeserializer_t<myprops>("JJPB\x01N\x02\x01" "1", 9, ps)), jj::exception::base);
+    JJ_TEST_THAT_THROWS((binaryDeserializer_t<myprops>("JJPB\x01N\x01\x01" "3", 9, ps)), jj::props::exception::keyNotFound);
+}
+
+JJ_TEST_CASE(containers)
+{
+    propsSerDeser::CONTAINERS ps;
+    ps.ints.assign(1000, -5);
+    ps.big = { std::numeric_limits<unsigned long long>::max() };
+    std::string data;
+    binarySerializer_t ser(data);
+    traversalContext_t<const jj::char_t*> ctx;
+    ps.traverse(ser, ctx);
+
+    propsSerDeser::CONTAINERS ps2;
+    ps2.words.clear();
+    ps2.triple.fill(0);
+    binaryDeserializer_t<propsSerDeser::cprops> des(data.data(), data.size(), ps2);
+    JJ_TEST(ps2.ints == ps.ints);
+    JJ_TEST(ps2.words == ps.words);
+    JJ_TEST(ps2.reals == ps.reals);
+    JJ_TEST(ps2.triple == ps.triple);
+    JJ_TEST(ps2.big == ps.big);
+
+    // triple=[1,2] - other number of elements than the array has
+    std::string other("JJPB\x01" "V\x06" "triple\x05" "l\x02i\x02i\x04", 19);
+    binaryDeserializer_t<propsSerDeser::cprops> des2(other.data(), other.size(), ps2);
+    JJ_TEST(ps2.triple == ps.triple);
+}
+
+JJ_TEST_CLASS_END(propsBSerDeserTests_t, basic, indexed, samekey_differenttypes, othertypes_skipped, invalid_throws, containers)
+
+JJ_TEST_CLASS(propsDirtyTests_t)
+
+JJ_TEST_CASE(set_marksdirty)
+{
+    MAIN ps;
+    JJ_TEST(!ps.isDirty());
+    ps.set<int>(jjT("num2"), 5);
+    JJ_TEST(ps.num2 == 5);
+    JJ_TEST(ps.isDirty<int>(jjT("num2")));
+    JJ_TEST(!ps.isDirty<int>(jjT("num1")));
+    JJ_TEST(ps.isDirty());
+    JJ_TEST(!ps.spec1.isDirty());
+    ps.clearDirty();
+    JJ_TEST(!ps.isDirty());
+
+    pathWalker_t<myprops> walk(ps);
+    walk.set<double>(jjT("2/precise"), 1.5);
+    JJ_TEST(ps.spec2.isDirty<double>(jjT("precise")));
+    JJ_TEST(ps.isDirty());
+    JJ_TEST(!ps.spec1.isDirty());
+    ps.clearDirty();
+    JJ_TEST(!ps.spec2.isDirty());
+
+    pathIndex_t<myprops> index(ps);
+    index.set<int>(jjT("num1"), 7);
+    index.set<color_t>(jjT("1/colors/fore"), color_t(4, 5, 6));
+    JJ_TEST(ps.num1 == 7);
+    JJ_TEST(ps.isDirty<int>(jjT("num1")));
+    JJ_TEST(ps.spec1.colors.isDirty<color_t>(jjT("fore")));
+    JJ_TEST(!ps.spec1.colors.isDirty<color_t>(jjT("back")));
+    JJ_TEST(!ps.spec2.isDirty());
+    ps.clearDirty();
+    index.get<double>(jjT("2/precise")) = 2.5;
+    index.markDirty<double>(jjT("2/precise"));
+    JJ_TEST(ps.spec2.isDirty<double>(jjT("precise")));
+    JJ_TEST_THAT_THROWS(index.markDirty<int>(jjT("2/none")), jj::props::exception::keyNotFound);
+}
+
+JJ_TEST_CASE(markdirty)
+{
+    MAIN ps;
+    ps.spec1.colors.fore.B = 1;
+    ps.spec1.colors.markDirty<color_t>(jjT("fore"));
+    JJ_TEST(ps.spec1.colors.isDirty<color_t>(jjT("fore")));
+    JJ_TEST(!ps.spec1.colors.isDirty<color_t>(jjT("back")));
+    JJ_TEST(ps.isDirty());
+    JJ_TEST_THAT_THROWS(ps.markDirty<int>(jjT("none")), jj::props::exception::keyNotFound);
+    JJ_TEST_THAT_THROWS(ps.isDirty<bool>(jjT("num1")), jj::props::exception::keyNotFound);
+}
+
+JJ_TEST_CASE(traversedirty_writespatch)
+{
+    MAIN ps;
+    ps.set<jj::string_t>(jjT("text"), jjT("changed"));
+    ps.spec2.colors.set(jjT("back"), color_t(1, 2, 3));
+    jj::osstream_t str;
+    textSerializer_t<jj::osstream_t> ser(str, 0);
+    traversalContext_t<const jj::char_t*> ctx;
+    ps.traverseDirty(ser, ctx);
+    JJ_TEST(str.str() == jjT("text=\"changed\"\n[2]\n[2/colors]\nback={1,2,3}\n"));
+
+    MAIN ps2;
+    ps2.num1 = 11;
+    jj::isstream_t in(str.str());
+    jj::streamSource_t<jj::isstream_t> src(in);
+    textDeserializer_t<jj::streamSource_t<jj::isstream_t>, myprops> des(src, ps2);
+    JJ_TEST(ps2.text == jjT("changed"));
+    JJ_TEST(ps2.spec2.colors.back.G == 2);
+    JJ_TEST(ps2.num1 == 11);
+    JJ_TEST(!ps2.isDirty());
+}
+
+JJ_TEST_CASE(index_set_writespatch)
+{
+    MAIN ps;
+    pathIndex_t<myprops> index(ps);
+    index.set<double>(jjT("1/precise"), 0.5);
+    index.set<color_t>(jjT("2/colors/back"), color_t(1, 2, 3));
+    jj::osstream_t str;
+    textSerializer_t<jj::osstream_t> ser(str, 0);
+    traversalContext_t<const jj::char_t*> ctx;
+    ps.traverseDirty(ser, ctx);
+    JJ_TEST(str.str() == jjT("[1]\nprecise=0.5\n[2]\n[2/colors]\nback={1,2,3}\n"));
+}
+
+JJ_TEST_CASE(binary_patches)
+{
+    MAIN ps;
+    std::string data(propsBinary::serialize(ps));
+    ps.set(jjT("num1"), 21);
+    ps.spec1.set(jjT("numbers"), std::list<int>{ 4 });
+    traversalContext_t<const jj::char_t*> ctx;
+    size_t full = data.size();
+    {
+        binarySerializer_t ser(data);
+        ps.traverseDirty(ser, ctx);
+    }
+    ps.clearDirty();
+    ps.set(jjT("num1"), 22);
+    {
+        binarySerializer_t ser(data);
+        ps.traverseDirty(ser, ctx);
+    }
+    JJ_TEST(data.size() - full < 50u);
+
+    MAIN ps2;
+    binaryDeserializer_t<myprops> des(data.data(), data.size(), ps2);
+    JJ_TEST(ps2.num1 == 22);
+    JJ_TEST(ps2.spec1.numbers == std::list<int>{ 4 });
+    JJ_TEST(propsSerDeser::text(ps2) == propsSerDeser::text(ps));
+    JJ_TEST_THAT_THROWS((binaryDeserializer_t<myprops>("JJPB\x01JJPX\x01", 10, ps2)), jj::exception::base);
+}
+
+JJ_TEST_CLASS_END(propsDirtyTests_t, set_marksdirty, markdirty, traversedirty_writespatch, index_set_writespatch, binary_patches)
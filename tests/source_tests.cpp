@@ -1,6 +1,9 @@
 #include "jj/source.h"
 #include "jj/test/test.h"
+#include "tempFile_tests.h"
 #include <sstream>
+#include <fstream>
+#include <cstdio>
 
 JJ_TEST_CLASS(streamSourceTests_t)
 
@@ -146,3 +149,178 @@ JJ_TEST_CASE(wstream_takenbyreference)
 
 JJ_TEST_CLASS_END(streamSourceTests_t, emptystream_alwaysreturnfalse, wemptystream_alwaysreturnfalse, simplepeekgetunget, wsimplepeekgetunget, ungetatend_staysend, wungetatend_staysend, \
     ungetatstart_noeffect, wungetatstart_noeffect, stream_takenbyreference, wstream_takenbyreference)
+
+JJ_TEST_CLASS(bufferSourceTests_t)
+
+JJ_TEST_CASE(empty_alwaysreturnfalse)
+{
+    jj::bufferSource_t<char> src(nullptr, nullptr);
+    char ch;
+    JJ_TEST(!src.peek(ch));
+    JJ_TEST(!src.get(ch));
+    src.unget();
+    JJ_TEST(!src.get(ch));
+}
+
+JJ_TEST_CASE(peekgetunget)
+{
+    std::wstring text(L"123");
+    jj::bufferSource_t<wchar_t> src(text.data(), text.data() + text.length());
+    wchar_t ch;
+    src.unget();
+    JJ_TEST(src.peek(ch) && ch == L'1');
+    JJ_TEST(src.get(ch) && ch == L'1');
+    src.unget();
+    JJ_TEST(src.get(ch) && ch == L'1');
+    JJ_TEST(src.get(ch) && ch == L'2');
+    JJ_TEST(src.position() == text.data() + 2);
+    JJ_TEST(src.get(ch) && ch == L'3');
+    JJ_TEST(!src.peek(ch));
+    JJ_TEST(!src.get(ch));
+    src.unget();
+    JJ_TEST(src.get(ch) && ch == L'3');
+    src.seek(text.data());
+    JJ_TEST(src.get(ch) && ch == L'1');
+}
+
+JJ_TEST_CASE(stream_sharesposition)
+{
+    std::string text("12 abc 3.5");
+    jj::bufferSource_t<char> src(text.data(), text.data() + text.length());
+    int i = 0;
+    src.stream() >> i;
+    JJ_TEST(i == 12);
+    char ch;
+    JJ_TEST(src.get(ch) && ch == ' ');
+    JJ_TEST(src.get(ch) && ch == 'a');
+    src.seek(src.position() + 3);
+    double d = 0;
+    src.stream() >> d;
+    JJ_TEST(d == 3.5);
+    JJ_TEST(!src.get(ch));
+}
+
+JJ_TEST_CASE(file)
+{
+    jj::string_t path(tempPath(jjT("jjsource_file.txt")));
+    {
+        std::ofstream out(path.c_str(), std::ios::binary);
+        out << "line 1\nline 2\n";
+    }
+    {
+        jj::fileSource_t src(path);
+        JJ_TEST(std::string(src.position(), src.end()) == "line 1\nline 2\n");
+        std::string word;
+        src.stream() >> word;
+        JJ_TEST(word == "line");
+        char ch;
+        JJ_TEST(src.get(ch) && ch == ' ');
+    }
+    {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    }
+    {
+        jj::fileSource_t src(path);
+        char ch;
+        JJ_TEST(!src.get(ch));
+    }
+    remove(jj::strcvt::to_string(path).c_str());
+    JJ_TEST_THAT_THROWS(jj::fileSource_t src(path), jj::exception::base);
+}
+
+JJ_TEST_CASE(location)
+{
+    std::string text("ab\n\ncd\n");
+    jj::bufferSource_t<char> src(text.data(), text.data() + text.length());
+    JJ_TEST(src.location().Line == 1 && src.location().Column == 1);
+    char ch;
+    src.get(ch);
+    src.get(ch);
+    JJ_TEST(src.location().Line == 1 && src.location().Column == 3);
+    src.get(ch);
+    src.get(ch);
+    src.get(ch);
+    JJ_TEST(src.location().Line == 3 && src.location().Column == 2);
+    src.unget();
+    src.unget();
+    JJ_TEST(src.location().Line == 2 && src.location().Column == 1);
+    src.seek(src.end());
+    JJ_TEST(src.location().Line == 4 && src.location().Column == 1);
+}
+
+JJ_TEST_CLASS_END(bufferSourceTests_t, empty_alwaysreturnfalse, peekgetunget, stream_sharesposition, file, location)
+
+JJ_TEST_CLASS(chunkedSourceTests_t)
+
+JJ_TEST_CASE(empty_alwaysreturnfalse)
+{
+    std::stringstream str("");
+    jj::chunkedSource_t<std::stringstream> src(str);
+    char ch;
+    JJ_TEST(!src.peek(ch));
+    JJ_TEST(!src.get(ch));
+    src.unget();
+    JJ_TEST(!src.get(ch));
+}
+
+JJ_TEST_CASE(acrosschunks)
+{
+    std::wstringstream str(L"12345");
+    jj::chunkedSource_t<std::wstringstream> src(str, 2);
+    wchar_t ch;
+    JJ_TEST(src.peek(ch) && ch == L'1');
+    JJ_TEST(src.get(ch) && ch == L'1');
+    JJ_TEST(src.get(ch) && ch == L'2');
+    JJ_TEST(src.get(ch) && ch == L'3');
+    src.unget();
+    JJ_TEST(src.get(ch) && ch == L'3');
+    JJ_TEST(src.get(ch) && ch == L'4');
+    JJ_TEST(src.peek(ch) && ch == L'5');
+    src.unget();
+    JJ_TEST(src.get(ch) && ch == L'4');
+    JJ_TEST(src.get(ch) && ch == L'5');
+    JJ_TEST(!src.peek(ch));
+    JJ_TEST(!src.get(ch));
+    src.unget();
+    JJ_TEST(src.get(ch) && ch == L'5');
+    JJ_TEST(!src.get(ch));
+}
+
+JJ_TEST_CASE(stream_sharesposition)
+{
+    std::stringstream str("12345 abc 3.5");
+    jj::chunkedSource_t<std::stringstream> src(str, 3);
+    int i = 0;
+    src.stream() >> i;
+    JJ_TEST(i == 12345);
+    char ch;
+    JJ_TEST(src.get(ch) && ch == ' ');
+    std::string word;
+    src.stream() >> word;
+    JJ_TEST(word == "abc");
+    double d = 0;
+    src.stream() >> d;
+    JJ_TEST(d == 3.5);
+    JJ_TEST(!src.get(ch));
+}
+
+JJ_TEST_CASE(location)
+{
+    std::stringstream str("ab\n\ncd\nefgh");
+    jj::chunkedSource_t<std::stringstream> src(str, 2);
+    char ch;
+    JJ_TEST(src.location().Line == 1 && src.location().Column == 1);
+    src.get(ch);
+    src.get(ch);
+    src.get(ch);
+    JJ_TEST(src.location().Line == 2 && src.location().Column == 1);
+    src.get(ch);
+    src.get(ch);
+    src.unget();
+    JJ_TEST(src.location().Line == 3 && src.location().Column == 1);
+    while (src.get(ch))
+        ;
+    JJ_TEST(src.location().Line == 4 && src.location().Column == 5);
+}
+
+JJ_TEST_CLASS_END(chunkedSourceTests_t, empty_alwaysreturnfalse, acrosschunks, stream_sharesposition, location)
@@ -0,0 +1,29 @@
+#ifndef JJ_TESTS_TEMPFILE_H
+#define JJ_TESTS_TEMPFILE_H
+
+#include "jj/string.h"
+#include <cstdlib>
+#include <string>
+#if defined(JJ_OS_WINDOWS)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+/*! Returns the path of a temporary file of the tests - the name in the temporary directory (TEMP on Windows, TMPDIR or
+/tmp elsewhere), prefixed by the process id so that the test programs running at the same time do not collide. */
+inline jj::string_t tempPath(const jj::string_t& name)
+{
+#if defined(JJ_OS_WINDOWS)
+    const wchar_t* dir = _wgetenv(L"TEMP");
+    jj::string_t ret(dir != nullptr ? jj::strcvt::to_string_t(dir) + jjT("\\") : jj::string_t());
+    unsigned long pid = static_cast<unsigned long>(_getpid());
+#else
+    const char* dir = std::getenv("TMPDIR");
+    jj::string_t ret(jj::strcvt::to_string_t(dir != nullptr && *dir != 0 ? dir : "/tmp") + jjT("/"));
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    return ret + jj::strcvt::to_string_t(std::to_string(pid)) + jjT('_') + name;
+}
+
+#endif // JJ_TESTS_TEMPFILE_H
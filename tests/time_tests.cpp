@@ -1,5 +1,6 @@
 #include "jj/time.h"
 #include "jj/test/test.h"
+#include <sstream>
 #ifdef JJ_OS_WINDOWS
 #include <Windows.h>
 #endif
@@ -371,6 +372,44 @@ JJ_TEST_CASE_VARIANTS(stamp_dates_negative, (long long ticks, int Y, int M, int
 #endif
 }
 
+template<typename CH, typename CLOCK>
+void formattertest(jj::time::stampFormatter_t<CH>& f, jj::time::stamp_t::type_t type)
+{
+    std::basic_ostringstream<CH> exp;
+    exp << jj::time::stamp_t(CLOCK::now(), type);
+    CH buf[jj::time::stampFormatter_t<CH>::MAX_LENGTH];
+    std::basic_string<CH> got(buf, f.format(CLOCK::now(), buf, type));
+    JJ_TEST(got == exp.str(), jjOOO(jj::strcvt::to_string_t(got),==,jj::strcvt::to_string_t(exp.str())));
+}
+
+JJ_TEST_CASE_VARIANTS(stamp_formatter, (long long start, jj::time::stamp_t::type_t type), \
+    (0ll, jj::time::stamp_t::UTC), \
+    (1078077963000000000ll, jj::time::stamp_t::UTC), \
+    (1078077963000000000ll, jj::time::stamp_t::LOCAL), \
+    (-2180177267000000000ll, jj::time::stamp_t::UTC))
+{
+    typedef fake_clock<> clock;
+    jj::time::stampFormatter_t<char> f;
+    jj::time::stampFormatter_t<wchar_t> wf;
+    const long long steps[] = { 0ll, 1ll, 7ll, 120ll, 123456789ll, 999999999ll, 1000000000ll, 1000000005ll, 5ll, 61000000000ll, 86400000000000ll };
+    for (long long step : steps)
+    {
+        clock::Ticks = start + step;
+        formattertest<char, clock>(f, type);
+        formattertest<wchar_t, clock>(wf, type);
+        formattertest<char, clock>(f, type == jj::time::stamp_t::UTC ? jj::time::stamp_t::LOCAL : jj::time::stamp_t::UTC);
+    }
+}
+
+JJ_TEST_CASE(stamp_formatter_thread)
+{
+    typedef fake_clock<> clock;
+    clock::Ticks = 946684799123ll;
+    formattertest<char, clock>(jj::time::threadStampFormatter<char>(), jj::time::stamp_t::LOCAL);
+    clock::Ticks += 1000000000ll;
+    formattertest<char, clock>(jj::time::threadStampFormatter<char>(), jj::time::stamp_t::LOCAL);
+}
 
 JJ_TEST_CLASS_END(timeFakeTests_t, momentZero, moment_resolution_1000th, moment_resolution_10Mth, moment_resolution_100sec, \
-    stampZero, stamp_resolution_1000th, stamp_resolution_10Mth, stamp_resolution_100sec, stamp_dates, stamp_dates_negative)
+    stampZero, stamp_resolution_1000th, stamp_resolution_10Mth, stamp_resolution_100sec, stamp_dates, stamp_dates_negative, \
+    stamp_formatter, stamp_formatter_thread)
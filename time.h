@@ -8,6 +8,7 @@
 #include <time.h>
 #include <iosfwd>
 #include <iomanip>
+#include <string>
 
 namespace jj
 {
@@ -20,8 +21,10 @@ See also jj::time::now() and jj::time::moment_t. */
 class stamp_t
 {
     bool valid_; //!< set to true only after all other members are successfully parsed and set in ctor
+public:
     typedef std::intmax_t ticks_t; //!< a "large" ordinal type to hold number of ns
     typedef int small_t; //!< a "small" ordinal type to hold date and time info
+private:
     ticks_t ticks_; //!< number of ns since epoch (beginning of January 1st, 1970)
     small_t year_, //!< year (full, eg. 1989 or 2013)
         month_, //!< month (starts at 1=January, through 12=December)
@@ -51,14 +54,9 @@ public:
         : valid_(false), ticks_(0), year_(-1), month_(-1), day_(-1), yday_(-1), wday_(-1), hour_(-1), min_(-1), sec_(-1), ns_(-1), offsec_(0)
     {
         // first split into seconds and fraction
-        static_assert(std::is_same<typename T::rep, typename D::rep>::value, "Clock T and duration D must have same representation types.");
-        typedef typename D::rep rep_t;
-        typedef typename D::period per_t;
-        static_assert(per_t::den > 0, "Weird clock.");
         static const std::intmax_t ns = 1000000000ll;
-        typedef std::ratio<ns, per_t::den> ns_t;
-        ticks_ = t.time_since_epoch().count() * per_t::num * ns_t::num / ns_t::den;
-        rep_t ts = ticks_ / ns;
+        ticks_ = toTicks(t);
+        typename D::rep ts = ticks_ / ns;
 
         // convert the seconds part
         time_t tt(ts);
@@ -102,6 +100,17 @@ public:
         valid_ = true;
     }
 
+    /*! Returns the number of nanoseconds since epoch of the given time_point. */
+    template<typename T, typename D>
+    static ticks_t toTicks(std::chrono::time_point<T, D> t)
+    {
+        static_assert(std::is_same<typename T::rep, typename D::rep>::value, "Clock T and duration D must have same representation types.");
+        typedef typename D::period per_t;
+        static_assert(per_t::den > 0, "Weird clock.");
+        typedef std::ratio<1000000000ll, per_t::den> ns_t;
+        return t.time_since_epoch().count() * per_t::num * ns_t::num / ns_t::den;
+    }
+
     /*! Returns true if all other member methods return valid values (if all members could be parsed from
     the ctor parameter), false otherwise. If false is returned none of the values returned by other member
     methods can't be trusted. */
@@ -150,6 +159,101 @@ public:
 template<typename CLOCK = std::chrono::system_clock>
 stamp_t now(stamp_t::type_t type = stamp_t::LOCAL) { return stamp_t(CLOCK::now(), type); }
 
+/*! Renders time_points as text in exactly the same layout as the operator<< of stamp_t, but remembers the
+rendered date and time (and timezone) of the last second, so the conversion (localtime) and the formatting
+is only done once per second - the following time_points within the same second only render the fraction.
+The result is written directly into a character buffer.
+The object is not thread-safe, use one per thread (see threadStampFormatter()). */
+template<typename CH>
+class stampFormatter_t
+{
+public:
+    static const size_t MAX_LENGTH = 64; //!< the minimal size of the buffer passed to format()
+
+private:
+    typedef jj::str::literals_t<CH> lit_t;
+    static const size_t PART_LENGTH = 32; //!< the size of the cached parts
+
+    bool cached_; //!< set if the members below describe a valid stamp
+    stamp_t::type_t type_; //!< the type of the cached stamp
+    stamp_t::ticks_t second_; //!< the second (since epoch) of the cached stamp
+    CH prefix_[PART_LENGTH]; //!< the date and time up to the fraction separator
+    size_t prefixLength_; //!< the number of characters in prefix_
+    CH suffix_[PART_LENGTH]; //!< the timezone offset
+    size_t suffixLength_; //!< the number of characters in suffix_
+
+    /*! Writes the number into out, left-padded by zeroes to width characters (same as setfill('0') << setw(width)
+    would do). Returns the number of written characters. */
+    static size_t put(CH* out, stamp_t::ticks_t v, size_t width)
+    {
+        CH tmp[24];
+        size_t n = 0;
+        unsigned long long u = (v < 0 ? 0ull - static_cast<unsigned long long>(v) : static_cast<unsigned long long>(v));
+        do
+        {
+            tmp[n++] = static_cast<CH>(lit_t::d0 + u % 10);
+            u /= 10;
+        } while (u != 0);
+        if (v < 0)
+            tmp[n++] = lit_t::MINUS;
+        size_t len = 0;
+        for (; len + n < width; ++len)
+            out[len] = lit_t::d0;
+        while (n > 0)
+            out[len++] = tmp[--n];
+        return len;
+    }
+
+public:
+    /*! Ctor */
+    stampFormatter_t() : cached_(false), type_(stamp_t::LOCAL), second_(0), prefixLength_(0), suffixLength_(0) {}
+
+    /*! Writes the time_point as local or UTC time into out (which must hold at least MAX_LENGTH characters).
+    The output is not 0-terminated, the number of written characters is returned. */
+    template<typename T, typename D>
+    size_t format(std::chrono::time_point<T, D> t, CH* out, stamp_t::type_t type = stamp_t::LOCAL)
+    {
+        static const stamp_t::ticks_t ns = 1000000000ll;
+        stamp_t::ticks_t ticks = stamp_t::toTicks(t), fraction = ticks % ns;
+        if (!cached_ || type != type_ || ticks / ns != second_)
+        {
+            stamp_t s(t, type);
+            CH* p = prefix_;
+            p += put(p, s.year(), 4);
+            p += put(p, s.month(), 2);
+            p += put(p, s.day(), 2);
+            *p++ = lit_t::T;
+            p += put(p, s.hour(), 2);
+            p += put(p, s.minute(), 2);
+            p += put(p, s.second(), 2);
+            *p++ = lit_t::DOT;
+            prefixLength_ = p - prefix_;
+            p = suffix_;
+            *p++ = (s.offsetDirection() < 0 ? lit_t::MINUS : lit_t::PLUS);
+            p += put(p, s.offsetHours(), 2);
+            p += put(p, s.offsetMinutes(), 2);
+            suffixLength_ = p - suffix_;
+            cached_ = s.isValid();
+            type_ = type;
+            second_ = ticks / ns;
+            fraction = s.nanosecond();
+        }
+        std::char_traits<CH>::copy(out, prefix_, prefixLength_);
+        size_t len = prefixLength_;
+        len += put(out + len, fraction, 2);
+        std::char_traits<CH>::copy(out + len, suffix_, suffixLength_);
+        return len + suffixLength_;
+    }
+};
+
+/*! Returns the stampFormatter_t of the calling thread. */
+template<typename CH>
+stampFormatter_t<CH>& threadStampFormatter()
+{
+    static thread_local stampFormatter_t<CH> formatter;
+    return formatter;
+}
+
 /*! Converts the clock (usually std::chrono::steady_clock) to a structure where user can
 directly access days, hours, ..., nanoseconds.
 See also jj::time::uptime(). */
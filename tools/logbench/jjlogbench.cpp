@@ -0,0 +1,188 @@
+#include "jj/log.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+/*! Measures the cost of the log statements (ns per statement) in various situations - disabled levels, enabled levels
+with different message arguments delivered to a target doing nothing, scopes and several threads logging at once, in the
+synchronous and the asynchronous mode and with the deferred formatting (see jjlogbenchDeferred.cpp).
+Build with BUILD_MODE=release for meaningful numbers. */
+
+JJ_LOGGER_INITIALIZER(, )
+
+// in jjlogbenchDeferred.cpp, built with JJ_LOG_DEFERRED_FORMAT
+void deferredInt(size_t n);
+void deferredMix(size_t n);
+
+namespace
+{
+/*! A target ignoring the messages, so only the cost of the logging itself is measured. */
+class nullTarget_t : public jj::log::logTarget_base_t
+{
+public:
+    virtual void log(const jj::log::message_t&) override {}
+};
+
+/*! The settings from the command line. */
+struct options_t
+{
+    size_t Iterations = 1000000; //!< the number of statements per benchmark
+    unsigned Threads = 4; //!< the number of threads in the contention benchmarks
+    std::vector<std::string> Filters; //!< only the benchmarks containing any of these in their name are run
+};
+
+/*! A single benchmark. */
+struct benchmark_t
+{
+    const char* Name; //!< the name (for the output and the filters)
+    jj::log::level_t Level; //!< the soft limit set during the benchmark
+    bool Threaded; //!< whether to run the body on options_t::Threads threads at once
+    bool Async; //!< whether to run the body in the asynchronous mode (see logger_t::startAsync())
+    void (*Body)(size_t iterations); //!< performs the given number of log statements
+};
+
+void scopeBody()
+{
+    jjLscope(jjT("arg"));
+}
+
+void disabledInfo(size_t n) { for (size_t i = 0; i < n; ++i) jjLI(jjT("value ") << i); }
+void disabledDebug(size_t n) { for (size_t i = 0; i < n; ++i) { jjLD(jjT("value ") << i); } }
+void enabledLiteral(size_t n) { for (size_t i = 0; i < n; ++i) jjLI(jjT("a constant message")); }
+void enabledInt(size_t n) { for (size_t i = 0; i < n; ++i) jjLI(jjT("value ") << i); }
+void enabledMix(size_t n)
+{
+    const jj::string_t s(jjT("some string"));
+    for (size_t i = 0; i < n; ++i)
+        jjLI(jjT("int ") << i << jjT(" double ") << 3.14159 * static_cast<double>(i) << jjT(" string ") << s << jjT(" char ") << jjT('x'));
+}
+void enabledLong(size_t n)
+{
+    const jj::string_t s(300, jjT('x'));
+    for (size_t i = 0; i < n; ++i)
+        jjLI(s << i);
+}
+void scope(size_t n) { for (size_t i = 0; i < n; ++i) scopeBody(); }
+void loggerLog(size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        jj::log::logger_t::instance().log(jj::log::message_t(jj::log::clock_t::now(), JJ_LOGLEVEL_INFO, jj::log::logger_t::NAME_INFO, jjT("direct"), JJ_FUNC, __FILE__, __LINE__, jjTheLogComponent));
+}
+
+const benchmark_t BENCHMARKS[] = {
+    { "disabled/jjLI", JJ_LOGLEVEL_WARNING, false, false, &disabledInfo },
+    { "disabled/jjLD", JJ_LOGLEVEL_INFO, false, false, &disabledDebug },
+    { "disabled/jjLscope", JJ_LOGLEVEL_INFO, false, false, &scope },
+    { "enabled/jjLI-literal", JJ_LOGLEVEL_INFO, false, false, &enabledLiteral },
+    { "enabled/jjLI-int", JJ_LOGLEVEL_INFO, false, false, &enabledInt },
+    { "enabled/jjLI-mix", JJ_LOGLEVEL_INFO, false, false, &enabledMix },
+    { "enabled/jjLI-long", JJ_LOGLEVEL_INFO, false, false, &enabledLong },
+    { "enabled/jjLscope", JJ_LOGLEVEL_SCOPE, false, false, &scope },
+    { "enabled/logger_t::log", JJ_LOGLEVEL_INFO, false, false, &loggerLog },
+    { "enabled/jjLI-int-deferred", JJ_LOGLEVEL_INFO, false, false, &deferredInt },
+    { "enabled/jjLI-mix-deferred", JJ_LOGLEVEL_INFO, false, false, &deferredMix },
+    { "async/jjLI-int", JJ_LOGLEVEL_INFO, false, true, &enabledInt },
+    { "async/jjLI-mix", JJ_LOGLEVEL_INFO, false, true, &enabledMix },
+    { "async/jjLI-mix-deferred", JJ_LOGLEVEL_INFO, false, true, &deferredMix },
+    { "threads/disabled/jjLI", JJ_LOGLEVEL_WARNING, true, false, &disabledInfo },
+    { "threads/enabled/jjLI-int", JJ_LOGLEVEL_INFO, true, false, &enabledInt },
+    { "threads/enabled/logger_t::log", JJ_LOGLEVEL_INFO, true, false, &loggerLog },
+    { "threads/async/jjLI-int", JJ_LOGLEVEL_INFO, true, true, &enabledInt },
+};
+
+/*! Returns whether the benchmark passes the filters. */
+bool selected(const options_t& opts, const benchmark_t& b)
+{
+    if (opts.Filters.empty())
+        return true;
+    for (auto& f : opts.Filters)
+        if (strstr(b.Name, f.c_str()) != nullptr)
+            return true;
+    return false;
+}
+
+/*! Runs the benchmark, returns the time per statement (in ns, per thread in the threaded benchmarks). In the
+asynchronous mode only the logging threads are timed, the queue is drained afterwards. */
+double run(const options_t& opts, const benchmark_t& b)
+{
+    jj::log::logger_t::instance().setLevel(b.Level);
+    if (b.Async)
+        jj::log::logger_t::instance().startAsync();
+    b.Body(opts.Iterations / 10 + 1); // warm up
+    jj::log::logger_t::instance().flush();
+    auto start = std::chrono::steady_clock::now();
+    unsigned threads = b.Threaded ? opts.Threads : 1;
+    if (b.Threaded)
+    {
+        std::vector<std::thread> ths;
+        for (unsigned t = 0; t < threads; ++t)
+            ths.push_back(std::thread([&opts, &b]() { b.Body(opts.Iterations); }));
+        for (auto& t : ths)
+            t.join();
+    }
+    else
+    {
+        b.Body(opts.Iterations);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (b.Async)
+        jj::log::logger_t::instance().stopAsync();
+    return static_cast<double>(ns) / static_cast<double>(opts.Iterations);
+}
+} // namespace <anonymous>
+
+int main(int argc, const char** argv)
+{
+    options_t opts;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            std::cout << "Usage: " << argv[0] << " [-n iterations] [-t threads] [-l] [filter...]" << std::endl
+                << "Measures the cost of the log statements in ns per statement (in the threads/ benchmarks each thread" << std::endl
+                << "performs the given number of statements and the time is per statement of a thread)." << std::endl
+                << "Only the benchmarks whose name contains any of the filters are run, -l lists the names." << std::endl;
+            return 0;
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+        {
+            for (auto& b : BENCHMARKS)
+                std::cout << b.Name << std::endl;
+            return 0;
+        }
+        else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "-t") == 0) && i + 1 < argc)
+        {
+            long v = atol(argv[i + 1]);
+            if (v <= 0)
+            {
+                std::cerr << "Invalid value of " << argv[i] << "." << std::endl;
+                return 1;
+            }
+            if (argv[i][1] == 'n')
+                opts.Iterations = static_cast<size_t>(v);
+            else
+                opts.Threads = static_cast<unsigned>(v);
+            ++i;
+        }
+        else
+        {
+            opts.Filters.push_back(argv[i]);
+        }
+    }
+
+    jj::log::logger_t::instance().replaceTargets(std::make_shared<nullTarget_t>());
+    printf("%-32s %12s\n", "benchmark", "ns/op");
+    for (auto& b : BENCHMARKS)
+    {
+        if (!selected(opts, b))
+            continue;
+        printf("%-32s %12.1f\n", b.Name, run(opts, b));
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+/*! The benchmarks of jjlogbench.cpp with the deferred formatting of the messages - the streamed values are only
+recorded by the log statements and formatted when delivered (on the consumer thread in the asynchronous mode). */
+#define JJ_LOG_DEFERRED_FORMAT 1
+#include "jj/log.h"
+
+void deferredInt(size_t n) { for (size_t i = 0; i < n; ++i) jjLI(jjT("value ") << i); }
+void deferredMix(size_t n)
+{
+    const jj::string_t s(jjT("some string"));
+    for (size_t i = 0; i < n; ++i)
+        jjLI(jjT("int ") << i << jjT(" double ") << 3.14159 * static_cast<double>(i) << jjT(" string ") << s << jjT(" char ") << jjT('x'));
+}
@@ -0,0 +1,60 @@
+#include "jj/logBinary.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+/*! Converts the binary logs (see jj/logBinary.h) given on the command line (or stdin if none) into the text
+layout and prints them to stdout. */
+
+JJ_LOGGER_DEFAULTINIT
+
+namespace
+{
+/*! Decodes all messages from the stream and prints them, returns false on error. */
+bool decode(std::istream& in, const char* name)
+{
+    jj::log::binaryDecoder_t decoder(in);
+    jj::log::decodedMessage_t msg;
+    try
+    {
+        while (decoder.next(msg))
+            jj::log::binaryDecoder_t::render(std::cout, msg);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << name << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+} // namespace <anonymous>
+
+int main(int argc, const char** argv)
+{
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))
+    {
+        std::cout << "Usage: " << argv[0] << " [file...]" << std::endl
+            << "Prints the binary logs in text form, reads stdin if no file is given." << std::endl;
+        return 0;
+    }
+    int ret = 0;
+    if (argc < 2)
+    {
+        std::cin.sync_with_stdio(false);
+        if (!decode(std::cin, "<stdin>"))
+            ret = 1;
+    }
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream in(argv[i], std::ios::in | std::ios::binary);
+        if (!in)
+        {
+            std::cerr << argv[i] << ": Cannot open file." << std::endl;
+            ret = 1;
+            continue;
+        }
+        if (!decode(in, argv[i]))
+            ret = 1;
+    }
+    return ret;
+}